@@ -3,19 +3,64 @@
 
 #include "exceptions.hpp"
 #include "vn_instruction.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
 namespace cereka {
 
+namespace scenario {
+class Bytecode;
+class ProgramAnalysis;
+}
+
 struct CerekaEvent {
-    enum Type { Quit, KeyDown, MouseDown, Unknown };
+    enum Type { Quit, KeyDown, MouseDown, MouseUp, MouseMove, MouseWheel, Unknown };
     Type type = Unknown;
     int key = 0;
     float mouseX = 0.f;
     float mouseY = 0.f;
+    float wheel = 0.f;  // MouseWheel: positive scrolls up
 };
 
 enum class CerekaState { Running, WaitingForInput, InMenu, Finished };
 
+/**
+ * Fast-forward. Read skips only lines already shown in this or an earlier
+ * session (see SetReadHistoryPath); All skips everything up to the next menu.
+ */
+enum class SkipMode { Off, Read, All };
+
+/**
+ * Cumulative engine counters. Diff two snapshots to get per-frame numbers.
+ */
+struct CerekaStats {
+    uint64_t glyphHits = 0;
+    uint64_t glyphMisses = 0;
+    uint64_t prefetchHits = 0;
+    uint64_t prefetchMisses = 0;
+    uint64_t textureResidentBytes = 0;  // live value, not cumulative
+    uint64_t textureHits = 0;
+    uint64_t textureMisses = 0;
+    uint64_t textureEvictions = 0;
+    uint64_t textureUploads = 0;  // images and glyphs sent to the GPU
+    uint64_t prescaledImages = 0;     // images shrunk to their draw size on load
+    uint64_t prescaleSavedBytes = 0;  // VRAM those would have taken at full size
+    uint64_t soundHits = 0;            // sound effects played from the decoded cache
+    uint64_t soundMisses = 0;          // sound effects decoded on first play
+    uint64_t voicePrefetchHits = 0;    // voice lines decoded ahead of their line
+    uint64_t voicePrefetchMisses = 0;  // voice lines streamed instead
+    uint64_t sceneRedraws = 0;   // background + characters re-rendered into their cache
+    uint64_t redrawnPixels = 0;  // frame pixels recomposited (dirty rectangles)
+    uint64_t drawCalls = 0;        // batched SDL_RenderGeometry calls
+    uint64_t textureSwitches = 0;  // draw calls that bound a different texture
+    uint64_t scriptResumes = 0;    // Lua coroutine resumes (one per line or choice)
+    uint64_t scriptResumeNs = 0;   // time spent running Lua between yields
+    uint64_t scriptMaxResumeNs = 0;
+    uint64_t scriptReloads = 0;  // programs swapped in by hot reload
+    uint64_t assetReloads = 0;   // cached textures replaced by hot reload
+    uint64_t lastReloadNs = 0;   // time the last hot reload took
+};
+
 class CerekaEngine {
    public:
     CerekaEngine();
@@ -27,13 +72,99 @@ class CerekaEngine {
                   bool fullscreen = false);
     void ShutDown();
 
+    /**
+     * Return the next input event, if one is queued. Window and other SDL
+     * events the engine does not expose are consumed, not returned.
+     */
     bool PollEvent(CerekaEvent &e);
+
+    /**
+     * Idle-aware replacement for PollEvent(). Returns true with the next
+     * input event, or false once it is time to produce a frame. While nothing
+     * animates and nothing needs redrawing it blocks until input arrives;
+     * otherwise it waits no longer than the frame cap allows:
+     *
+     *   while (running) {
+     *       while (engine.WaitEvent(e))
+     *           engine.HandleEvent(e);
+     *       engine.TickScript();
+     *       engine.Update(dt);
+     *       if (engine.NeedsPresent()) {
+     *           engine.Draw();
+     *           engine.Present();
+     *       }
+     *   }
+     */
+    bool WaitEvent(CerekaEvent &e);
+
+    /**
+     * True if the next Draw() would differ from the last presented frame, or
+     * something (script, typewriter, skip mode) is still animating.
+     */
+    bool NeedsPresent() const;
+    bool IsAnimating() const;
+
+    /**
+     * Limit WaitEvent() to `fps` frames per second while animating. Zero
+     * (the default) leaves pacing to vsync.
+     */
+    void SetFrameCap(int fps);
+
     void Present();
 
     int Width() const;
     int Height() const;
+    /**
+     * Build and run a compiled script. Throws engine::error, leaving the
+     * current script in place, if it fails validation (unknown labels,
+     * empty menus; see scenario::ProgramAnalysis).
+     */
     void LoadCompiledScript(const std::vector<scenario::Instruction> &compiled);
+
+    /**
+     * Map a compiled .crkb script (see scenario::WriteBytecode) and run it
+     * in place. Throws engine::error if the file is missing, malformed or
+     * fails validation.
+     */
+    void LoadBytecode(const std::string &path);
+
+    /**
+     * Run an already built program image. Images are immutable, so several
+     * engines can share one without copying it. Throws engine::error if it
+     * fails validation.
+     */
+    void LoadProgram(std::shared_ptr<const scenario::Bytecode> program);
+    std::shared_ptr<const scenario::Bytecode> Program() const;
+
+    /**
+     * Control-flow analysis of the loaded program: menu tables, basic
+     * blocks and the assets reachable from any instruction.
+     */
+    std::shared_ptr<const scenario::ProgramAnalysis> Analysis() const;
+
+    /**
+     * Development mode: compile and run `scriptFiles` (linked in order, as
+     * by scenario::ProjectCompiler), then watch them and the asset root.
+     * An edited script is recompiled, reusing the cached build of the
+     * others, and swapped in between frames (when PollEvent() runs out of
+     * events, or inside WaitEvent()), continuing at the same line (found
+     * through the nearest label). Edited images are reloaded in
+     * place. A script that no longer compiles is reported and the running
+     * one kept. Throws engine::error if the initial build fails.
+     */
+    void EnableHotReload(const std::vector<std::string> &scriptFiles);
+    /**
+     * Run a Lua script (see scripting::LuaRuntime for the functions it can
+     * call). The compiled bytecode is cached on disk, keyed by the source.
+     * Errors are logged and leave the current script in place.
+     */
     void LoadScript(const std::string &filename);
+
+    /**
+     * Where LoadScript() caches compiled Lua bytecode. Defaults to
+     * ".cereka-cache/lua"; empty disables the cache.
+     */
+    void SetScriptCacheDir(const std::string &dir);
     void AdvanceScriptOnce();
     void TickScript();
 
@@ -51,6 +182,123 @@ class CerekaEngine {
     size_t ButtonCount() const;
     size_t ProgramCounter() const;
 
+    CerekaStats Stats() const;
+
+    /**
+     * Number of instructions scanned ahead of the program counter (across
+     * jumps and menu branches) when prefetching images. Zero disables it.
+     */
+    void SetPrefetchLookahead(size_t instructions);
+
+    /**
+     * Upper bound, in bytes, for textures kept resident after they leave the
+     * scene. Textures on screen are never evicted.
+     */
+    void SetTextureBudget(size_t bytes);
+
+    /**
+     * Upper bound, in bytes, for decoded sound effects kept for replay.
+     * Sounds still playing are never evicted.
+     */
+    void SetSoundCacheBudget(size_t bytes);
+
+    /**
+     * Directory loose asset files are read from, e.g. "<root>/bg/street.png".
+     * Defaults to "assets". Call before InitGame().
+     */
+    void SetAssetRoot(const std::string &dir);
+
+    /**
+     * Map an asset pack built by cereka_pack. Assets found in a pack are used
+     * instead of loose files; packs mounted later take precedence. Call
+     * before InitGame(). Throws engine::error if the pack cannot be mapped.
+     */
+    void MountAssetPack(const std::string &path);
+
+    /**
+     * Write the buffered trace events as Chrome trace JSON (open it in
+     * ui.perfetto.dev). Returns false if the engine was built without
+     * CEREKA_TRACING or the file cannot be written.
+     */
+    bool DumpTrace(const std::string &path);
+
+    /**
+     * Start or stop skipping. While skipping, TickScript() advances through
+     * as many instructions as fit in a few milliseconds per frame, loads
+     * only the final background and characters, and shows just the last
+     * line passed. Skipping turns itself off at menus, at the end of the
+     * script, in Read mode before an unread line, and on any click or key.
+     */
+    void SetSkipMode(SkipMode mode);
+    SkipMode GetSkipMode() const;
+
+    /**
+     * Whether the line at instruction `pc` has been shown before.
+     */
+    bool IsLineRead(size_t pc) const;
+
+    /**
+     * Keep the read-line history in `path`: it is loaded now and whenever a
+     * program is loaded, and written by SaveReadHistory() and ShutDown().
+     * History written for a different program image is ignored.
+     */
+    void SetReadHistoryPath(const std::string &path);
+    void SaveReadHistory();
+
+    /**
+     * Write the session (script position, dialogue, scene and menu) to a
+     * compact binary snapshot. Throws engine::error if it cannot be written.
+     */
+    void SaveGame(const std::string &path);
+
+    /**
+     * Restore a snapshot written by SaveGame() or autosave. The same script
+     * must be loaded; throws engine::error otherwise or if the file is bad.
+     */
+    void LoadGame(const std::string &path);
+
+    /**
+     * Autosave to `path` every time the script stops for input. State is
+     * captured on the calling thread; compression and the file write happen
+     * in the background. An empty path turns autosave off.
+     */
+    void SetAutosavePath(const std::string &path);
+
+    /**
+     * Record the session for replay: the state now, then every HandleEvent()
+     * and SetSkipMode() call and each frame's Update() dt. Written to `path`
+     * by StopRecording() or ShutDown(). Throws engine::error while a Lua
+     * script runs, since its state cannot be captured.
+     */
+    void StartRecording(const std::string &path);
+
+    /**
+     * Write the recording. Throws engine::error if it cannot be written.
+     */
+    void StopRecording();
+
+    /**
+     * Replay a recording (see tools/cereka_replay). Restores the state it
+     * started from; each ReplayFrame() then feeds one recorded frame's input
+     * and returns its dt, until the recording ends:
+     *
+     *   engine.StartReplay("session.crkr");
+     *   while (engine.ReplayFrame(dt)) {
+     *       engine.TickScript();
+     *       engine.Update(dt);
+     *       if (engine.NeedsPresent()) {
+     *           engine.Draw();
+     *           engine.Present();
+     *       }
+     *   }
+     *
+     * Skip mode advances as far per frame as it did when recorded, not by
+     * time, so every replay takes the same path. Throws engine::error if the
+     * file is bad or was recorded with another script or window size.
+     */
+    void StartReplay(const std::string &path);
+    bool ReplayFrame(float &dt);
+
     bool IsGameFinished() const;
     bool IsScriptFinished() const;
     bool IsFinished() const;
@@ -1,14 +1,37 @@
 
 #include "Cereka/Cereka.hpp"
+#include "asset_pack.hpp"
+#include "asset_prefetcher.hpp"
+#include "audio.hpp"
+#include "bytecode.hpp"
+#include "compositor.hpp"
+#include "file_watcher.hpp"
+#include "hash.hpp"
+#include "input_log.hpp"
+#include "log.hpp"
+#include "lua_runtime.hpp"
+#include "program_analysis.hpp"
+#include "project_compiler.hpp"
+#include "read_history.hpp"
+#include "resample.hpp"
+#include "snapshot.hpp"
+#include "sprite_batch.hpp"
 #include "text_renderer.hpp"
+#include "texture_file.hpp"
+#include "texture_cache.hpp"
+#include "trace.hpp"
+#include "ui_menu.hpp"
 #include "video.hpp"
 #include "vn_instruction.hpp"
 
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 #include <SDL3_ttf/SDL_ttf.h>
-#include <iostream>
-#include <sol/sol.hpp>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 
 using namespace cereka;
@@ -22,35 +45,158 @@ class CerekaEngine::Implementation {
     int screenHeight = 0;
 
     TTF_Font *font = nullptr;
-    SDL_Texture *background = nullptr;
-    SDL_Texture *textBox = nullptr;
-    SDL_Texture *nameBox = nullptr;
-    SDL_Texture *buttonTexture = nullptr;
-    std::unordered_map<std::string, SDL_Texture *> characters;
-
-    sol::state lua;
-    sol::coroutine script;
-    std::vector<cereka::scenario::Instruction> program;
-    std::unordered_map<std::string, size_t> labelMap;
+    // Glyphs and solid UI boxes share atlas pages and go through one batch.
+    std::unique_ptr<render::SpriteAtlas> sprites;
+    std::unique_ptr<render::SpriteBatch> batch;
+    std::unique_ptr<text_renderer::GlyphAtlas> glyphs;
+    // Caches the scene layers and redraws only damaged parts of the frame;
+    // null if the renderer has no render targets.
+    std::unique_ptr<render::Compositor> compositor;
+    // Every scene texture is owned by this cache; it is declared before the
+    // handles so that it outlives them.
+    std::unique_ptr<assets::TextureCache> textures;
+    size_t textureBudget = size_t(256) << 20;
+    assets::TextureHandle background;
+    std::string backgroundId;
+    std::string musicId;
+    std::unordered_map<std::string, assets::TextureHandle> characters;
+    // Expression each shown character was last given.
+    std::unordered_map<std::string, std::string> expressions;
+
+    assets::AssetSource assetSource;
+    std::unique_ptr<assets::ImagePrefetcher> prefetcher;
+    size_t prefetchLookahead = 64;
+    size_t prefetchedAt = size_t(-1);
+    uint64_t textureUploads = 0;
+    // Written by the prefetch workers as well as the main thread.
+    std::atomic<uint64_t> prescaledImages{0};
+    std::atomic<uint64_t> prescaleSavedBytes{0};
+    uint64_t lastGlyphMisses = 0;
+
+    std::unique_ptr<audio::AudioSystem> audio;
+    size_t soundBudget = size_t(16) << 20;
+    // Set by a VOICE instruction; the line it voices keeps it playing.
+    bool voiceQueued = false;
+    static constexpr size_t MAX_PREFETCHED_VOICES = 4;
+
+    // Routes calls from Lua scripts (LoadScript) to the engine.
+    struct LuaHost : scripting::ScriptHost {
+        explicit LuaHost(Implementation &engine) : engine(engine) {}
+
+        void ScriptBackground(std::string_view name) override
+        {
+            engine.ShowBackground(name);
+        }
+        void ScriptShow(std::string_view id,
+                        std::string_view expression) override
+        {
+            engine.ShowCharacter(id, expression);
+        }
+        void ScriptHide(std::string_view id) override
+        {
+            engine.HideCharacter(id);
+        }
+        void ScriptMusic(std::string_view name) override
+        {
+            engine.PlayMusic(name);
+        }
+        void ScriptSound(std::string_view name) override
+        {
+            engine.PlaySound(name);
+        }
+        void ScriptVoice(std::string_view name) override
+        {
+            engine.PlayVoice(name);
+        }
+        void ScriptSay(std::string_view speaker,
+                       std::string_view text) override
+        {
+            engine.StartLine();
+            if (speaker.empty())
+                engine.Narrate(text);
+            else
+                engine.Say(speaker, speaker, text);
+            engine.state = CerekaState::WaitingForInput;
+        }
+        void ScriptMenu(const std::vector<std::string> &choices) override
+        {
+            engine.OpenScriptMenu(choices);
+        }
+
+        Implementation &engine;
+    };
+
+    LuaHost luaHost{*this};
+    std::unique_ptr<scripting::LuaRuntime> luaRuntime;
+    std::string luaCacheDir = ".cereka-cache/lua";
+    bool luaActive = false;
+    int pendingChoice = 0;
+    std::shared_ptr<const scenario::Bytecode> program = scenario::Bytecode::Build({});
+    // Control flow and menu tables of `program`, built when it is loaded.
+    std::shared_ptr<const scenario::ProgramAnalysis> analysis =
+        scenario::ProgramAnalysis::Analyze(program);
+    uint64_t programHash = 0;
     size_t pc = 0;
     size_t menuEndPC = 0;
     bool scriptFinished = false;
 
+    // Autosave: serialized here on every blocking line, written by the
+    // Autosaver's worker.
+    std::string autosavePath;
+    std::unique_ptr<save::Autosaver> autosaver;
+    std::vector<std::byte> saveBuffer;
+
+    // Skip mode. While skipping, scene changes are only recorded and the
+    // final state is loaded once per frame.
+    SkipMode skipMode = SkipMode::Off;
+    save::ReadHistory readHistory;
+    std::string readHistoryPath;
+    static constexpr Uint64 SKIP_BUDGET_NS = 4'000'000;
+
+    // Development hot reload (EnableHotReload()); no watcher when off.
+    std::unique_ptr<io::FileWatcher> watcher;
+    std::unique_ptr<scenario::ProjectCompiler> reloadCompiler;
+    std::vector<std::string> reloadScripts;  // normalized paths, link order
+    std::string reloadAssetRoot;
+    uint64_t scriptReloads = 0;
+    uint64_t assetReloads = 0;
+    uint64_t lastReloadNs = 0;
+    static constexpr Sint32 RELOAD_POLL_MS = 100;
+
+    // Input recording and replay (StartRecording(), StartReplay()).
+    std::unique_ptr<replay::InputRecorder> recorder;
+    std::unique_ptr<replay::InputLog> replayLog;
+    size_t replayFrame = 0;
+    std::optional<uint32_t> replaySkipSteps;  // for the current replayed frame
+
     std::string currentSpeaker;
     std::string currentName;
     std::string currentText;
     float typewriterTimer = 0.0f;
-    int displayedChars = 0;
+
+    // Dialogue layout is computed once per line; the typewriter only moves
+    // `revealed` forward and appends the newly visible glyphs to the mesh.
+    text_renderer::TextLayout dialogueLayout;
+    text_renderer::TextMesh dialogueMesh;
+    size_t dialoguePage = 0;
+    size_t revealed = 0;
     static constexpr float CHARS_PER_SECOND = 60.0f;
 
+    static constexpr SDL_FColor TEXT_BOX_COLOR{0.f, 0.f, 0.f, 130 / 255.f};
+    static constexpr SDL_FColor NAME_BOX_COLOR{0.f, 1.f, 0.f, 1.f};
+
     // Menu state
     bool inMenu = false;
-    std::vector<std::string> buttonTexts;
-    std::vector<std::string> buttonTargets;
-    std::vector<bool> buttonExits;
+    ui::Menu menu;
 
     CerekaState state = CerekaState::Running;
 
+    // Idle mode: `dirty` is set by anything that changes the picture and
+    // cleared by Draw(); frames are paced to frameIntervalNs (0 = uncapped).
+    bool dirty = true;
+    Uint64 frameIntervalNs = 0;
+    Uint64 lastPresentNs = 0;
+
     bool InitGame(const char *title,
                   int width,
                   int height,
@@ -64,47 +210,68 @@ class CerekaEngine::Implementation {
         this->screenHeight = video::height;
 
         text_renderer::init_ttf();
-        this->font = text_renderer::OpenFont("assets/fonts/Montserrat-Medium.ttf", 36);
+        const std::string fontName = "fonts/Montserrat-Medium.ttf";
+        this->font = text_renderer::OpenFont(assetSource.Open(fontName), fontName, 36);
 
         this->renderer = CreateBestRenderer(this->window);
         if (!this->renderer) {
             throw engine::error("All renderer attempts failed\n");
         }
 
-        this->textBox = CreateSolidTexture(
-            screenWidth, static_cast<int>(screenHeight * 0.25f), 0, 0, 0, 130);
-
-        this->nameBox = CreateSolidTexture(300, 60, 0, 255, 0, 255);
-
-        this->buttonTexture = CreateSolidTexture(600, 80, 0, 255, 255, 255);
-        if (!this->buttonTexture) {
-            throw engine::error("buttonTexture NULL – CreateSolidTexture failed: %s",
-                                SDL_GetError());
-        }
+        this->sprites = std::make_unique<render::SpriteAtlas>(this->renderer);
+        this->batch = std::make_unique<render::SpriteBatch>(this->renderer);
+        if (this->font)
+            this->glyphs = std::make_unique<text_renderer::GlyphAtlas>(*this->sprites, this->font);
+        this->compositor =
+            std::make_unique<render::Compositor>(this->renderer, screenWidth, screenHeight);
+        if (!this->compositor->Valid())
+            this->compositor.reset();
+
+        // The draw size is fixed from here on, so images are resampled to
+        // it once, on the workers, and the texture cache holds them at the
+        // size they are drawn.
+        this->prefetcher = std::make_unique<assets::ImagePrefetcher>(
+            assetSource, [this](const std::string &path, SDL_Surface *surface) {
+                return Prescale(path, surface);
+            });
+        this->textures = std::make_unique<assets::TextureCache>(
+            textureBudget, [this](const std::string &path) { return LoadImageTexture(path); });
+
+        // Without a device the engine runs silently.
+        this->audio = std::make_unique<audio::AudioSystem>(assetSource, soundBudget);
+        this->audio->Open();
+        SchedulePrefetch();
 
         return true;
     }
 
     void ShutDown()
     {
-        if (this->background) {
-            SDL_DestroyTexture(this->background);
-            this->background = nullptr;
+        if (this->autosaver)
+            this->autosaver->Wait();
+        try {
+            StopRecording();
         }
-        if (this->textBox) {
-            SDL_DestroyTexture(this->textBox);
-            this->textBox = nullptr;
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("could not save input recording: {}", e.what());
         }
-        if (this->nameBox) {
-            SDL_DestroyTexture(this->nameBox);
-            this->nameBox = nullptr;
+        try {
+            SaveReadHistory();
         }
-
-        for (auto &[id, tex] : this->characters) {
-            SDL_DestroyTexture(tex);
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("could not save read history: {}", e.what());
         }
+        this->background.Reset();
         this->characters.clear();
-
+        this->expressions.clear();
+        this->textures.reset();
+
+        this->glyphs.reset();
+        this->compositor.reset();
+        this->batch.reset();
+        this->sprites.reset();
+        this->prefetcher.reset();
+        this->audio.reset();
         if (this->font) {
             TTF_CloseFont(this->font);
             this->font = nullptr;
@@ -120,14 +287,59 @@ class CerekaEngine::Implementation {
 
         TTF_Quit();
         SDL_Quit();
+        log::Flush();
     }
 
     bool PollEvent(CerekaEvent &e)
     {
         SDL_Event sdl;
-        if (!SDL_PollEvent(&sdl))
-            return false;
+        while (SDL_PollEvent(&sdl)) {
+            if (TranslateEvent(sdl, e))
+                return true;
+        }
+        // Once per drained queue, so hosts that never wait still reload.
+        PollHotReload();
+        return false;
+    }
 
+    // Deliver input until a frame is due. With nothing animating and nothing
+    // to redraw this sleeps in SDL until input arrives, so an idle dialogue
+    // screen costs no CPU; otherwise it waits at most until the next frame
+    // deadline set by the frame cap.
+    bool WaitEvent(CerekaEvent &e)
+    {
+        for (;;) {
+            // Changes are swapped in here, between frames.
+            if (PollHotReload())
+                return false;
+            SDL_Event sdl;
+            bool got;
+            if (!NeedsFrame()) {
+                if (!watcher)
+                    got = SDL_WaitEvent(&sdl);
+                else if (!(got = SDL_WaitEventTimeout(&sdl, RELOAD_POLL_MS)))
+                    continue;
+            }
+            else {
+                const Uint64 now = SDL_GetTicksNS();
+                const Uint64 deadline = lastPresentNs + frameIntervalNs;
+                if (deadline <= now)
+                    got = SDL_PollEvent(&sdl);
+                else
+                    got = SDL_WaitEventTimeout(&sdl, Sint32((deadline - now + 999999) / 1000000));
+            }
+            if (!got)
+                return false;
+            if (TranslateEvent(sdl, e))
+                return true;
+        }
+    }
+
+    // Map an SDL event to an engine event. Events the engine does not expose
+    // are consumed here (marking the frame dirty if they invalidate it).
+    bool TranslateEvent(const SDL_Event &sdl,
+                        CerekaEvent &e)
+    {
         switch (sdl.type) {
             case SDL_EVENT_QUIT:
                 e = {CerekaEvent::Quit, 0};
@@ -136,80 +348,220 @@ class CerekaEngine::Implementation {
                 e = {CerekaEvent::KeyDown, int(sdl.key.key)};
                 return true;
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                e.type = CerekaEvent::MouseDown;
+            case SDL_EVENT_MOUSE_BUTTON_UP:
+                e.type = sdl.type == SDL_EVENT_MOUSE_BUTTON_DOWN ? CerekaEvent::MouseDown
+                                                                 : CerekaEvent::MouseUp;
                 e.key = 0;
                 e.mouseX = sdl.button.x;
                 e.mouseY = sdl.button.y;
+                e.wheel = 0.f;
                 return true;
+            case SDL_EVENT_MOUSE_MOTION:
+                e.type = CerekaEvent::MouseMove;
+                e.key = 0;
+                e.mouseX = sdl.motion.x;
+                e.mouseY = sdl.motion.y;
+                e.wheel = 0.f;
                 return true;
-            default:
-                e = {CerekaEvent::Unknown, 0};
+            case SDL_EVENT_MOUSE_WHEEL:
+                e.type = CerekaEvent::MouseWheel;
+                e.key = 0;
+                e.mouseX = sdl.wheel.mouse_x;
+                e.mouseY = sdl.wheel.mouse_y;
+                e.wheel = sdl.wheel.y;
+                if (sdl.wheel.direction == SDL_MOUSEWHEEL_FLIPPED)
+                    e.wheel = -e.wheel;
                 return true;
+            case SDL_EVENT_WINDOW_EXPOSED:
+            case SDL_EVENT_WINDOW_RESIZED:
+            case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            case SDL_EVENT_WINDOW_RESTORED:
+            case SDL_EVENT_RENDER_TARGETS_RESET:
+            case SDL_EVENT_RENDER_DEVICE_RESET:
+                // Render target contents may be gone as well.
+                SceneChanged();
+                return false;
+            default:
+                return false;
         }
     }
 
+    // Something on screen changes on its own: the script has work to do or
+    // the typewriter is still revealing the current page.
+    bool IsAnimating() const
+    {
+        // Skipping advances once per frame, with no input to wake it.
+        if (state == CerekaState::Running || skipMode != SkipMode::Off)
+            return true;
+        return !dialogueLayout.glyphs.empty() && revealed < dialogueLayout.PageEnd(dialoguePage);
+    }
+
+    bool NeedsFrame() const
+    {
+        return dirty || IsAnimating();
+    }
+
+    void SetFrameCap(int fps)
+    {
+        frameIntervalNs = fps > 0 ? SDL_NS_PER_SECOND / Uint64(fps) : 0;
+    }
+
     void Present()
     {
+        CEREKA_TRACE_ZONE("Present");
         SDL_RenderPresent(this->renderer);
+        lastPresentNs = SDL_GetTicksNS();
     }
 
     void HandleEvent(const CerekaEvent &e)
     {
+        if (recorder)
+            recorder->Event(e);
+
+        // Any click or key press while skipping just stops the skip.
+        if (skipMode != SkipMode::Off &&
+            (e.type == CerekaEvent::MouseDown || e.type == CerekaEvent::KeyDown))
+        {
+            skipMode = SkipMode::Off;
+            return;
+        }
+
         if (state == CerekaState::WaitingForInput &&
             (e.type == CerekaEvent::MouseDown || e.type == CerekaEvent::KeyDown))
         {
+            if (dialoguePage + 1 < dialogueLayout.PageCount()) {
+                ShowDialoguePage(dialoguePage + 1);
+                return;
+            }
             state = CerekaState::Running;
             return;
         }
 
-        if (state == CerekaState::InMenu && e.type == CerekaEvent::MouseDown) {
-            int idx = HitTestButton(e.mouseX, e.mouseY);
-            if (idx < 0)
-                return;
+        if (state == CerekaState::InMenu)
+            HandleMenuEvent(e);
+    }
 
-            if (buttonExits[idx]) {
-                ExitMenu();
-                state = CerekaState::Finished;
-                return;
+    // Buttons highlight under the pointer and fire when released over the
+    // button they were pressed on.
+    void HandleMenuEvent(const CerekaEvent &e)
+    {
+        menu.Layout(screenWidth, screenHeight);
+        switch (e.type) {
+            case CerekaEvent::MouseMove:
+                SetMenuHover(menu.HitTest(e.mouseX, e.mouseY));
+                break;
+            case CerekaEvent::MouseDown: {
+                const int idx = menu.HitTest(e.mouseX, e.mouseY);
+                SetMenuHover(idx);
+                const int old = menu.Pressed();
+                if (menu.SetPressed(idx)) {
+                    Damage(menu.ItemRect(old));
+                    Damage(menu.ItemRect(idx));
+                }
+                break;
+            }
+            case CerekaEvent::MouseUp: {
+                const int idx = menu.HitTest(e.mouseX, e.mouseY);
+                const int pressed = menu.Pressed();
+                if (menu.SetPressed(-1))
+                    Damage(menu.ItemRect(pressed));
+                if (idx >= 0 && idx == pressed)
+                    ChooseButton(size_t(idx));
+                break;
             }
+            case CerekaEvent::MouseWheel:
+                if (e.wheel != 0.f && menu.Scroll(e.wheel > 0.f ? -1 : 1)) {
+                    Damage(menu.Viewport());
+                    menu.SetHovered(menu.HitTest(e.mouseX, e.mouseY));
+                }
+                break;
+            default:
+                break;
+        }
+    }
 
-            if (!buttonTargets[idx].empty())
-                pc = labelMap[buttonTargets[idx]];
-            else
-                pc = menuEndPC;  //
+    void SetMenuHover(int idx)
+    {
+        const int old = menu.Hovered();
+        if (menu.SetHovered(idx)) {
+            Damage(menu.ItemRect(old));
+            Damage(menu.ItemRect(idx));
+        }
+    }
 
-            ExitMenu();
+    void ChooseButton(size_t idx)
+    {
+        const ui::MenuItem item = menu.Items()[idx];
+        ExitMenu();
+        if (luaActive) {
+            pendingChoice = int(idx) + 1;
             state = CerekaState::Running;
+            return;
+        }
+        if (item.exit) {
+            state = CerekaState::Finished;
+            return;
         }
+        pc = item.target;
+        state = CerekaState::Running;
     }
     void TickScript()
     {
+        CEREKA_TRACE_ZONE("TickScript");
+        if (luaActive) {
+            if (state == CerekaState::Running)
+                ResumeLua();
+            return;
+        }
+        if (skipMode != SkipMode::Off &&
+            (state == CerekaState::Running || state == CerekaState::WaitingForInput))
+        {
+            SkipAhead();
+            return;
+        }
         if (state != CerekaState::Running)
             return;
 
-        while (pc < program.size()) {
-            const auto &ins = program[pc];
+        RunUntilBlocked();
+        SchedulePrefetch();
+        if (state == CerekaState::WaitingForInput || state == CerekaState::InMenu)
+            Autosave();
+        CEREKA_TRACE_COUNTER("pc", pc);
+    }
 
-            switch (ins.op) {
+    void RunUntilBlocked()
+    {
+        const scenario::Bytecode &code = *program;
+        while (pc < code.Size()) {
+            switch (code.OpAt(pc)) {
 
                 case scenario::Op::BG:
-                    ShowBackground(ins.a);
+                    ShowBackground(code.A(pc));
                     pc++;
                     continue;
 
                 case scenario::Op::CHAR:
-                    ShowCharacter(ins.a, ins.b);
+                    ShowCharacter(code.A(pc), code.B(pc));
+                    pc++;
+                    continue;
+
+                case scenario::Op::HIDE:
+                    HideCharacter(code.A(pc));
                     pc++;
                     continue;
 
                 case scenario::Op::SAY:
-                    Say(ins.a, ins.a, ins.b);
+                    StartLine();
+                    Say(code.A(pc), code.A(pc), code.B(pc));
+                    readHistory.Mark(pc);
                     state = CerekaState::WaitingForInput;
                     pc++;
                     return;
 
                 case scenario::Op::NARRATE:
-                    Narrate(ins.b);
+                    StartLine();
+                    Narrate(code.B(pc));
+                    readHistory.Mark(pc);
                     state = CerekaState::WaitingForInput;
                     pc++;
                     return;
@@ -221,7 +573,7 @@ class CerekaEngine::Implementation {
                     return;
 
                 case scenario::Op::JUMP:
-                    pc = labelMap[ins.a];
+                    pc = TargetOr(pc, pc + 1);
                     continue;
 
                 case scenario::Op::END:
@@ -232,6 +584,21 @@ class CerekaEngine::Implementation {
                     pc++;
                     continue;
 
+                case scenario::Op::BGM:
+                    PlayMusic(code.A(pc));
+                    pc++;
+                    continue;
+
+                case scenario::Op::SFX:
+                    PlaySound(code.A(pc));
+                    pc++;
+                    continue;
+
+                case scenario::Op::VOICE:
+                    PlayVoice(code.A(pc));
+                    pc++;
+                    continue;
+
                 default:
                     pc++;
                     continue;
@@ -239,241 +606,843 @@ class CerekaEngine::Implementation {
         }
     }
 
-    void EnterMenu()
+    // Fast-forward for up to SKIP_BUDGET_NS. Lines are only marked as read,
+    // not laid out, and BG/CHAR/BGM changes are collected so that only the
+    // scene visible at the end of the frame gets loaded. Sounds and voice
+    // lines skipped over are not played. Skipping stops at menus,
+    // at the end of the script and, in SkipMode::Read, before unread lines.
+    void SkipAhead()
     {
-        buttonTexts.clear();
-        buttonTargets.clear();
-        buttonExits.clear();
-
-        // Kita execute semua benda dalam menu block serta-merta
-        size_t scan = pc + 1;  // mula selepas MENU
+        CEREKA_TRACE_ZONE("SkipAhead");
+        const scenario::Bytecode &code = *program;
+        const Uint64 deadline = SDL_GetTicksNS() + SKIP_BUDGET_NS;
+
+        std::string_view pendingBackground;
+        // Last state per character, in first-shown order.
+        struct PendingCharacter {
+            std::string_view id;
+            std::optional<std::string_view> expression;  // none: hidden
+        };
+        std::vector<PendingCharacter> pendingCharacters;
+        std::optional<std::string_view> pendingMusic;
+        size_t lastLine = size_t(-1);
+        bool stop = false;
+
+        // A replay runs exactly as many steps as the recorded session did.
+        const std::optional<uint32_t> stepLimit = std::exchange(replaySkipSteps, std::nullopt);
+        size_t steps = 1;
+
+        state = CerekaState::Running;
+        for (; pc < code.Size() && !stop; ++steps) {
+            if (stepLimit && steps > *stepLimit)
+                break;
+            if (!stepLimit && (steps & 255) == 0 && SDL_GetTicksNS() >= deadline)
+                break;
 
-        while (scan < program.size()) {
-            const auto &ins = program[scan];
+            switch (code.OpAt(pc)) {
+                case scenario::Op::BG:
+                    pendingBackground = code.A(pc);
+                    pc++;
+                    break;
+                case scenario::Op::CHAR:
+                case scenario::Op::HIDE: {
+                    std::optional<std::string_view> expression;
+                    if (code.OpAt(pc) == scenario::Op::CHAR)
+                        expression = code.B(pc);
+                    auto it = std::find_if(pendingCharacters.begin(),
+                                           pendingCharacters.end(),
+                                           [&](const auto &c) { return c.id == code.A(pc); });
+                    if (it != pendingCharacters.end())
+                        it->expression = expression;
+                    else
+                        pendingCharacters.push_back({code.A(pc), expression});
+                    pc++;
+                    break;
+                }
+                case scenario::Op::BGM:
+                    pendingMusic = code.A(pc);
+                    pc++;
+                    break;
+                case scenario::Op::SAY:
+                case scenario::Op::NARRATE:
+                    if (skipMode == SkipMode::Read && !readHistory.Seen(pc)) {
+                        stop = true;
+                        break;
+                    }
+                    readHistory.Mark(pc);
+                    lastLine = pc++;
+                    break;
+                case scenario::Op::JUMP:
+                    pc = TargetOr(pc, pc + 1);
+                    break;
+                case scenario::Op::MENU:
+                case scenario::Op::END:
+                    stop = true;
+                    break;
+                default:
+                    pc++;
+                    break;
+            }
+        }
 
-            if (ins.op == scenario::Op::BG) {
-                ShowBackground(ins.a);  // ← LOAD BACKGROUND DALAM MENU!
-                scan++;
+        if (!pendingBackground.empty() && pendingBackground != backgroundId)
+            ShowBackground(pendingBackground);
+        for (const auto &[id, expression] : pendingCharacters) {
+            const auto shown = expressions.find(std::string(id));
+            if (!expression) {
+                if (shown != expressions.end())
+                    HideCharacter(id);
             }
-            else if (ins.op == scenario::Op::BUTTON) {
-                buttonTexts.push_back(ins.a);
-                buttonTargets.push_back(ins.b);
-                buttonExits.push_back(ins.exit_button);
-                scan++;
+            else if (shown == expressions.end() || shown->second != *expression) {
+                ShowCharacter(id, *expression);
             }
-            else {
-                // Bukan BG atau BUTTON → tamat menu block
-                break;
+        }
+        if (pendingMusic)
+            PlayMusic(*pendingMusic);
+        StopVoice();
+        if (recorder)
+            recorder->SkipSteps(uint32_t(steps - 1));
+
+        if (stop || pc >= code.Size()) {
+            // Hand over to the normal interpreter, which shows the unread
+            // line, opens the menu or finishes.
+            skipMode = SkipMode::Off;
+            RunUntilBlocked();
+            SchedulePrefetch();
+            return;
+        }
+
+        // Show the last line passed this frame, fully revealed.
+        if (lastLine != size_t(-1)) {
+            if (code.OpAt(lastLine) == scenario::Op::SAY)
+                Say(code.A(lastLine), code.A(lastLine), code.B(lastLine));
+            else
+                Narrate(code.B(lastLine));
+            if (glyphs)
+                RevealGlyphs(dialogueLayout.PageEnd(dialoguePage));
+        }
+        state = CerekaState::WaitingForInput;
+    }
+
+    void SetSkipMode(SkipMode mode)
+    {
+        if (recorder)
+            recorder->Skip(mode);
+        // Lua scripts have no instruction stream to scan ahead in.
+        skipMode = luaActive ? SkipMode::Off : mode;
+    }
+
+    void SetReadHistoryPath(const std::string &path)
+    {
+        readHistoryPath = path;
+        if (!readHistoryPath.empty())
+            readHistory.Load(readHistoryPath);
+    }
+
+    void SaveReadHistory()
+    {
+        // Before the first script there is no history, only a file to clobber.
+        if (!readHistoryPath.empty() && programHash != 0)
+            readHistory.Save(readHistoryPath);
+    }
+
+    // Queue decodes for the images reachable within the lookahead window.
+    void SchedulePrefetch()
+    {
+        if (!prefetcher || pc == prefetchedAt)
+            return;
+        prefetchedAt = pc;
+
+        std::vector<std::string> paths;
+        std::vector<std::string> voices;
+        for (const auto &ref : assets::ScanAhead(*program, pc, prefetchLookahead)) {
+            if (ref.kind == assets::AssetKind::Voice) {
+                // Decoded voices are large; only the nearest few are kept.
+                if (voices.size() < MAX_PREFETCHED_VOICES)
+                    voices.push_back(VoicePath(ref.id));
+                continue;
             }
+            std::string path = ref.kind == assets::AssetKind::Background ? BackgroundPath(ref.id)
+                                                                         : CharacterPath(ref.id);
+            if (!textures || !textures->Contains(path))
+                paths.push_back(std::move(path));
         }
+        prefetcher->Prefetch(paths);
+        if (audio)
+            audio->PrefetchVoices(voices);
+    }
+
+    void EnterMenu()
+    {
+        menu.Clear();
+        const scenario::MenuTable *table = analysis->MenuAt(pc);
+        if (!table)
+            return;
+
+        // The menu's own background is shown as soon as it opens.
+        if (!table->background.empty())
+            ShowBackground(table->background);
+        for (const scenario::MenuButton &button : table->buttons)
+            menu.Add({std::string(button.text), button.target, button.exit});
 
         inMenu = true;
-        this->menuEndPC = scan;
+        DamageAll();
+        menuEndPC = table->end;
+        menu.Layout(screenWidth, screenHeight);
 
-        std::cout << "[MENU] Loaded background and " << buttonTexts.size() << " buttons!"
-                  << std::endl;
+        CEREKA_LOG_DEBUG("entered menu with {} buttons", menu.Size());
     }
 
     void Update(float dt)
     {
-        if (currentText.empty())
+        CEREKA_TRACE_ZONE("Update");
+        if (recorder)
+            recorder->EndFrame(dt);
+        if (dialogueLayout.glyphs.empty())
             return;
 
-        if (displayedChars < (int)currentText.length()) {
+        const size_t pageEnd = dialogueLayout.PageEnd(dialoguePage);
+        if (revealed < pageEnd) {
             typewriterTimer += dt;
             int charsToAdd = (int)(typewriterTimer * CHARS_PER_SECOND);
             if (charsToAdd > 0) {
-                displayedChars += charsToAdd;
                 typewriterTimer -= charsToAdd / CHARS_PER_SECOND;
-                if (displayedChars > (int)currentText.length())
-                    displayedChars = currentText.length();
+                RevealGlyphs(std::min(pageEnd, revealed + charsToAdd));
             }
         }
     }
 
+    // Append glyphs [revealed, end) of the current page to the dialogue mesh.
+    // Only the area of the new glyphs needs redrawing.
+    void RevealGlyphs(size_t end)
+    {
+        const SDL_FRect box = DialogueTextRect();
+        SDL_FRect damage{};
+        bool damaged = false;
+        for (; revealed < end; ++revealed) {
+            const auto &g = dialogueLayout.glyphs[revealed];
+            const SDL_FRect quad{box.x + g.x, box.y + g.y, g.glyph->width, g.glyph->height};
+            glyphs->Append(dialogueMesh, *g.glyph, quad.x, quad.y, {1.f, 1.f, 1.f, 1.f});
+            if (!g.glyph->texture)
+                continue;
+            if (damaged)
+                SDL_GetRectUnionFloat(&damage, &quad, &damage);
+            else
+                damage = quad;
+            damaged = true;
+        }
+        if (damaged)
+            Damage(damage);
+    }
+
+    void ShowDialoguePage(size_t page)
+    {
+        dialoguePage = page;
+        revealed = dialogueLayout.PageBegin(page);
+        typewriterTimer = 0.0f;
+        dialogueMesh.Clear();
+        Damage(DialogueRect());
+    }
+
+    // Text box and name box together.
+    SDL_FRect DialogueRect() const
+    {
+        const float top = screenHeight * 0.75f - 70;
+        return {0, top, float(screenWidth), screenHeight - top};
+    }
+
+    SDL_FRect DialogueTextRect() const
+    {
+        const float margin = 70;
+        const float top = screenHeight * 0.80f;
+        return {margin, top, screenWidth - 2 * margin, screenHeight - top - 10};
+    }
+
     void Draw()
+    {
+        CEREKA_TRACE_ZONE("Draw");
+        CEREKA_LOG_TRACE("draw: inMenu={} buttons={}", inMenu, menu.Size());
+        dirty = false;
+        if (!batch) {
+            ClearScreen();
+            return;
+        }
+        [[maybe_unused]] const render::BatchStats before = batch->Stats();
+        if (compositor) {
+            compositor->Render(
+                [this] {
+                    ClearScreen();
+                    DrawBackground();
+                    DrawCharacters();
+                    batch->Flush();
+                },
+                [this] {
+                    DrawMenu();
+                    DrawDialogue();
+                    batch->Flush();
+                });
+        }
+        else {
+            ClearScreen();
+            DrawBackground();
+            DrawCharacters();
+            DrawMenu();
+            DrawDialogue();
+            batch->Flush();
+        }
+
+        [[maybe_unused]] const render::BatchStats &after = batch->Stats();
+        CEREKA_TRACE_COUNTER("draw calls", after.drawCalls - before.drawCalls);
+        CEREKA_TRACE_COUNTER("texture switches", after.textureSwitches - before.textureSwitches);
+        CEREKA_TRACE_COUNTER("textures alive", textures ? textures->Stats().textures : 0);
+        CEREKA_TRACE_COUNTER("text rasterizations", TakeGlyphMisses());
+    }
+
+    void ClearScreen()
     {
         SDL_SetRenderDrawColor(renderer, 255, 0, 255, 255);
         SDL_RenderClear(renderer);
+    }
+
+    // The background or characters changed.
+    void SceneChanged()
+    {
+        dirty = true;
+        if (compositor)
+            compositor->InvalidateScene();
+    }
+
+    // Something drawn over the scene changed inside `rect`.
+    void Damage(const SDL_FRect &rect)
+    {
+        dirty = true;
+        if (compositor)
+            compositor->Invalidate(rect);
+    }
 
-        printf("Draw: inMenu=%d  buttons=%zu\n", inMenu, buttonTexts.size());
+    void DamageAll()
+    {
+        dirty = true;
+        if (compositor)
+            compositor->InvalidateAll();
+    }
+
+    void DrawBackground()
+    {
+        CEREKA_TRACE_ZONE("Draw.Background");
         if (background) {
-            SDL_RenderTexture(renderer, background, nullptr, nullptr);
+            batch->DrawTexture(background.Get(),
+                               {0, 0, float(screenWidth), float(screenHeight)},
+                               render::LAYER_BACKGROUND);
         }
+    }
 
-        // Draw characters
+    void DrawCharacters()
+    {
+        CEREKA_TRACE_ZONE("Draw.Characters");
         float xPos = screenWidth * 0.1f;
         const float spacing = screenWidth * 0.3f;
-        for (const auto &[id, tex] : characters) {
+        int slot = 0;
+        for (const auto &[id, handle] : characters) {
+            SDL_Texture *tex = handle.Get();
             float tw = 0, th = 0;
             SDL_GetTextureSize(tex, &tw, &th);
-            float scale = (screenHeight * 0.8f) / th;
-            SDL_FRect dst{
-                xPos, screenHeight - th * scale - screenHeight * 0.1f, tw * scale, th * scale};
-            SDL_RenderTexture(renderer, tex, nullptr, &dst);
+            // Usually the texture's own size: it was prescaled to this.
+            const SDL_Point size =
+                render::DrawSize(handle.Path(), int(tw), int(th), screenWidth, screenHeight);
+            SDL_FRect dst{xPos,
+                          screenHeight - float(size.y) - screenHeight * 0.1f,
+                          float(size.x),
+                          float(size.y)};
+            batch->DrawTexture(tex, dst, render::LAYER_CHARACTERS + slot++);
             xPos += spacing;
         }
-        printf("Draw: inMenu=%d  buttons=%zu\n", inMenu, buttonTexts.size());
-        // Menu buttons
+    }
+
+    void DrawMenu()
+    {
+        CEREKA_TRACE_ZONE("Draw.Menu");
         if (inMenu) {
-            float y = screenHeight * 0.4f;
-            const float h = 80, spacing = 20;
-            for (size_t i = 0; i < buttonTexts.size(); ++i) {
-                SDL_FRect btn{float(screenWidth) / 2 - 300, y, 600, h};
-                SDL_RenderTexture(renderer, buttonTexture, nullptr, &btn);
-
-                auto textTex = RenderText(buttonTexts[i], {255, 255, 255, 255});
-                if (textTex) {
-                    float tw, th;
-                    SDL_GetTextureSize(textTex, &tw, &th);
-                    SDL_FRect tr{float(screenWidth) / 2 - tw / 2, y + 40 - th / 2, tw, th};
-                    SDL_RenderTexture(renderer, textTex, nullptr, &tr);
-                    SDL_DestroyTexture(textTex);
-                }
-                y += h + spacing;
-            }
+            menu.Layout(screenWidth, screenHeight);
+            menu.Draw(
+                *batch, sprites->White(), glyphs.get(), render::LAYER_UI, render::LAYER_UI_TEXT);
         }
-        printf("Draw: inMenu=%d  buttons=%zu\n", inMenu, buttonTexts.size());
-        // Dialogue box
+    }
+
+    void DrawDialogue()
+    {
+        CEREKA_TRACE_ZONE("Draw.Dialogue");
         if (!currentText.empty()) {
-            if (textBox) {
-                SDL_FRect tb{0, screenHeight * 0.75f, (float)screenWidth, screenHeight * 0.25f};
-                SDL_RenderTexture(renderer, textBox, nullptr, &tb);
-            }
-            if (!currentSpeaker.empty() && nameBox) {
+            SDL_FRect tb{0, screenHeight * 0.75f, (float)screenWidth, screenHeight * 0.25f};
+            batch->Draw(sprites->White(), tb, TEXT_BOX_COLOR, render::LAYER_DIALOGUE);
+            if (!currentSpeaker.empty()) {
                 SDL_FRect nb{50, screenHeight * 0.75f - 70, 300, 60};
-                SDL_RenderTexture(renderer, nameBox, nullptr, &nb);
-                auto nameTex = RenderText(currentName, {255, 255, 255, 255});
-                if (nameTex) {
-                    float w, h;
-                    SDL_GetTextureSize(nameTex, &w, &h);
-                    SDL_FRect dst{70, screenHeight * 0.751f - 60, w, h};
-                    SDL_RenderTexture(renderer, nameTex, nullptr, &dst);
-                    SDL_DestroyTexture(nameTex);
-                }
+                batch->Draw(sprites->White(), nb, NAME_BOX_COLOR, render::LAYER_DIALOGUE);
+                if (glyphs)
+                    glyphs->DrawText(*batch,
+                                     currentName,
+                                     70,
+                                     screenHeight * 0.751f - 60,
+                                     {255, 255, 255, 255},
+                                     render::LAYER_DIALOGUE_TEXT);
             }
 
-            std::string visible = currentText.substr(0, displayedChars);
-            auto textTex = RenderText(visible, {255, 255, 255, 255});
-            if (textTex) {
-                float w, h;
-                SDL_GetTextureSize(textTex, &w, &h);
-                float margin = 70;
-                float maxW = screenWidth - 2 * margin;
-                float scale = w > maxW ? maxW / w : 1.0f;
-                SDL_FRect dst{margin, screenHeight * 0.80f, w * scale, h * scale};
-                SDL_RenderTexture(renderer, textTex, nullptr, &dst);
-                SDL_DestroyTexture(textTex);
-            }
+            if (glyphs)
+                glyphs->Draw(*batch, dialogueMesh, render::LAYER_DIALOGUE_TEXT);
         }
     }
 
+    // Glyphs rasterized since the previous call; feeds the per-frame counter.
+    uint64_t TakeGlyphMisses()
+    {
+        const uint64_t misses = glyphs ? glyphs->Stats().misses : 0;
+        const uint64_t delta = misses - lastGlyphMisses;
+        lastGlyphMisses = misses;
+        return delta;
+    }
+
     // Private helpers
     SDL_Renderer *CreateBestRenderer(SDL_Window *window)
     {
         const char *preferred_drivers[] = {"gpu", "vulkan", "opengl", "opengles2"};
         const int num_preferred = sizeof(preferred_drivers) / sizeof(preferred_drivers[0]);
 
+        // An explicit driver hint (e.g. "software" for headless runs) wins.
+        const bool hinted = SDL_GetHint(SDL_HINT_RENDER_DRIVER) != nullptr;
+
         for (int i = 0; i < num_preferred; ++i) {
-            const char *name = preferred_drivers[i];
+            const char *name = hinted ? nullptr : preferred_drivers[i];
             SDL_Renderer *renderer = SDL_CreateRenderer(window, name);
             if (renderer) {
-                SDL_Log("Successfully created renderer: %s", name);
+                CEREKA_LOG_INFO("created renderer: {}", SDL_GetRendererName(renderer));
 
-                if (SDL_SetRenderVSync(renderer, 1)) {
-                    SDL_Log("VSync enabled successfully.");
+                if (!SDL_GetHintBoolean(SDL_HINT_RENDER_VSYNC, true)) {
+                    CEREKA_LOG_INFO("vsync disabled by hint");
+                }
+                else if (SDL_SetRenderVSync(renderer, 1)) {
+                    CEREKA_LOG_INFO("vsync enabled");
                 }
                 else {
-                    std::cerr << "Warning: VSync failed (" << SDL_GetError()
-                              << "), continuing without it.\n";
+                    CEREKA_LOG_WARN("vsync failed ({}), continuing without it", SDL_GetError());
                 }
 
                 return renderer;
             }
             else {
-                std::cout << "Failed to create renderer '" << name << "': " << SDL_GetError()
-                          << "\n";
+                CEREKA_LOG_WARN(
+                    "failed to create renderer '{}': {}", name ? name : "hinted", SDL_GetError());
             }
+            // The hinted attempt was the nullptr fallback below; don't repeat it.
+            if (hinted)
+                return nullptr;
         }
 
         SDL_Renderer *renderer = SDL_CreateRenderer(window, nullptr);
         if (renderer) {
-            std::cout << "Fallback renderer created.\n";
+            CEREKA_LOG_INFO("fallback renderer created: {}", SDL_GetRendererName(renderer));
         }
         return renderer;
     }
 
-    SDL_Texture *LoadTexture(const std::string &path)
+    // Asset names, resolved against mounted packs and then the asset root.
+    static std::string BackgroundPath(std::string_view name)
+    {
+        return "bg/" + std::string(name);
+    }
+
+    static std::string CharacterPath(std::string_view id)
+    {
+        return "characters/" + std::string(id) + "_normal.jpg";
+    }
+
+    static std::string MusicPath(std::string_view name)
+    {
+        return "bgm/" + std::string(name);
+    }
+
+    static std::string SoundPath(std::string_view name)
+    {
+        return "sfx/" + std::string(name);
+    }
+
+    static std::string VoicePath(std::string_view name)
+    {
+        return "voice/" + std::string(name);
+    }
+
+    // Shrink a decoded image to the size Draw() will put it on screen at.
+    // Runs on the prefetch workers; screenWidth/screenHeight do not change
+    // after InitGame().
+    SDL_Surface *Prescale(const std::string &path,
+                          SDL_Surface *surface)
+    {
+        const uint64_t before = uint64_t(surface->w) * surface->h * 4;
+        surface = render::PrescaleForDisplay(path, surface, screenWidth, screenHeight);
+        const uint64_t after = uint64_t(surface->w) * surface->h * 4;
+        if (after < before) {
+            prescaledImages.fetch_add(1, std::memory_order_relaxed);
+            prescaleSavedBytes.fetch_add(before - after, std::memory_order_relaxed);
+        }
+        return surface;
+    }
+
+    // Texture cache loader: upload a prefetched surface if one is ready,
+    // otherwise decode in place.
+    SDL_Texture *LoadImageTexture(const std::string &path)
     {
-        SDL_Texture *tex = IMG_LoadTexture(this->renderer, ("assets/bg/" + path).c_str());
-        if (!tex)
-            std::cerr << "Failed to load bg: " << path << " - " << SDL_GetError() << '\n';
+        CEREKA_TRACE_ZONE("LoadTexture");
+        SDL_Texture *tex = nullptr;
+        SDL_Surface *surf = prefetcher ? prefetcher->Take(path) : nullptr;
+        if (!surf) {
+            assets::AssetBytes asset = assetSource.Read(path);
+            const auto bytes = asset.Bytes();
+            if (!asset) {
+                SDL_SetError("asset not found");
+            }
+            else if (const assets::TextureFileHeader *h = assets::ReadTextureHeader(bytes)) {
+                // Pre-decoded .ctex images already at their draw size upload
+                // straight from the mapped bytes.
+                const SDL_Point size = render::DrawSize(
+                    path, int(h->width), int(h->height), screenWidth, screenHeight);
+                if (size.x >= int(h->width) || size.y >= int(h->height))
+                    tex = assets::UploadTextureFile(this->renderer, bytes);
+                else
+                    surf = assets::DecodeTextureFile(bytes);
+            }
+            else {
+                surf = IMG_Load_IO(SDL_IOFromConstMem(bytes.data(), bytes.size()), true);
+            }
+            if (surf)
+                surf = Prescale(path, surf);
+        }
+        if (surf) {
+            tex = SDL_CreateTextureFromSurface(this->renderer, surf);
+            SDL_DestroySurface(surf);
+        }
+        if (tex)
+            textureUploads++;
+        else
+            CEREKA_LOG_ERROR("failed to load image '{}': {}", path, SDL_GetError());
         return tex;
     }
 
+    assets::TextureHandle LoadTexture(const std::string &path)
+    {
+        if (!textures)
+            return {};
+        return textures->Acquire(path);
+    }
+
     void LoadCompiledScript(const std::vector<scenario::Instruction> &compiled)
     {
-        program = compiled;
-        pc = 0;
+        LoadProgram(scenario::Bytecode::Build(compiled));
+    }
+
+    std::shared_ptr<const scenario::Bytecode> Program() const
+    {
+        return program;
+    }
+
+    void LoadBytecode(const std::string &path)
+    {
+        LoadProgram(scenario::Bytecode::Map(path));
+    }
+
+    std::shared_ptr<const scenario::ProgramAnalysis> Analysis() const
+    {
+        return analysis;
+    }
+
+    void LoadProgram(std::shared_ptr<const scenario::Bytecode> code)
+    {
+        // Validate before touching any state, so a broken script leaves the
+        // current one running.
+        std::shared_ptr<const scenario::ProgramAnalysis> checked =
+            scenario::ProgramAnalysis::Analyze(code);
+        AdoptProgram(std::move(code), std::move(checked));
+        luaActive = false;
+        skipMode = SkipMode::Off;
         scriptFinished = false;
+        state = CerekaState::Running;
+        ExitMenu();
+
+        // auto-start at first menu
+        pc = analysis->EntryPoint();
 
-        // build label map
-        labelMap.clear();
-        for (size_t i = 0; i < program.size(); ++i) {
-            if (program[i].op == scenario::Op::LABEL)
-                labelMap[program[i].a] = i;
+        prefetchedAt = size_t(-1);
+        SchedulePrefetch();
+    }
+
+    void AdoptProgram(std::shared_ptr<const scenario::Bytecode> code,
+                      std::shared_ptr<const scenario::ProgramAnalysis> checked)
+    {
+        for (const std::string &warning : checked->Warnings())
+            CEREKA_LOG_WARN("{}", warning);
+        // Keep what was read since the last save; Reset() below drops it.
+        try {
+            SaveReadHistory();
+        }
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("could not save read history: {}", e.what());
         }
+        program = std::move(code);
+        analysis = std::move(checked);
+        programHash = hash::Fnv1a64(program->Image(), program->ImageSize());
+        readHistory.Reset(program->Size(), programHash);
+        if (!readHistoryPath.empty())
+            readHistory.Load(readHistoryPath);
+    }
 
-        // auto-start at first menu
-        for (size_t i = 0; i < program.size(); ++i) {
-            if (program[i].op == scenario::Op::MENU) {
-                pc = i;
+    static std::string NormalPath(const std::string &path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    void EnableHotReload(const std::vector<std::string> &files)
+    {
+        reloadScripts.clear();
+        for (const std::string &file : files)
+            reloadScripts.push_back(NormalPath(file));
+        reloadAssetRoot = NormalPath(assetSource.Root());
+        if (!reloadCompiler)
+            reloadCompiler = std::make_unique<scenario::ProjectCompiler>();
+        LoadCompiledScript(reloadCompiler->Compile(reloadScripts));
+
+        std::vector<std::string> dirs{reloadAssetRoot};
+        for (const std::string &file : reloadScripts) {
+            std::string dir = std::filesystem::path(file).parent_path().generic_string();
+            if (dir.empty())
+                dir = ".";
+            if (std::find(dirs.begin(), dirs.end(), dir) == dirs.end())
+                dirs.push_back(std::move(dir));
+        }
+        watcher = std::make_unique<io::FileWatcher>();
+        for (const std::string &dir : dirs) {
+            if (!watcher->Watch(dir))
+                CEREKA_LOG_WARN("hot reload: cannot watch '{}'", dir);
+        }
+        CEREKA_LOG_INFO("hot reload: watching {} scripts and '{}'",
+                        reloadScripts.size(),
+                        reloadAssetRoot);
+    }
+
+    // Apply whatever changed on disk since the last call. Returns true if
+    // anything was reloaded, i.e. a frame is due.
+    bool PollHotReload()
+    {
+        if (!watcher)
+            return false;
+        const std::vector<std::string> changed = watcher->Poll();
+        if (changed.empty())
+            return false;
+
+        CEREKA_TRACE_ZONE("HotReload");
+        const Uint64 start = SDL_GetTicksNS();
+        bool scriptChanged = false;
+        bool reloaded = false;
+        for (const std::string &path : changed) {
+            const std::string file = NormalPath(path);
+            if (std::find(reloadScripts.begin(), reloadScripts.end(), file) != reloadScripts.end())
+                scriptChanged = true;
+            else
+                reloaded |= ReloadAsset(file);
+        }
+        if (scriptChanged)
+            reloaded |= ReloadScript();
+        if (reloaded) {
+            lastReloadNs = SDL_GetTicksNS() - start;
+            DamageAll();
+        }
+        return reloaded;
+    }
+
+    // Swap a changed image in under the handles that show it. Images not in
+    // the cache are simply loaded fresh the next time they are needed.
+    bool ReloadAsset(const std::string &file)
+    {
+        const std::string name =
+            std::filesystem::path(file).lexically_relative(reloadAssetRoot).generic_string();
+        if (name.empty() || name.starts_with(".."))
+            return false;
+        if (prefetcher)
+            prefetcher->Invalidate(name);
+        if (!textures || !textures->Reload(name))
+            return false;
+        assetReloads++;
+        SceneChanged();
+        CEREKA_LOG_INFO("hot reload: {}", name);
+        return true;
+    }
+
+    // Recompile (the project compiler's cache makes that the changed file
+    // only), validate, and swap the new program in at the equivalent
+    // position. A script that does not compile leaves the running one alone.
+    bool ReloadScript()
+    {
+        if (luaActive) {
+            CEREKA_LOG_WARN("hot reload: a Lua script is running, not reloading");
+            return false;
+        }
+        const Uint64 start = SDL_GetTicksNS();
+        std::shared_ptr<const scenario::Bytecode> code;
+        std::shared_ptr<const scenario::ProgramAnalysis> checked;
+        try {
+            code = scenario::Bytecode::Build(reloadCompiler->Compile(reloadScripts));
+            checked = scenario::ProgramAnalysis::Analyze(code);
+        }
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("hot reload failed, keeping the running script:\n{}", e.what());
+            return false;
+        }
+
+        // The instruction the player is looking at: the line on screen or
+        // the open menu, otherwise the next one to run.
+        const bool blocked = state == CerekaState::WaitingForInput || state == CerekaState::InMenu;
+        const size_t anchor = blocked && pc > 0 ? pc - 1 : pc;
+        const size_t oldPc = pc;
+        const size_t target = RemapPosition(*program, *code, *checked, anchor);
+
+        AdoptProgram(std::move(code), std::move(checked));
+        skipMode = SkipMode::Off;
+        const scenario::Bytecode &next = *program;
+        const scenario::Op op = target < next.Size() ? next.OpAt(target) : scenario::Op::END;
+        if (state == CerekaState::InMenu) {
+            // Button targets point into the old program; rebuild the menu.
+            ExitMenu();
+            pc = target;
+            if (analysis->MenuAt(pc)) {
+                EnterMenu();
+                pc++;
+            }
+            else {
+                state = CerekaState::Running;
+            }
+        }
+        else if (state == CerekaState::WaitingForInput &&
+                 (op == scenario::Op::SAY || op == scenario::Op::NARRATE))
+        {
+            // Keep the line on screen unless it was the one edited.
+            const std::string_view speaker = op == scenario::Op::SAY ? next.A(target) : "";
+            if (next.B(target) != currentText || speaker != currentSpeaker) {
+                if (op == scenario::Op::SAY)
+                    Say(speaker, speaker, next.B(target));
+                else
+                    Narrate(next.B(target));
+            }
+            pc = target + 1;
+        }
+        else {
+            pc = target;
+            if (state == CerekaState::WaitingForInput)
+                state = CerekaState::Running;
+        }
+        prefetchedAt = size_t(-1);
+        SchedulePrefetch();
+
+        scriptReloads++;
+        CEREKA_LOG_INFO("hot reload: script swapped, pc {} -> {} in {:.1f} ms",
+                        oldPc,
+                        pc,
+                        (SDL_GetTicksNS() - start) / 1e6);
+        return true;
+    }
+
+    // Where execution at `at` in `from` continues in `to`: the same
+    // occurrence of the same opcode after the nearest LABEL before it, or if
+    // that line is gone, the label itself. Without a label to go by, the
+    // count starts at the top of the program.
+    static size_t RemapPosition(const scenario::Bytecode &from,
+                                const scenario::Bytecode &to,
+                                const scenario::ProgramAnalysis &toAnalysis,
+                                size_t at)
+    {
+        if (at >= from.Size())
+            return to.Size();
+
+        size_t oldStart = 0, newStart = 0;
+        std::string_view label;
+        for (size_t i = at + 1; i-- > 0;) {
+            if (from.OpAt(i) == scenario::Op::LABEL) {
+                oldStart = i;
+                label = from.A(i);
                 break;
             }
         }
+        if (!label.empty()) {
+            const std::optional<size_t> found = to.FindLabel(label);
+            if (!found) {
+                CEREKA_LOG_WARN("hot reload: label '{}' is gone, restarting", label);
+                return toAnalysis.EntryPoint();
+            }
+            newStart = *found;
+        }
+
+        const scenario::Op op = from.OpAt(at);
+        size_t occurrence = 0;
+        for (size_t i = oldStart; i < at; ++i)
+            occurrence += from.OpAt(i) == op;
+        for (size_t i = newStart; i < to.Size(); ++i) {
+            if (i > newStart && to.OpAt(i) == scenario::Op::LABEL)
+                break;
+            if (to.OpAt(i) == op && occurrence-- == 0)
+                return i;
+        }
+        CEREKA_LOG_WARN("hot reload: line is gone, continuing from the top of its section");
+        return newStart;
     }
 
     void AdvanceScriptOnce()
     {
-        if (scriptFinished || pc >= program.size())
+        const scenario::Bytecode &code = *program;
+        if (scriptFinished || pc >= code.Size())
             return;
 
-        const scenario::Instruction &ins = program[pc];
-        printf("Advance pc=%zu op=%d  a='%s'\n", pc, static_cast<int>(ins.op), ins.a.c_str());
+        const scenario::Op op = code.OpAt(pc);
+        CEREKA_LOG_DEBUG("advance pc={} op={} a='{}'", pc, op, code.A(pc));
 
-        switch (ins.op) {
+        switch (op) {
             case scenario::Op::BG:
-                ShowBackground(ins.a);
+                ShowBackground(code.A(pc));
                 pc++;
                 break;
             case scenario::Op::CHAR:
-                ShowCharacter(ins.a, ins.b);
+                ShowCharacter(code.A(pc), code.B(pc));
+                pc++;
+                break;
+            case scenario::Op::HIDE:
+                HideCharacter(code.A(pc));
                 pc++;
                 break;
             case scenario::Op::SAY:
-                Say(ins.a, ins.a, ins.b);
+                StartLine();
+                Say(code.A(pc), code.A(pc), code.B(pc));
                 pc++;
                 break;
             case scenario::Op::NARRATE:
-                Narrate(ins.b);
+                StartLine();
+                Narrate(code.B(pc));
+                pc++;
+                break;
+            case scenario::Op::BGM:
+                PlayMusic(code.A(pc));
+                pc++;
+                break;
+            case scenario::Op::SFX:
+                PlaySound(code.A(pc));
+                pc++;
+                break;
+            case scenario::Op::VOICE:
+                PlayVoice(code.A(pc));
                 pc++;
                 break;
             case scenario::Op::BUTTON:
-                buttonTexts.push_back(ins.a);
-                buttonTargets.push_back(ins.b);
-                buttonExits.push_back(ins.exit_button);
-                printf("BUTTON pushed  txt=%s  btn.size=%zu\n", ins.a.c_str(), buttonTexts.size());
+                menu.Add({std::string(code.A(pc)), TargetOr(pc, pc + 1), code.ExitButton(pc)});
+                CEREKA_LOG_DEBUG("button '{}' ({} so far)", code.A(pc), menu.Size());
                 pc++;
                 break;
                 break;
             case scenario::Op::JUMP:
-                if (labelMap.count(ins.a)) {
-                    pc = labelMap[ins.a];
-                }
-                else {
-                    std::cerr << "[ERROR] Unknown label: " << ins.a << "\n";
-                    pc++;
-                }
+                pc = TargetOr(pc, pc + 1);
                 break;
             case scenario::Op::END:
                 scriptFinished = true;
@@ -484,134 +1453,394 @@ class CerekaEngine::Implementation {
         }
     }
 
-    void ShowBackground(const std::string &f)
+    // Pre-resolved target of the JUMP or BUTTON at `i`, or `fallback` if it
+    // has no label or the label does not exist.
+    size_t TargetOr(size_t i,
+                    size_t fallback) const
     {
-        if (this->background) {
-            SDL_DestroyTexture(this->background);
-        }
-        this->background = LoadTexture(f);
+        const uint32_t target = program->Target(i);
+        if (target != scenario::NO_TARGET)
+            return target;
+
+        std::string_view label =
+            program->OpAt(i) == scenario::Op::JUMP ? program->A(i) : program->B(i);
+        if (!label.empty())
+            CEREKA_LOG_ERROR("unknown label: {}", label);
+        return fallback;
     }
 
-    void ShowCharacter(const std::string &id,
-                       const std::string &)
+    void ShowBackground(std::string_view f)
     {
-        HideCharacter(id);
-        std::string path = "assets/characters/" + id + "_normal.jpg";
-        SDL_Texture *tex = IMG_LoadTexture(this->renderer, path.c_str());
-        if (tex)
-            this->characters[id] = tex;
+        this->background = LoadTexture(BackgroundPath(f));
+        this->backgroundId = f;
+        SceneChanged();
     }
 
-    void HideCharacter(const std::string &id)
+    void ShowCharacter(std::string_view id,
+                       std::string_view expression)
     {
-        auto it = this->characters.find(id);
-        if (it != this->characters.end()) {
-            SDL_DestroyTexture(it->second);
-            this->characters.erase(it);
+        assets::TextureHandle tex = LoadTexture(CharacterPath(id));
+        if (tex) {
+            this->characters[std::string(id)] = std::move(tex);
+            this->expressions[std::string(id)] = expression;
+            SceneChanged();
+        }
+        else {
+            HideCharacter(id);
         }
     }
 
-    void Say(const std::string &speaker,
-             const std::string &name,
-             const std::string &text)
+    void HideCharacter(std::string_view id)
+    {
+        this->characters.erase(std::string(id));
+        this->expressions.erase(std::string(id));
+        SceneChanged();
+    }
+
+    void PlayMusic(std::string_view name)
+    {
+        if (audio)
+            audio->PlayMusic(name.empty() ? std::string() : MusicPath(name));
+        musicId = name;
+    }
+
+    void PlaySound(std::string_view name)
+    {
+        if (audio)
+            audio->PlaySound(SoundPath(name));
+    }
+
+    void PlayVoice(std::string_view name)
+    {
+        if (audio)
+            audio->PlayVoice(VoicePath(name));
+        voiceQueued = true;
+    }
+
+    void StopVoice()
+    {
+        if (audio)
+            audio->StopVoice();
+        voiceQueued = false;
+    }
+
+    // A new line cuts off the previous line's voice unless a VOICE
+    // instruction just started one for it.
+    void StartLine()
+    {
+        if (!voiceQueued)
+            StopVoice();
+        voiceQueued = false;
+    }
+
+    void Say(std::string_view speaker,
+             std::string_view name,
+             std::string_view text)
     {
         this->currentSpeaker = speaker;
         this->currentName = name;
         this->currentText = text;
-        this->displayedChars = 0;
-        this->typewriterTimer = 0.0f;
+        this->dialogueLayout = {};
+        if (glyphs) {
+            const SDL_FRect box = DialogueTextRect();
+            const int maxLines = int(box.h / std::max(1, glyphs->LineSkip()));
+            this->dialogueLayout = text_renderer::LayoutText(*glyphs, text, box.w, maxLines);
+        }
+        ShowDialoguePage(0);
     }
 
-    void Narrate(const std::string &text)
+    void Narrate(std::string_view text)
     {
         Say("", "Narrator", text);
     }
 
-    SDL_Texture *CreateSolidTexture(int w,
-                                    int h,
-                                    Uint8 r,
-                                    Uint8 g,
-                                    Uint8 b,
-                                    Uint8 a)
-    {
-        SDL_Texture *texture = SDL_CreateTexture(
-            this->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
-        if (!texture) {
-            return nullptr;
-        }
-        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderTarget(this->renderer, texture);
-        SDL_SetRenderDrawColor(this->renderer, r, g, b, a);
-        SDL_RenderClear(this->renderer);
-        SDL_SetRenderTarget(this->renderer, nullptr);
-        return texture;
-    }
-
-    SDL_Texture *RenderText(const std::string &text,
-                            SDL_Color color)
-    {
-        if (text.empty() || !this->font)
-            return nullptr;
-        SDL_Surface *surf = TTF_RenderText_Blended(this->font, text.c_str(), text.size(), color);
-        if (!surf)
-            return nullptr;
-        SDL_Texture *tex = SDL_CreateTextureFromSurface(this->renderer, surf);
-        SDL_DestroySurface(surf);
-        return tex;
+    CerekaStats Stats() const
+    {
+        CerekaStats s;
+        s.textureUploads = textureUploads;
+        s.prescaledImages = prescaledImages.load(std::memory_order_relaxed);
+        s.prescaleSavedBytes = prescaleSavedBytes.load(std::memory_order_relaxed);
+        if (glyphs) {
+            s.glyphHits = glyphs->Stats().hits;
+            s.glyphMisses = glyphs->Stats().misses;
+        }
+        if (prefetcher) {
+            const auto p = prefetcher->Stats();
+            s.prefetchHits = p.hits;
+            s.prefetchMisses = p.misses;
+        }
+        if (textures) {
+            const auto &t = textures->Stats();
+            s.textureResidentBytes = t.residentBytes;
+            s.textureHits = t.hits;
+            s.textureMisses = t.misses;
+            s.textureEvictions = t.evictions;
+        }
+        if (batch) {
+            s.drawCalls = batch->Stats().drawCalls;
+            s.textureSwitches = batch->Stats().textureSwitches;
+        }
+        if (sprites)
+            s.textureUploads += sprites->Uploads();
+        if (compositor) {
+            s.sceneRedraws = compositor->Stats().sceneRedraws;
+            s.redrawnPixels = compositor->Stats().redrawnPixels;
+        }
+        if (audio) {
+            const auto a = audio->Stats();
+            s.soundHits = a.soundHits;
+            s.soundMisses = a.soundMisses;
+            s.voicePrefetchHits = a.voiceHits;
+            s.voicePrefetchMisses = a.voiceMisses;
+        }
+        s.scriptReloads = scriptReloads;
+        s.assetReloads = assetReloads;
+        s.lastReloadNs = lastReloadNs;
+        if (luaRuntime) {
+            const auto &l = luaRuntime->Stats();
+            s.scriptResumes = l.resumes;
+            s.scriptResumeNs = l.resumeNs;
+            s.scriptMaxResumeNs = l.maxResumeNs;
+        }
+        return s;
     }
+
     void ExitMenu()
     {
         inMenu = false;
-        buttonTexts.clear();
-        buttonTargets.clear();
-        buttonExits.clear();
-        std::cout << "[MENU] Exited menu, buttons cleared." << std::endl;
+        menu.Clear();
+        DamageAll();
+        CEREKA_LOG_DEBUG("exited menu, buttons cleared");
     }
     void LoadScript(const std::string &filename)
     {
-        std::cout << "[DEBUG] Loading script: " << filename << std::endl;
-        sol::load_result chunk = lua.load_file(filename);
-        if (!chunk.valid()) {
-            sol::error err = chunk;
-            std::cerr << "[ERROR] Lua load error in " << filename << ": " << err.what() << "\n";
+        CEREKA_LOG_DEBUG("loading script: {}", filename);
+        if (!luaRuntime)
+            luaRuntime = std::make_unique<scripting::LuaRuntime>(luaHost);
+        luaRuntime->SetCacheDir(luaCacheDir);
+        try {
+            luaRuntime->Load(filename);
+        }
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("{}", e.what());
             return;
         }
-        script = sol::coroutine(chunk);
-        scriptFinished = false;
-        std::cout << "[DEBUG] Script loaded successfully, starting execution..." << std::endl;
-        std::cout << "[DEBUG] Initial run complete. Status: " << (int)script.status();
+
+        LoadProgram(scenario::Bytecode::Build({}));
+        luaActive = true;
+        pendingChoice = 0;
+    }
+
+    // Run the Lua script up to its next yield; the host callbacks move
+    // `state` to WaitingForInput or InMenu when it blocks.
+    void ResumeLua()
+    {
+        const int choice = pendingChoice;
+        pendingChoice = 0;
+        if (!luaRuntime->Resume(choice) && state == CerekaState::Running) {
+            state = CerekaState::Finished;
+            scriptFinished = true;
+        }
+    }
+
+    void OpenScriptMenu(const std::vector<std::string> &choices)
+    {
+        ExitMenu();
+        for (size_t i = 0; i < choices.size(); ++i) {
+            menu.Add({choices[i], i, false});
+        }
+        menu.Layout(screenWidth, screenHeight);
+        inMenu = true;
+        DamageAll();
+        state = CerekaState::InMenu;
     }
 
     void Reset()
     {
         this->currentText.clear();
-        this->displayedChars = 0;
-        this->typewriterTimer = 0.0f;
+        this->dialogueLayout = {};
+        ShowDialoguePage(0);
         this->currentSpeaker.clear();
         this->currentName.clear();
-        if (this->background) {
-            SDL_DestroyTexture(this->background);
-            this->background = nullptr;
-        }
+        this->background.Reset();
+        this->backgroundId.clear();
         this->characters.clear();
+        this->expressions.clear();
+        SceneChanged();
+        PlayMusic("");
+        StopVoice();
     }
 
-    int HitTestButton(int mx,
-                      int my)
+    save::Snapshot Capture() const
     {
-        float y = screenHeight * 0.4f;
-        const float h = 80;
-        const float spacing = 20;
-        float x = screenWidth / 2.0f - 300;
+        save::Snapshot s;
+        s.programHash = programHash;
+        s.pc = uint32_t(pc);
+        s.menuEndPC = uint32_t(menuEndPC);
+        s.state = uint8_t(state);
+        s.scriptFinished = scriptFinished;
+        s.speaker = currentSpeaker;
+        s.name = currentName;
+        s.text = currentText;
+        s.dialoguePage = uint32_t(dialoguePage);
+        s.revealed = uint32_t(revealed);
+        s.background = backgroundId;
+        for (const auto &[id, handle] : characters)
+            s.characters.push_back(id);
+        s.music = musicId;
+        s.inMenu = inMenu;
+        for (const auto &item : menu.Items())
+            s.buttons.push_back({item.text, uint32_t(item.target), item.exit});
+        return s;
+    }
 
-        for (size_t i = 0; i < buttonTexts.size(); ++i) {
-            SDL_FRect r{x, y, 600, h};
-            if (mx >= r.x && mx <= r.x + r.w && my >= r.y && my <= r.y + r.h) {
-                return (int)i;
-            }
-            y += h + spacing;
+    void Restore(const save::Snapshot &s)
+    {
+        if (s.programHash != programHash)
+            throw engine::error("Save was made with a different script");
+        if (s.pc > program->Size() || s.menuEndPC > program->Size() ||
+            s.state > uint8_t(CerekaState::Finished))
+        {
+            throw engine::error("Save does not match the loaded script");
+        }
+        for (const auto &b : s.buttons) {
+            if (b.target > program->Size())
+                throw engine::error("Save does not match the loaded script");
+        }
+
+        Reset();
+        ExitMenu();
+        skipMode = SkipMode::Off;
+        if (!s.background.empty())
+            ShowBackground(s.background);
+        for (const auto &id : s.characters)
+            ShowCharacter(id, "");
+        PlayMusic(s.music);
+
+        pc = s.pc;
+        menuEndPC = s.menuEndPC;
+        state = CerekaState(s.state);
+        scriptFinished = s.scriptFinished;
+
+        if (!s.text.empty()) {
+            Say(s.speaker, s.name, s.text);
+            if (s.dialoguePage < dialogueLayout.PageCount())
+                ShowDialoguePage(s.dialoguePage);
+            if (glyphs)
+                RevealGlyphs(std::min<size_t>(s.revealed, dialogueLayout.PageEnd(dialoguePage)));
+        }
+
+        if (s.inMenu) {
+            for (const auto &b : s.buttons)
+                menu.Add({b.text, b.target, b.exit});
+            menu.Layout(screenWidth, screenHeight);
+            inMenu = true;
+        }
+
+        prefetchedAt = size_t(-1);
+        SchedulePrefetch();
+        DamageAll();
+    }
+
+    void SaveGame(const std::string &path)
+    {
+        if (luaActive)
+            throw engine::error("Lua scripts cannot be saved");
+        CEREKA_TRACE_ZONE("SaveGame");
+        save::Serialize(Capture(), saveBuffer);
+        save::WriteFileAtomic(path, save::Pack(saveBuffer.data(), saveBuffer.size(), true));
+    }
+
+    void LoadGame(const std::string &path)
+    {
+        CEREKA_TRACE_ZONE("LoadGame");
+        Restore(save::ReadSnapshot(path));
+    }
+
+    void SetAutosavePath(const std::string &path)
+    {
+        autosavePath = path;
+        if (!autosavePath.empty() && !autosaver)
+            autosaver = std::make_unique<save::Autosaver>();
+    }
+
+    void Autosave()
+    {
+        if (autosavePath.empty() || !autosaver || luaActive)
+            return;
+        CEREKA_TRACE_ZONE("Autosave.Capture");
+        save::Serialize(Capture(), saveBuffer);
+        autosaver->Save(autosavePath, saveBuffer);
+    }
+
+    void StartRecording(const std::string &path)
+    {
+        if (luaActive)
+            throw engine::error("Lua scripts cannot be recorded");
+        StopRecording();
+        std::vector<std::byte> start;
+        save::Serialize(Capture(), start);
+        recorder = std::make_unique<replay::InputRecorder>(
+            path, screenWidth, screenHeight, programHash, std::move(start), readHistory.Words());
+        CEREKA_LOG_INFO("recording input to {}", path);
+    }
+
+    void StopRecording()
+    {
+        if (!recorder)
+            return;
+        std::unique_ptr<replay::InputRecorder> done = std::move(recorder);
+        done->Finish();
+        CEREKA_LOG_INFO("recorded {} frames to {}", done->Frames(), done->Path());
+    }
+
+    void StartReplay(const std::string &path)
+    {
+        auto log = std::make_unique<replay::InputLog>(replay::ReadInputLog(path));
+        if (log->programHash != programHash)
+            throw engine::error("Recording '%s' was made with a different script", path.c_str());
+        if (log->width != screenWidth || log->height != screenHeight)
+            throw engine::error("Recording '%s' was made at %dx%d, the window is %dx%d",
+                                path.c_str(),
+                                log->width,
+                                log->height,
+                                screenWidth,
+                                screenHeight);
+        Restore(log->start);
+        // Read-mode skip stops at unread lines; start from the same marks.
+        readHistory.SetWords(log->readHistory);
+        replayLog = std::move(log);
+        replayFrame = 0;
+        CEREKA_LOG_INFO("replaying {} frames from {}", replayLog->frames.size(), path);
+    }
+
+    // Feed the next recorded frame's input; false once the recording ends.
+    bool ReplayFrame(float &dt)
+    {
+        if (!replayLog)
+            return false;
+        if (replayFrame >= replayLog->frames.size()) {
+            replayLog.reset();
+            replaySkipSteps.reset();
+            return false;
+        }
+        const replay::InputFrame &frame = replayLog->frames[replayFrame++];
+        for (const replay::InputAction &action : frame.actions) {
+            if (action.kind == replay::InputAction::Event)
+                HandleEvent(action.event);
+            else
+                SetSkipMode(action.skip);
         }
-        return -1;
+        replaySkipSteps = frame.skipSteps;
+        dt = frame.dt;
+        return true;
+    }
+
+    int HitTestButton(int mx,
+                      int my)
+    {
+        menu.Layout(screenWidth, screenHeight);
+        return menu.HitTest(float(mx), float(my));
     }
 };
 
@@ -640,6 +1869,77 @@ bool CerekaEngine::PollEvent(CerekaEvent &e)
     return pImplementation->PollEvent(e);
 }
 
+bool CerekaEngine::WaitEvent(CerekaEvent &e)
+{
+    return pImplementation->WaitEvent(e);
+}
+
+bool CerekaEngine::NeedsPresent() const
+{
+    return pImplementation->NeedsFrame();
+}
+
+bool CerekaEngine::IsAnimating() const
+{
+    return pImplementation->IsAnimating();
+}
+
+int CerekaEngine::HitTestButton(int mx,
+                                int my)
+{
+    return pImplementation->HitTestButton(mx, my);
+}
+
+void CerekaEngine::SetFrameCap(int fps)
+{
+    pImplementation->SetFrameCap(fps);
+}
+
+void CerekaEngine::SetScriptCacheDir(const std::string &dir)
+{
+    pImplementation->luaCacheDir = dir;
+}
+
+void CerekaEngine::SetSkipMode(SkipMode mode)
+{
+    pImplementation->SetSkipMode(mode);
+}
+
+SkipMode CerekaEngine::GetSkipMode() const
+{
+    return pImplementation->skipMode;
+}
+
+bool CerekaEngine::IsLineRead(size_t pc) const
+{
+    return pImplementation->readHistory.Seen(pc);
+}
+
+void CerekaEngine::SetReadHistoryPath(const std::string &path)
+{
+    pImplementation->SetReadHistoryPath(path);
+}
+
+void CerekaEngine::SaveReadHistory()
+{
+    pImplementation->SaveReadHistory();
+}
+
+void CerekaEngine::SaveGame(const std::string &path)
+{
+    pImplementation->SaveGame(path);
+}
+
+void CerekaEngine::LoadGame(const std::string &path)
+{
+    pImplementation->LoadGame(path);
+}
+
+void CerekaEngine::SetAutosavePath(const std::string &path)
+{
+    pImplementation->SetAutosavePath(path);
+}
+
 void CerekaEngine::Present()
 {
     pImplementation->Present();
@@ -695,6 +1995,60 @@ void CerekaEngine::LoadCompiledScript(const std::vector<scenario::Instruction> &
     pImplementation->LoadCompiledScript(compiled);
 }
 
+void CerekaEngine::LoadBytecode(const std::string &path)
+{
+    pImplementation->LoadBytecode(path);
+}
+
+void CerekaEngine::LoadProgram(std::shared_ptr<const scenario::Bytecode> program)
+{
+    pImplementation->LoadProgram(std::move(program));
+}
+
+std::shared_ptr<const scenario::Bytecode> CerekaEngine::Program() const
+{
+    return pImplementation->Program();
+}
+
+std::shared_ptr<const scenario::ProgramAnalysis> CerekaEngine::Analysis() const
+{
+    return pImplementation->Analysis();
+}
+
+void CerekaEngine::StartRecording(const std::string &path)
+{
+    pImplementation->StartRecording(path);
+}
+
+void CerekaEngine::StopRecording()
+{
+    pImplementation->StopRecording();
+}
+
+void CerekaEngine::StartReplay(const std::string &path)
+{
+    pImplementation->StartReplay(path);
+}
+
+bool CerekaEngine::ReplayFrame(float &dt)
+{
+    return pImplementation->ReplayFrame(dt);
+}
+
+void CerekaEngine::EnableHotReload(const std::vector<std::string> &scriptFiles)
+{
+    pImplementation->EnableHotReload(scriptFiles);
+}
+
+bool CerekaEngine::DumpTrace(const std::string &path)
+{
+    if (!trace::Enabled()) {
+        CEREKA_LOG_WARN("built without CEREKA_ENABLE_TRACING; nothing to dump");
+        return false;
+    }
+    return trace::WriteChromeTrace(path);
+}
+
 void CerekaEngine::AdvanceScriptOnce()
 {
     pImplementation->AdvanceScriptOnce();
@@ -711,7 +2065,7 @@ const std::string &CerekaEngine::CurrentText() const
 
 size_t CerekaEngine::ButtonCount() const
 {
-    return pImplementation->buttonTexts.size();
+    return pImplementation->menu.Size();
 }
 
 size_t CerekaEngine::ProgramCounter() const
@@ -723,3 +2077,43 @@ void CerekaEngine::TickScript()
 {
     return pImplementation->TickScript();
 }
+
+CerekaStats CerekaEngine::Stats() const
+{
+    return pImplementation->Stats();
+}
+
+void CerekaEngine::SetPrefetchLookahead(size_t instructions)
+{
+    pImplementation->prefetchLookahead = instructions;
+    pImplementation->prefetchedAt = size_t(-1);
+}
+
+void CerekaEngine::SetTextureBudget(size_t bytes)
+{
+    pImplementation->textureBudget = bytes;
+    if (pImplementation->textures)
+        pImplementation->textures->SetBudget(bytes);
+}
+
+void CerekaEngine::SetSoundCacheBudget(size_t bytes)
+{
+    pImplementation->soundBudget = bytes;
+    if (pImplementation->audio)
+        pImplementation->audio->SetSoundBudget(bytes);
+}
+
+void CerekaEngine::SetAssetRoot(const std::string &dir)
+{
+    if (pImplementation->renderer)
+        throw engine::error("SetAssetRoot() must be called before InitGame()");
+    pImplementation->assetSource.SetRoot(dir);
+}
+
+void CerekaEngine::MountAssetPack(const std::string &path)
+{
+    // The prefetch workers read the source without locking.
+    if (pImplementation->renderer)
+        throw engine::error("MountAssetPack() must be called before InitGame()");
+    pImplementation->assetSource.Mount(assets::AssetPack::Map(path));
+}
@@ -0,0 +1,246 @@
+#include "asset_pack.hpp"
+#include "Cereka/exceptions.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+
+namespace cereka::assets {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t AlignUp(uint64_t n,
+                 uint64_t alignment)
+{
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+bool EntryLess(const PackEntry &l,
+               std::string_view lname,
+               uint64_t hash,
+               std::string_view name)
+{
+    return std::tie(l.hash, lname) < std::tie(hash, name);
+}
+
+}  // namespace
+
+std::shared_ptr<const AssetPack> AssetPack::Map(const std::string &path)
+{
+    std::shared_ptr<AssetPack> pack(new AssetPack());
+    if (!pack->file.Open(path))
+        throw engine::error("Could not map asset pack '%s'", path.c_str());
+    pack->path = path;
+
+    const std::byte *data = pack->file.Data();
+    const uint64_t size = pack->file.Size();
+    if (size < sizeof(PackHeader))
+        throw engine::error("Asset pack '%s' is too small", path.c_str());
+
+    const auto *h = reinterpret_cast<const PackHeader *>(data);
+    if (std::memcmp(h->magic, PACK_MAGIC, sizeof(h->magic)) != 0)
+        throw engine::error("'%s' is not a Cereka asset pack", path.c_str());
+    if (h->version != PACK_VERSION)
+        throw engine::error("Asset pack '%s' has version %u, expected %u",
+                            path.c_str(),
+                            unsigned(h->version),
+                            unsigned(PACK_VERSION));
+
+    auto inBounds = [&](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+    if (h->entriesOffset % alignof(PackEntry) != 0 ||
+        !inBounds(h->entriesOffset, uint64_t(h->entryCount) * sizeof(PackEntry)) ||
+        !inBounds(h->namesOffset, h->namesSize))
+        throw engine::error("Asset pack '%s' has a corrupt index", path.c_str());
+
+    pack->header = h;
+    pack->entries = reinterpret_cast<const PackEntry *>(data + h->entriesOffset);
+    pack->names = reinterpret_cast<const char *>(data + h->namesOffset);
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        const PackEntry &e = pack->entries[i];
+        if (!inBounds(e.offset, e.size) || uint64_t(e.nameOffset) + e.nameLength > h->namesSize)
+            throw engine::error("Asset pack '%s' has a corrupt entry %u",
+                                path.c_str(),
+                                unsigned(i));
+    }
+
+    CEREKA_LOG_INFO("mounted asset pack {} ({} assets)", path, h->entryCount);
+    return pack;
+}
+
+std::string_view AssetPack::Name(size_t i) const
+{
+    return {names + entries[i].nameOffset, entries[i].nameLength};
+}
+
+std::optional<std::span<const std::byte>> AssetPack::Find(std::string_view name) const
+{
+    const uint64_t hash = hash::Fnv1a64(name);
+    const PackEntry *begin = entries;
+    const PackEntry *end = entries + header->entryCount;
+    const PackEntry *it = std::lower_bound(begin, end, hash, [&](const PackEntry &e, uint64_t h) {
+        return EntryLess(e, Name(size_t(&e - entries)), h, name);
+    });
+    if (it == end || it->hash != hash || Name(size_t(it - entries)) != name)
+        return std::nullopt;
+    return std::span<const std::byte>(file.Data() + it->offset, size_t(it->size));
+}
+
+AssetSource::AssetSource(std::string root) : root(std::move(root)) {}
+
+void AssetSource::SetRoot(std::string root)
+{
+    this->root = std::move(root);
+}
+
+void AssetSource::Mount(std::shared_ptr<const AssetPack> pack)
+{
+    packs.insert(packs.begin(), std::move(pack));
+}
+
+SDL_IOStream *AssetSource::Open(const std::string &name) const
+{
+    for (const auto &pack : packs) {
+        if (auto blob = pack->Find(name))
+            return SDL_IOFromConstMem(blob->data(), blob->size());
+    }
+    const std::string path = root.empty() ? name : root + "/" + name;
+    return SDL_IOFromFile(path.c_str(), "rb");
+}
+
+AssetBytes AssetSource::Read(const std::string &name) const
+{
+    AssetBytes asset;
+    for (const auto &pack : packs) {
+        if (auto blob = pack->Find(name)) {
+            asset.bytes = *blob;
+            asset.found = true;
+            return asset;
+        }
+    }
+    const std::string path = root.empty() ? name : root + "/" + name;
+    if (asset.file.Open(path)) {
+        asset.bytes = {asset.file.Data(), asset.file.Size()};
+        asset.found = true;
+    }
+    return asset;
+}
+
+PackStats WritePack(const std::string &dir,
+                    const std::string &output,
+                    size_t threads)
+{
+    CEREKA_TRACE_ZONE("WritePack");
+
+    struct Source {
+        std::string name;
+        fs::path path;
+        PackEntry entry{};
+    };
+    std::vector<Source> sources;
+
+    std::error_code ec, ignored;
+    const fs::path outputPath = fs::weakly_canonical(output, ignored);
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        // Packing into the source directory must not pack the output itself.
+        if (!it->is_regular_file() || fs::weakly_canonical(it->path(), ignored) == outputPath)
+            continue;
+        Source s;
+        s.name = it->path().lexically_relative(dir).generic_string();
+        s.path = it->path();
+        s.entry.hash = hash::Fnv1a64(s.name);
+        s.entry.size = it->file_size();
+        sources.push_back(std::move(s));
+    }
+    if (ec)
+        throw engine::error("Could not read directory '%s': %s",
+                            dir.c_str(),
+                            ec.message().c_str());
+
+    std::sort(sources.begin(), sources.end(), [](const Source &l, const Source &r) {
+        return std::tie(l.entry.hash, l.name) < std::tie(r.entry.hash, r.name);
+    });
+
+    PackHeader header{};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.version = PACK_VERSION;
+    header.entryCount = uint32_t(sources.size());
+    header.entriesOffset = AlignUp(sizeof(PackHeader), alignof(PackEntry));
+    header.namesOffset = header.entriesOffset + sources.size() * sizeof(PackEntry);
+
+    std::string names;
+    for (auto &s : sources) {
+        s.entry.nameOffset = uint32_t(names.size());
+        s.entry.nameLength = uint32_t(s.name.size());
+        names += s.name;
+    }
+    header.namesSize = names.size();
+
+    PackStats stats;
+    uint64_t cursor = header.namesOffset + header.namesSize;
+    for (auto &s : sources) {
+        cursor = AlignUp(cursor, PACK_ALIGNMENT);
+        s.entry.offset = cursor;
+        cursor += s.entry.size;
+        stats.bytes += s.entry.size;
+    }
+    stats.files = sources.size();
+
+    {
+        std::ofstream f(output, std::ios::binary | std::ios::trunc);
+        if (!f)
+            throw engine::error("Could not open '%s' for writing", output.c_str());
+        f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        f.seekp(std::streamoff(header.entriesOffset));
+        for (const auto &s : sources)
+            f.write(reinterpret_cast<const char *>(&s.entry), sizeof(PackEntry));
+        f.write(names.data(), std::streamsize(names.size()));
+        if (!f)
+            throw engine::error("Failed to write '%s'", output.c_str());
+    }
+    fs::resize_file(output, cursor, ec);
+    if (ec)
+        throw engine::error("Could not size '%s': %s", output.c_str(), ec.message().c_str());
+
+    // The layout is fixed, so workers copy files straight into their slots,
+    // each through its own stream.
+    threading::ThreadPool pool(threads);
+    std::mutex errorMutex;
+    std::string error;
+    const size_t workers = pool.Size();
+    for (size_t w = 0; w < workers; ++w) {
+        pool.Submit([&, w] {
+            std::fstream out(output, std::ios::binary | std::ios::in | std::ios::out);
+            for (size_t i = w; i < sources.size() && out; i += workers) {
+                const Source &s = sources[i];
+                io::MappedFile in;
+                if (!in.Open(s.path.string()) || in.Size() != s.entry.size) {
+                    std::lock_guard lock(errorMutex);
+                    error = "could not read '" + s.path.string() + "'";
+                    return;
+                }
+                out.seekp(std::streamoff(s.entry.offset));
+                out.write(reinterpret_cast<const char *>(in.Data()), std::streamsize(in.Size()));
+            }
+            if (!out) {
+                std::lock_guard lock(errorMutex);
+                error = "failed to write '" + output + "'";
+            }
+        });
+    }
+    pool.Wait();
+    if (!error.empty())
+        throw engine::error(error);
+    return stats;
+}
+
+}  // namespace cereka::assets
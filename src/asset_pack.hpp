@@ -0,0 +1,160 @@
+#pragma once
+#include "mapped_file.hpp"
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cereka::assets {
+
+/*
+ * Asset pack (.crkp), little-endian:
+ *
+ *   PackHeader
+ *   PackEntry[entryCount]   sorted by (hash, name)
+ *   char[namesSize]         entry names, not NUL-terminated
+ *   blobs                   each starting on a PACK_ALIGNMENT boundary
+ *
+ * Names are paths relative to the packed directory with '/' separators,
+ * e.g. "bg/street.png", and hash with FNV-1a. A pack is mapped once and
+ * assets are read straight out of the mapping.
+ */
+
+inline constexpr char PACK_MAGIC[4] = {'C', 'R', 'K', 'P'};
+inline constexpr uint32_t PACK_VERSION = 1;
+inline constexpr uint64_t PACK_ALIGNMENT = 64;
+
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t entriesOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct PackEntry {
+    uint64_t hash;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint64_t offset;
+    uint64_t size;
+};
+static_assert(sizeof(PackEntry) == 32);
+
+/**
+ * Read-only view of a memory-mapped asset pack.
+ */
+class AssetPack {
+   public:
+    /**
+     * Map a .crkp file. Throws engine::error if it is missing or malformed.
+     */
+    static std::shared_ptr<const AssetPack> Map(const std::string &path);
+
+    /**
+     * Bytes of the asset called `name`, pointing into the mapping.
+     */
+    std::optional<std::span<const std::byte>> Find(std::string_view name) const;
+
+    size_t Count() const
+    {
+        return header->entryCount;
+    }
+    std::string_view Name(size_t i) const;
+
+    const std::string &Path() const
+    {
+        return path;
+    }
+
+   private:
+    AssetPack() = default;
+
+    io::MappedFile file;
+    std::string path;
+    const PackHeader *header = nullptr;
+    const PackEntry *entries = nullptr;
+    const char *names = nullptr;
+};
+
+/**
+ * The bytes of one asset: a view into a mounted pack, or a mapping of a
+ * loose file that lives as long as this object.
+ */
+class AssetBytes {
+   public:
+    std::span<const std::byte> Bytes() const
+    {
+        return bytes;
+    }
+
+    explicit operator bool() const
+    {
+        return found;
+    }
+
+   private:
+    friend class AssetSource;
+
+    io::MappedFile file;
+    std::span<const std::byte> bytes;
+    bool found = false;
+};
+
+/**
+ * Where the engine reads assets from: mounted packs first, most recently
+ * mounted first, then loose files under a root directory.
+ *
+ * Mount packs before handing the source to worker threads; Open() is safe to
+ * call concurrently, Mount() is not.
+ */
+class AssetSource {
+   public:
+    explicit AssetSource(std::string root = "assets");
+
+    void SetRoot(std::string root);
+    const std::string &Root() const
+    {
+        return root;
+    }
+
+    void Mount(std::shared_ptr<const AssetPack> pack);
+
+    /**
+     * Open `name` (e.g. "bg/street.png") for reading. Packed assets are
+     * wrapped with SDL_IOFromConstMem, without copying. Returns nullptr if
+     * the asset is nowhere to be found. The caller owns the stream.
+     */
+    SDL_IOStream *Open(const std::string &name) const;
+
+    /**
+     * Map `name` into memory, for loaders that parse the bytes directly.
+     */
+    AssetBytes Read(const std::string &name) const;
+
+   private:
+    std::string root;
+    std::vector<std::shared_ptr<const AssetPack>> packs;
+};
+
+struct PackStats {
+    size_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * Pack every regular file under `dir` into `output`, copying files into
+ * place on `threads` workers (zero as for ThreadPool). Throws engine::error.
+ */
+PackStats WritePack(const std::string &dir,
+                    const std::string &output,
+                    size_t threads = 0);
+
+}  // namespace cereka::assets
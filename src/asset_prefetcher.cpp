@@ -0,0 +1,193 @@
+#include "asset_prefetcher.hpp"
+#include "texture_file.hpp"
+#include "trace.hpp"
+#include <SDL3_image/SDL_image.h>
+#include <deque>
+#include <unordered_set>
+
+namespace cereka::assets {
+
+std::vector<AssetRef> ScanAhead(const scenario::Bytecode &program,
+                                size_t pc,
+                                size_t window)
+{
+    std::vector<AssetRef> out;
+    std::unordered_set<size_t> visited;
+    std::deque<size_t> frontier{pc};
+    size_t budget = window;
+
+    auto follow = [&](uint32_t target) {
+        if (target != scenario::NO_TARGET)
+            frontier.push_back(target);
+    };
+
+    // Breadth-first over control flow so every branch gets its nearest
+    // instructions scanned before any branch gets its distant ones.
+    while (!frontier.empty() && budget > 0) {
+        size_t i = frontier.front();
+        frontier.pop_front();
+        if (i >= program.Size() || !visited.insert(i).second)
+            continue;
+        budget--;
+
+        switch (program.OpAt(i)) {
+            case scenario::Op::BG:
+                out.push_back({AssetKind::Background, std::string(program.A(i))});
+                frontier.push_back(i + 1);
+                break;
+            case scenario::Op::CHAR:
+                out.push_back({AssetKind::Character, std::string(program.A(i))});
+                frontier.push_back(i + 1);
+                break;
+            case scenario::Op::VOICE:
+                out.push_back({AssetKind::Voice, std::string(program.A(i))});
+                frontier.push_back(i + 1);
+                break;
+            case scenario::Op::JUMP:
+                follow(program.Target(i));
+                break;
+            case scenario::Op::BUTTON:
+                follow(program.Target(i));
+                frontier.push_back(i + 1);
+                break;
+            case scenario::Op::END:
+                break;
+            default:
+                frontier.push_back(i + 1);
+                break;
+        }
+    }
+    return out;
+}
+
+ImagePrefetcher::ImagePrefetcher(const AssetSource &source,
+                                 Transform transform,
+                                 size_t threads)
+    : source(source), transform(std::move(transform)), pool(threads)
+{
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    pool.Shutdown();
+    for (auto &[path, entry] : entries) {
+        if (entry.surface)
+            SDL_DestroySurface(entry.surface);
+    }
+}
+
+void ImagePrefetcher::Prefetch(const std::vector<std::string> &paths)
+{
+    std::vector<std::string> queue;
+    {
+        std::lock_guard lock(mutex);
+        for (auto &[path, entry] : entries)
+            entry.wanted = false;
+
+        for (const auto &path : paths) {
+            auto [it, inserted] = entries.try_emplace(path);
+            it->second.wanted = true;
+            if (inserted)
+                queue.push_back(path);
+        }
+
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.ready && !it->second.wanted) {
+                if (it->second.surface) {
+                    SDL_DestroySurface(it->second.surface);
+                    stats.dropped++;
+                }
+                it = entries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto &path : queue)
+        pool.Submit([this, path] { Decode(path); });
+}
+
+void ImagePrefetcher::Decode(const std::string &path)
+{
+    CEREKA_TRACE_ZONE("DecodeImage");
+    SDL_Surface *surface = nullptr;
+    if (AssetBytes asset = source.Read(path)) {
+        const auto bytes = asset.Bytes();
+        if (IsTextureFile(bytes))
+            surface = DecodeTextureFile(bytes);
+        else
+            surface = IMG_Load_IO(SDL_IOFromConstMem(bytes.data(), bytes.size()), true);
+    }
+    if (surface && transform)
+        surface = transform(path, surface);
+
+    std::lock_guard lock(mutex);
+    auto it = entries.find(path);
+    if (it == entries.end() || !it->second.wanted) {
+        if (surface) {
+            SDL_DestroySurface(surface);
+            stats.dropped++;
+        }
+        if (it != entries.end())
+            entries.erase(it);
+        return;
+    }
+    it->second.surface = surface;
+    it->second.ready = true;
+    if (surface)
+        stats.decoded++;
+    decodedCv.notify_all();
+}
+
+SDL_Surface *ImagePrefetcher::Take(const std::string &path)
+{
+    std::unique_lock lock(mutex);
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+
+    it->second.wanted = true;
+    decodedCv.wait(lock, [&] {
+        auto cur = entries.find(path);
+        return cur == entries.end() || cur->second.ready;
+    });
+
+    it = entries.find(path);
+    SDL_Surface *surface = it != entries.end() ? it->second.surface : nullptr;
+    if (it != entries.end())
+        entries.erase(it);
+
+    if (surface)
+        stats.hits++;
+    else
+        stats.misses++;
+    return surface;
+}
+
+void ImagePrefetcher::Invalidate(const std::string &path)
+{
+    std::lock_guard lock(mutex);
+    auto it = entries.find(path);
+    if (it == entries.end())
+        return;
+    // Decode() drops the result of a decode whose entry is gone, and Take()
+    // stops waiting for it.
+    if (it->second.surface) {
+        SDL_DestroySurface(it->second.surface);
+        stats.dropped++;
+    }
+    entries.erase(it);
+    decodedCv.notify_all();
+}
+
+PrefetchStats ImagePrefetcher::Stats()
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+}  // namespace cereka::assets
@@ -0,0 +1,99 @@
+#pragma once
+#include "asset_pack.hpp"
+#include "thread_pool.hpp"
+#include "bytecode.hpp"
+#include <SDL3/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cereka::assets {
+
+enum class AssetKind { Background, Character, Voice };
+
+struct AssetRef {
+    AssetKind kind;
+    std::string id;
+};
+
+/**
+ * Walk the program from `pc` the way the interpreter could, following JUMPs
+ * and every BUTTON target of a MENU, and collect the images and voice lines
+ * the upcoming BG, CHAR and VOICE instructions will need. At most `window`
+ * instructions are visited; nearer instructions are visited first.
+ */
+std::vector<AssetRef> ScanAhead(const scenario::Bytecode &program,
+                                size_t pc,
+                                size_t window);
+
+struct PrefetchStats {
+    uint64_t hits = 0;     // Take() found a decoded (or in-flight) surface
+    uint64_t misses = 0;   // Take() had to fall back to a synchronous load
+    uint64_t decoded = 0;  // surfaces decoded by the workers
+    uint64_t dropped = 0;  // decoded surfaces discarded before use
+};
+
+/**
+ * Decodes images into SDL_Surfaces on a worker pool ahead of time so the
+ * main thread only has to upload them. Paths are asset names, read through
+ * `source`, which must outlive the prefetcher.
+ */
+class ImagePrefetcher {
+   public:
+    /**
+     * Runs on the worker after decoding, e.g. to resample the image. Takes
+     * ownership of the surface and returns it or a replacement.
+     */
+    using Transform = std::function<SDL_Surface *(const std::string &path, SDL_Surface *surface)>;
+
+    explicit ImagePrefetcher(const AssetSource &source,
+                             Transform transform = {},
+                             size_t threads = 0);
+    ~ImagePrefetcher();
+
+    ImagePrefetcher(const ImagePrefetcher &) = delete;
+    ImagePrefetcher &operator=(const ImagePrefetcher &) = delete;
+
+    /**
+     * Make `paths` the wanted set: start decoding the ones not yet queued and
+     * release decoded surfaces that are no longer wanted.
+     */
+    void Prefetch(const std::vector<std::string> &paths);
+
+    /**
+     * Hand over the decoded surface for `path`, waiting if its decode is still
+     * running. Returns nullptr on a miss; the caller owns the surface.
+     */
+    SDL_Surface *Take(const std::string &path);
+
+    /**
+     * Forget `path` because the file changed: a decoded surface is dropped,
+     * and a decode still running is discarded when it finishes.
+     */
+    void Invalidate(const std::string &path);
+
+    PrefetchStats Stats();
+
+   private:
+    struct Entry {
+        bool ready = false;
+        bool wanted = true;
+        SDL_Surface *surface = nullptr;
+    };
+
+    void Decode(const std::string &path);
+
+    const AssetSource &source;
+    Transform transform;
+    std::mutex mutex;
+    std::condition_variable decodedCv;
+    std::unordered_map<std::string, Entry> entries;
+    PrefetchStats stats;
+    threading::ThreadPool pool;
+};
+
+}  // namespace cereka::assets
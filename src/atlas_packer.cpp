@@ -0,0 +1,49 @@
+#include "atlas_packer.hpp"
+
+namespace cereka::render {
+
+ShelfPacker::ShelfPacker(int width,
+                         int height,
+                         int padding)
+    : width(width), height(height), padding(padding)
+{
+}
+
+bool ShelfPacker::Pack(int w,
+                       int h,
+                       SDL_Rect &out)
+{
+    const int pw = w + padding;
+    const int ph = h + padding;
+    if (pw > width || ph > height)
+        return false;
+
+    // Best fit: the shortest existing shelf that is tall enough and has room.
+    Shelf *best = nullptr;
+    for (auto &shelf : shelves) {
+        if (shelf.height >= ph && shelf.cursorX + pw <= width) {
+            if (!best || shelf.height < best->height)
+                best = &shelf;
+        }
+    }
+
+    if (!best) {
+        if (nextY + ph > height)
+            return false;
+        shelves.push_back({nextY, ph, 0});
+        nextY += ph;
+        best = &shelves.back();
+    }
+
+    out = {best->cursorX, best->y, w, h};
+    best->cursorX += pw;
+    return true;
+}
+
+void ShelfPacker::Clear()
+{
+    shelves.clear();
+    nextY = 0;
+}
+
+}  // namespace cereka::render
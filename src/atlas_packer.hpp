@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+
+namespace cereka::render {
+
+/**
+ * Shelf (skyline-row) rectangle packer used for texture atlases.
+ *
+ * Rectangles are placed left to right on the shortest shelf that fits them;
+ * when none has room, a new shelf as tall as the rectangle is opened below
+ * the last one. This is a good fit for glyphs and UI sprites, whose heights
+ * cluster around a few values.
+ */
+class ShelfPacker {
+   public:
+    ShelfPacker(int width,
+                int height,
+                int padding = 1);
+
+    /**
+     * Reserve a w*h rectangle. Returns false when the atlas is full.
+     */
+    bool Pack(int w,
+              int h,
+              SDL_Rect &out);
+
+    void Clear();
+
+    int Width() const
+    {
+        return width;
+    }
+    int Height() const
+    {
+        return height;
+    }
+
+   private:
+    struct Shelf {
+        int y;
+        int height;
+        int cursorX;
+    };
+
+    int width;
+    int height;
+    int padding;
+    int nextY = 0;
+    std::vector<Shelf> shelves;
+};
+
+}  // namespace cereka::render
@@ -0,0 +1,298 @@
+#include "audio.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+
+namespace cereka::audio {
+
+namespace {
+
+constexpr Sint64 MUSIC_FADE_MS = 500;
+
+// Memory a decoded MIX_Audio holds: SDL_mixer keeps float samples.
+size_t DecodedBytes(MIX_Audio *audio)
+{
+    SDL_AudioSpec spec{};
+    const Sint64 frames = MIX_GetAudioDuration(audio);
+    if (frames <= 0 || !MIX_GetAudioFormat(audio, &spec))
+        return 0;
+    return size_t(frames) * size_t(spec.channels) * sizeof(float);
+}
+
+Uint64 DurationNs(MIX_Audio *audio)
+{
+    SDL_AudioSpec spec{};
+    const Sint64 frames = MIX_GetAudioDuration(audio);
+    if (frames <= 0 || !MIX_GetAudioFormat(audio, &spec) || spec.freq <= 0)
+        return 0;
+    return Uint64(frames) * SDL_NS_PER_SECOND / Uint64(spec.freq);
+}
+
+}  // namespace
+
+AudioSystem::AudioSystem(const assets::AssetSource &source,
+                         size_t soundBudgetBytes)
+    : source(source), soundBudget(soundBudgetBytes)
+{
+}
+
+AudioSystem::~AudioSystem()
+{
+    pool.Shutdown();
+    DestroyVoices();
+    // Destroying the mixer stops and destroys its tracks first.
+    if (mixer)
+        MIX_DestroyMixer(mixer);
+    for (auto &[name, sound] : sounds)
+        MIX_DestroyAudio(sound.audio);
+    if (voice)
+        MIX_DestroyAudio(voice);
+    if (initialized)
+        MIX_Quit();
+}
+
+bool AudioSystem::Open()
+{
+    if (mixer)
+        return true;
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        CEREKA_LOG_WARN("no audio: {}", SDL_GetError());
+        return false;
+    }
+    if (!initialized && !MIX_Init()) {
+        CEREKA_LOG_WARN("no audio: {}", SDL_GetError());
+        return false;
+    }
+    initialized = true;
+
+    mixer = MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, nullptr);
+    if (!mixer) {
+        CEREKA_LOG_WARN("no audio device: {}", SDL_GetError());
+        return false;
+    }
+    musicTracks[0] = MIX_CreateTrack(mixer);
+    musicTracks[1] = MIX_CreateTrack(mixer);
+    voiceTrack = MIX_CreateTrack(mixer);
+    if (!musicTracks[0] || !musicTracks[1] || !voiceTrack) {
+        CEREKA_LOG_WARN("could not create audio tracks: {}", SDL_GetError());
+        // Destroying the mixer destroys its tracks.
+        MIX_DestroyMixer(mixer);
+        mixer = nullptr;
+        return false;
+    }
+    CEREKA_LOG_INFO("audio opened on '{}'", SDL_GetCurrentAudioDriver());
+    return true;
+}
+
+void AudioSystem::PlayMusic(const std::string &name)
+{
+    if (name.empty()) {
+        StopMusic();
+        return;
+    }
+    if (!mixer || name == music)
+        return;
+    CEREKA_TRACE_ZONE("PlayMusic");
+
+    SDL_IOStream *io = source.Open(name);
+    if (!io) {
+        CEREKA_LOG_ERROR("failed to open music '{}'", name);
+        return;
+    }
+    // Fade out on the current track while the new piece starts on the other.
+    StopMusic();
+    musicSlot ^= 1;
+    MIX_Track *track = musicTracks[musicSlot];
+    if (!MIX_SetTrackIOStream(track, io, true) || !MIX_SetTrackLoops(track, -1) ||
+        !MIX_PlayTrack(track, 0))
+    {
+        CEREKA_LOG_ERROR("failed to play music '{}': {}", name, SDL_GetError());
+        return;
+    }
+    music = name;
+}
+
+void AudioSystem::StopMusic()
+{
+    music.clear();
+    if (!mixer)
+        return;
+    MIX_Track *track = musicTracks[musicSlot];
+    MIX_StopTrack(track, MIX_TrackMSToFrames(track, MUSIC_FADE_MS));
+}
+
+void AudioSystem::PlaySound(const std::string &name)
+{
+    if (!mixer || name.empty())
+        return;
+    CEREKA_TRACE_ZONE("PlaySound");
+
+    auto it = sounds.find(name);
+    if (it != sounds.end()) {
+        soundLru.erase(it->second.lruPos);
+        stats.soundHits++;
+    }
+    else {
+        MIX_Audio *audio = nullptr;
+        if (SDL_IOStream *io = source.Open(name))
+            audio = MIX_LoadAudio_IO(mixer, io, true, true);
+        if (!audio) {
+            CEREKA_LOG_ERROR("failed to load sound '{}': {}", name, SDL_GetError());
+            return;
+        }
+        it = sounds.try_emplace(name).first;
+        it->second.name = name;
+        it->second.audio = audio;
+        it->second.bytes = DecodedBytes(audio);
+        stats.soundCachedBytes += it->second.bytes;
+        stats.soundMisses++;
+    }
+
+    Sound &sound = it->second;
+    sound.lruPos = soundLru.insert(soundLru.end(), &sound);
+    if (!MIX_PlayAudio(mixer, sound.audio))
+        CEREKA_LOG_ERROR("failed to play sound '{}': {}", name, SDL_GetError());
+    sound.busyUntilNs = SDL_GetTicksNS() + DurationNs(sound.audio);
+    EvictSounds(soundBudget);
+}
+
+void AudioSystem::EvictSounds(size_t budget)
+{
+    const Uint64 now = SDL_GetTicksNS();
+    for (auto it = soundLru.begin(); it != soundLru.end() && stats.soundCachedBytes > budget;) {
+        Sound *sound = *it;
+        if (sound->busyUntilNs > now) {
+            ++it;
+            continue;
+        }
+        it = soundLru.erase(it);
+        MIX_DestroyAudio(sound->audio);
+        stats.soundCachedBytes -= sound->bytes;
+        stats.soundEvictions++;
+        sounds.erase(sound->name);
+    }
+}
+
+void AudioSystem::SetSoundBudget(size_t bytes)
+{
+    soundBudget = bytes;
+    EvictSounds(soundBudget);
+}
+
+void AudioSystem::PlayVoice(const std::string &name)
+{
+    if (!mixer || name.empty())
+        return;
+    CEREKA_TRACE_ZONE("PlayVoice");
+
+    MIX_Audio *decoded = nullptr;
+    {
+        std::unique_lock lock(mutex);
+        auto it = voices.find(name);
+        if (it != voices.end()) {
+            decodedCv.wait(lock, [&] { return it->second.ready; });
+            decoded = it->second.audio;
+            voices.erase(it);
+        }
+        if (decoded)
+            stats.voiceHits++;
+        else
+            stats.voiceMisses++;
+    }
+
+    StopVoice();
+    bool ok;
+    if (decoded) {
+        voice = decoded;
+        ok = MIX_SetTrackAudio(voiceTrack, voice);
+    }
+    else {
+        SDL_IOStream *io = source.Open(name);
+        ok = io && MIX_SetTrackIOStream(voiceTrack, io, true);
+    }
+    if (!ok || !MIX_PlayTrack(voiceTrack, 0))
+        CEREKA_LOG_ERROR("failed to play voice '{}': {}", name, SDL_GetError());
+}
+
+void AudioSystem::StopVoice()
+{
+    if (!mixer)
+        return;
+    MIX_StopTrack(voiceTrack, 0);
+    if (voice) {
+        MIX_SetTrackAudio(voiceTrack, nullptr);
+        MIX_DestroyAudio(voice);
+        voice = nullptr;
+    }
+}
+
+void AudioSystem::PrefetchVoices(const std::vector<std::string> &names)
+{
+    if (!mixer)
+        return;
+    std::vector<std::string> queue;
+    {
+        std::lock_guard lock(mutex);
+        for (auto &[name, entry] : voices)
+            entry.wanted = false;
+
+        for (const auto &name : names) {
+            auto [it, inserted] = voices.try_emplace(name);
+            it->second.wanted = true;
+            if (inserted)
+                queue.push_back(name);
+        }
+
+        for (auto it = voices.begin(); it != voices.end();) {
+            if (it->second.ready && !it->second.wanted) {
+                if (it->second.audio) {
+                    MIX_DestroyAudio(it->second.audio);
+                    stats.voicesDropped++;
+                }
+                it = voices.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto &name : queue)
+        pool.Submit([this, name] { DecodeVoice(name); });
+}
+
+void AudioSystem::DecodeVoice(const std::string &name)
+{
+    CEREKA_TRACE_ZONE("DecodeVoice");
+    MIX_Audio *audio = nullptr;
+    if (SDL_IOStream *io = source.Open(name))
+        audio = MIX_LoadAudio_IO(mixer, io, true, true);
+    if (!audio)
+        CEREKA_LOG_WARN("failed to decode voice '{}': {}", name, SDL_GetError());
+
+    // Entries are only erased once ready, so this one is still there.
+    std::lock_guard lock(mutex);
+    Voice &entry = voices.at(name);
+    entry.ready = true;
+    entry.audio = audio;
+    if (audio)
+        stats.voicesDecoded++;
+    decodedCv.notify_all();
+}
+
+void AudioSystem::DestroyVoices()
+{
+    std::lock_guard lock(mutex);
+    for (auto &[name, entry] : voices) {
+        if (entry.audio)
+            MIX_DestroyAudio(entry.audio);
+    }
+    voices.clear();
+}
+
+AudioStats AudioSystem::Stats()
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+}  // namespace cereka::audio
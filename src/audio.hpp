@@ -0,0 +1,138 @@
+#pragma once
+#include "asset_pack.hpp"
+#include "thread_pool.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3_mixer/SDL_mixer.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cereka::audio {
+
+struct AudioStats {
+    uint64_t soundHits = 0;       // PlaySound() found the sound decoded
+    uint64_t soundMisses = 0;     // PlaySound() had to decode it first
+    uint64_t soundEvictions = 0;
+    size_t soundCachedBytes = 0;  // live value, not cumulative
+    uint64_t voiceHits = 0;       // PlayVoice() found a decoded (or in-flight) line
+    uint64_t voiceMisses = 0;     // PlayVoice() fell back to streaming
+    uint64_t voicesDecoded = 0;   // lines decoded by the worker
+    uint64_t voicesDropped = 0;   // decoded lines discarded before use
+};
+
+/**
+ * Music, sound effects and voice on one SDL_mixer device.
+ *
+ * - Music streams from its asset on a track of its own, so it takes a
+ *   decoder's worth of memory whatever its length. A new piece fades the
+ *   old one out on a second track.
+ * - Sound effects are decoded once and kept in a cache; sounds not played
+ *   recently are destroyed, oldest first, while the cache is over budget.
+ *   A sound is never destroyed while it may still be playing.
+ * - Voice lines are decoded on a worker thread ahead of the line that plays
+ *   them (see PrefetchVoices()), so playback starts without a decode. A line
+ *   that was not prefetched streams instead.
+ *
+ * Names are asset names read through `source`, which must outlive this
+ * object. If no audio device can be opened every call is a no-op, so the
+ * engine runs silently; SDL's "dummy" audio driver works headless.
+ */
+class AudioSystem {
+   public:
+    explicit AudioSystem(const assets::AssetSource &source,
+                         size_t soundBudgetBytes = size_t(16) << 20);
+    ~AudioSystem();
+
+    AudioSystem(const AudioSystem &) = delete;
+    AudioSystem &operator=(const AudioSystem &) = delete;
+
+    /**
+     * Open the default playback device. Returns false (and logs why) if
+     * there is none.
+     */
+    bool Open();
+
+    bool IsOpen() const
+    {
+        return mixer != nullptr;
+    }
+
+    /**
+     * Loop `name`, fading out whatever was playing. Playing the current
+     * music again does nothing; an empty name stops the music.
+     */
+    void PlayMusic(const std::string &name);
+    void StopMusic();
+
+    const std::string &Music() const
+    {
+        return music;
+    }
+
+    void PlaySound(const std::string &name);
+
+    /**
+     * Play a voice line, cutting off the previous one. Waits for the
+     * prefetch decode if it is still running.
+     */
+    void PlayVoice(const std::string &name);
+    void StopVoice();
+
+    /**
+     * Make `names` the wanted set of voice lines: start decoding the ones
+     * not yet queued and release decoded lines no longer wanted.
+     */
+    void PrefetchVoices(const std::vector<std::string> &names);
+
+    void SetSoundBudget(size_t bytes);
+
+    AudioStats Stats();
+
+   private:
+    struct Sound {
+        std::string name;
+        MIX_Audio *audio = nullptr;
+        size_t bytes = 0;
+        Uint64 busyUntilNs = 0;  // playback end of the last PlaySound()
+        std::list<Sound *>::iterator lruPos;
+    };
+
+    struct Voice {
+        bool ready = false;
+        bool wanted = true;
+        MIX_Audio *audio = nullptr;
+    };
+
+    void DecodeVoice(const std::string &name);
+    void EvictSounds(size_t budget);
+    void DestroyVoices();
+
+    const assets::AssetSource &source;
+    MIX_Mixer *mixer = nullptr;
+    bool initialized = false;
+
+    MIX_Track *musicTracks[2] = {nullptr, nullptr};
+    int musicSlot = 0;
+    std::string music;
+
+    MIX_Track *voiceTrack = nullptr;
+    MIX_Audio *voice = nullptr;  // decoded line on voiceTrack, if any
+
+    size_t soundBudget;
+    std::unordered_map<std::string, Sound> sounds;
+    std::list<Sound *> soundLru;  // least recently played first
+
+    // Shared with the voice worker.
+    std::mutex mutex;
+    std::condition_variable decodedCv;
+    std::unordered_map<std::string, Voice> voices;
+    AudioStats stats;
+    threading::ThreadPool pool{1};
+};
+
+}  // namespace cereka::audio
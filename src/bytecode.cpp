@@ -0,0 +1,260 @@
+#include "bytecode.hpp"
+#include "Cereka/exceptions.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace cereka::scenario {
+
+static size_t AlignUp(size_t n)
+{
+    return (n + 7) & ~size_t(7);
+}
+
+namespace {
+
+class StringPool {
+   public:
+    StringPool()
+    {
+        Add("");
+    }
+
+    uint32_t Add(std::string_view s)
+    {
+        auto [it, inserted] = ids.try_emplace(std::string(s), uint32_t(table.size()));
+        if (inserted) {
+            table.push_back({uint32_t(data.size()), uint32_t(s.size())});
+            data.insert(data.end(), s.begin(), s.end());
+        }
+        return it->second;
+    }
+
+    std::string_view Get(uint32_t id) const
+    {
+        return {data.data() + table[id].offset, table[id].length};
+    }
+
+    std::vector<PackedString> table;
+    std::vector<char> data;
+
+   private:
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+template<typename T>
+void Put(std::vector<std::byte> &out,
+         size_t offset,
+         const std::vector<T> &items)
+{
+    if (!items.empty())
+        std::memcpy(out.data() + offset, items.data(), items.size() * sizeof(T));
+}
+
+}  // namespace
+
+std::vector<std::byte> SerializeBytecode(const std::vector<Instruction> &program)
+{
+    StringPool pool;
+    std::vector<PackedInstruction> instructions;
+    std::vector<PackedChoice> choices;
+    std::vector<PackedLabel> labels;
+
+    std::unordered_map<std::string_view, uint32_t> labelIndex;
+    for (size_t i = 0; i < program.size(); ++i) {
+        if (program[i].op == Op::LABEL)
+            labelIndex[program[i].a] = uint32_t(i);
+    }
+    auto resolve = [&](const std::string &label) {
+        auto it = labelIndex.find(label);
+        return it != labelIndex.end() ? it->second : NO_TARGET;
+    };
+
+    instructions.reserve(program.size());
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Instruction &ins = program[i];
+        PackedInstruction packed{};
+        packed.op = uint8_t(ins.op);
+        packed.flags = ins.exit_button ? EXIT_BUTTON : 0;
+        packed.a = pool.Add(ins.a);
+        packed.b = pool.Add(ins.b);
+        packed.choiceCount = uint16_t(ins.choices.size());
+
+        if (ins.op == Op::JUMP)
+            packed.arg = resolve(ins.a);
+        else if (ins.op == Op::BUTTON)
+            packed.arg = resolve(ins.b);
+        else
+            packed.arg = uint32_t(choices.size());
+
+        for (const auto &c : ins.choices)
+            choices.push_back({pool.Add(c.text), pool.Add(c.targetLabel), resolve(c.targetLabel)});
+        instructions.push_back(packed);
+
+        if (ins.op == Op::LABEL && labelIndex[ins.a] == i)
+            labels.push_back({packed.a, uint32_t(i)});
+    }
+
+    std::stable_sort(labels.begin(),
+                     labels.end(),
+                     [&](const PackedLabel &l, const PackedLabel &r) {
+                         return pool.Get(l.name) < pool.Get(r.name);
+                     });
+
+    BytecodeHeader header{};
+    std::memcpy(header.magic, BYTECODE_MAGIC, sizeof(header.magic));
+    header.version = BYTECODE_VERSION;
+    header.instructionCount = uint32_t(instructions.size());
+    header.choiceCount = uint32_t(choices.size());
+    header.labelCount = uint32_t(labels.size());
+    header.stringCount = uint32_t(pool.table.size());
+
+    size_t cursor = AlignUp(sizeof(BytecodeHeader));
+    header.instructionsOffset = cursor;
+    cursor = AlignUp(cursor + instructions.size() * sizeof(PackedInstruction));
+    header.choicesOffset = cursor;
+    cursor = AlignUp(cursor + choices.size() * sizeof(PackedChoice));
+    header.labelsOffset = cursor;
+    cursor = AlignUp(cursor + labels.size() * sizeof(PackedLabel));
+    header.stringsOffset = cursor;
+    cursor = AlignUp(cursor + pool.table.size() * sizeof(PackedString));
+    header.stringDataOffset = cursor;
+    header.stringDataSize = pool.data.size();
+    cursor += pool.data.size();
+
+    std::vector<std::byte> out(cursor);
+    std::memcpy(out.data(), &header, sizeof(header));
+    Put(out, header.instructionsOffset, instructions);
+    Put(out, header.choicesOffset, choices);
+    Put(out, header.labelsOffset, labels);
+    Put(out, header.stringsOffset, pool.table);
+    Put(out, header.stringDataOffset, pool.data);
+    return out;
+}
+
+void WriteBytecode(const std::string &path,
+                   const std::vector<Instruction> &program)
+{
+    std::vector<std::byte> image = SerializeBytecode(program);
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f)
+        throw engine::error("Could not open '%s' for writing", path.c_str());
+    f.write(reinterpret_cast<const char *>(image.data()), std::streamsize(image.size()));
+    if (!f)
+        throw engine::error("Failed to write bytecode to '%s'", path.c_str());
+}
+
+std::shared_ptr<const Bytecode> Bytecode::Map(const std::string &path)
+{
+    std::shared_ptr<Bytecode> bc(new Bytecode());
+    if (!bc->file.Open(path))
+        throw engine::error("Could not map bytecode file '%s'", path.c_str());
+    bc->Bind(bc->file.Data(), bc->file.Size());
+    return bc;
+}
+
+std::shared_ptr<const Bytecode> Bytecode::Build(const std::vector<Instruction> &program)
+{
+    std::shared_ptr<Bytecode> bc(new Bytecode());
+    bc->owned = SerializeBytecode(program);
+    bc->Bind(bc->owned.data(), bc->owned.size());
+    return bc;
+}
+
+void Bytecode::Bind(const std::byte *data,
+                    size_t size)
+{
+    if (size < sizeof(BytecodeHeader))
+        throw engine::error("Bytecode image too small (%zu bytes)", size);
+
+    const auto *h = reinterpret_cast<const BytecodeHeader *>(data);
+    if (std::memcmp(h->magic, BYTECODE_MAGIC, sizeof(h->magic)) != 0)
+        throw engine::error("Not a Cereka bytecode image");
+    if (h->version != BYTECODE_VERSION)
+        throw engine::error(
+            "Bytecode version %u, expected %u", unsigned(h->version), unsigned(BYTECODE_VERSION));
+
+    auto inBounds = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 8 == 0 && offset <= size && bytes <= size - offset;
+    };
+    const uint64_t instructionBytes = uint64_t(h->instructionCount) * sizeof(PackedInstruction);
+    if (!inBounds(h->instructionsOffset, instructionBytes) ||
+        !inBounds(h->choicesOffset, uint64_t(h->choiceCount) * sizeof(PackedChoice)) ||
+        !inBounds(h->labelsOffset, uint64_t(h->labelCount) * sizeof(PackedLabel)) ||
+        !inBounds(h->stringsOffset, uint64_t(h->stringCount) * sizeof(PackedString)) ||
+        h->stringDataOffset > size || h->stringDataSize > size - h->stringDataOffset ||
+        h->stringCount == 0)
+    {
+        throw engine::error("Bytecode image is truncated or corrupt");
+    }
+
+    // Every index the accessors follow without checking must be in range.
+    const auto *ins = reinterpret_cast<const PackedInstruction *>(data + h->instructionsOffset);
+    for (uint32_t i = 0; i < h->instructionCount; ++i) {
+        const Op op = static_cast<Op>(ins[i].op);
+        // JUMP and BUTTON keep their target in `arg`, not a choice index.
+        const bool argIsTarget = op == Op::JUMP || op == Op::BUTTON;
+        if (!argIsTarget && uint64_t(ins[i].arg) + ins[i].choiceCount > h->choiceCount)
+            throw engine::error("Bytecode instruction %u has out-of-range choices", i);
+    }
+    const auto *lab = reinterpret_cast<const PackedLabel *>(data + h->labelsOffset);
+    for (uint32_t i = 0; i < h->labelCount; ++i) {
+        if (lab[i].instruction >= h->instructionCount)
+            throw engine::error("Bytecode label %u points past the program", i);
+    }
+
+    image = data;
+    imageSize = size;
+    header = h;
+    instructions = reinterpret_cast<const PackedInstruction *>(data + h->instructionsOffset);
+    choices = reinterpret_cast<const PackedChoice *>(data + h->choicesOffset);
+    labels = reinterpret_cast<const PackedLabel *>(data + h->labelsOffset);
+    strings = reinterpret_cast<const PackedString *>(data + h->stringsOffset);
+    stringData = reinterpret_cast<const char *>(data + h->stringDataOffset);
+}
+
+std::string_view Bytecode::String(uint32_t id) const
+{
+    if (id >= header->stringCount)
+        return {};
+    const PackedString &s = strings[id];
+    if (s.offset > header->stringDataSize || s.length > header->stringDataSize - s.offset)
+        return {};
+    return {stringData + s.offset, s.length};
+}
+
+std::optional<size_t> Bytecode::FindLabel(std::string_view name) const
+{
+    const PackedLabel *begin = labels;
+    const PackedLabel *end = labels + header->labelCount;
+    const PackedLabel *it =
+        std::lower_bound(begin, end, name, [&](const PackedLabel &l, std::string_view n) {
+            return String(l.name) < n;
+        });
+    if (it == end || String(it->name) != name)
+        return std::nullopt;
+    return it->instruction;
+}
+
+std::vector<Instruction> DecodeBytecode(const Bytecode &bytecode)
+{
+    std::vector<Instruction> program(bytecode.Size());
+    for (size_t i = 0; i < program.size(); ++i) {
+        Instruction &ins = program[i];
+        ins.op = bytecode.OpAt(i);
+        ins.a = bytecode.A(i);
+        ins.b = bytecode.B(i);
+        ins.exit_button = bytecode.ExitButton(i);
+        if (ins.op == Op::JUMP || ins.op == Op::BUTTON)
+            continue;
+        for (size_t c = 0; c < bytecode.ChoiceCount(i); ++c) {
+            const PackedChoice &choice = bytecode.Choice(i, c);
+            ins.choices.push_back({std::string(bytecode.String(choice.text)),
+                                   std::string(bytecode.String(choice.label))});
+        }
+    }
+    return program;
+}
+
+}  // namespace cereka::scenario
@@ -0,0 +1,196 @@
+#pragma once
+#include "mapped_file.hpp"
+#include "vn_instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cereka::scenario {
+
+/*
+ * Compiled script image (.crkb), in host byte order (images are not portable
+ * between little- and big-endian machines), every table 8-byte aligned:
+ *
+ *   BytecodeHeader
+ *   PackedInstruction[instructionCount]  16 bytes each
+ *   PackedChoice[choiceCount]
+ *   PackedLabel[labelCount]      sorted by label name
+ *   PackedString[stringCount]    interned; string 0 is always ""
+ *   char[stringDataSize]         string bytes, not NUL-terminated
+ *
+ * JUMP and BUTTON targets, and choice targets, are resolved to instruction
+ * indices when the image is built, so the interpreter never looks labels up
+ * by name. The engine executes directly from these tables; a mapped file
+ * needs no decoding beyond a bounds check of the header and the indices.
+ */
+
+inline constexpr char BYTECODE_MAGIC[4] = {'C', 'R', 'K', 'B'};
+inline constexpr uint32_t BYTECODE_VERSION = 3;
+
+/**
+ * Target index of a JUMP, BUTTON or choice whose label is empty or unknown.
+ */
+inline constexpr uint32_t NO_TARGET = UINT32_MAX;
+
+struct BytecodeHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t instructionCount;
+    uint32_t choiceCount;
+    uint32_t labelCount;
+    uint32_t stringCount;
+    uint64_t instructionsOffset;
+    uint64_t choicesOffset;
+    uint64_t labelsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringDataOffset;
+    uint64_t stringDataSize;
+};
+
+enum PackedFlags : uint8_t { EXIT_BUTTON = 1 << 0 };
+
+struct PackedInstruction {
+    uint8_t op;
+    uint8_t flags;
+    uint16_t choiceCount;
+    uint32_t a;  // string index
+    uint32_t b;  // string index
+    // JUMP/BUTTON: resolved target instruction (or NO_TARGET).
+    // Otherwise: index of the first choice in the choice table.
+    uint32_t arg;
+};
+static_assert(sizeof(PackedInstruction) == 16);
+
+struct PackedChoice {
+    uint32_t text;    // string index
+    uint32_t label;   // string index of the target label
+    uint32_t target;  // resolved target instruction (or NO_TARGET)
+};
+
+struct PackedLabel {
+    uint32_t name;  // string index
+    uint32_t instruction;
+};
+
+struct PackedString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * Read-only view of a compiled script image, either memory-mapped from disk
+ * or built in memory from a compiled instruction list.
+ *
+ * Images are immutable once built; share one between engine instances by
+ * passing the shared_ptr around rather than rebuilding it.
+ */
+class Bytecode {
+   public:
+    /**
+     * Map a .crkb file. Throws engine::error if it is missing or malformed.
+     */
+    static std::shared_ptr<const Bytecode> Map(const std::string &path);
+
+    /**
+     * Serialize a compiled instruction list into an in-memory image.
+     */
+    static std::shared_ptr<const Bytecode> Build(const std::vector<Instruction> &program);
+
+    size_t Size() const
+    {
+        return header->instructionCount;
+    }
+
+    Op OpAt(size_t i) const
+    {
+        return static_cast<Op>(instructions[i].op);
+    }
+    std::string_view A(size_t i) const
+    {
+        return String(instructions[i].a);
+    }
+    std::string_view B(size_t i) const
+    {
+        return String(instructions[i].b);
+    }
+    bool ExitButton(size_t i) const
+    {
+        return instructions[i].flags & EXIT_BUTTON;
+    }
+
+    /**
+     * Resolved target of a JUMP or BUTTON, NO_TARGET if it has none.
+     */
+    uint32_t Target(size_t i) const
+    {
+        const Op op = OpAt(i);
+        return op == Op::JUMP || op == Op::BUTTON ? instructions[i].arg : NO_TARGET;
+    }
+
+    size_t ChoiceCount(size_t i) const
+    {
+        return instructions[i].choiceCount;
+    }
+    const PackedChoice &Choice(size_t i,
+                               size_t c) const
+    {
+        return choices[instructions[i].arg + c];
+    }
+
+    std::string_view String(uint32_t id) const;
+
+    /**
+     * Binary search the label table. Only needed for lookups by name coming
+     * from outside the program; the interpreter uses Target().
+     */
+    std::optional<size_t> FindLabel(std::string_view name) const;
+
+    const std::byte *Image() const
+    {
+        return image;
+    }
+    size_t ImageSize() const
+    {
+        return imageSize;
+    }
+
+   private:
+    Bytecode() = default;
+    void Bind(const std::byte *data,
+              size_t size);
+
+    io::MappedFile file;
+    std::vector<std::byte> owned;
+
+    const std::byte *image = nullptr;
+    size_t imageSize = 0;
+    const BytecodeHeader *header = nullptr;
+    const PackedInstruction *instructions = nullptr;
+    const PackedChoice *choices = nullptr;
+    const PackedLabel *labels = nullptr;
+    const PackedString *strings = nullptr;
+    const char *stringData = nullptr;
+};
+
+/**
+ * Serialize a compiled instruction list to the .crkb layout.
+ */
+std::vector<std::byte> SerializeBytecode(const std::vector<Instruction> &program);
+
+/**
+ * Rebuild the instruction list an image was serialized from. Label names are
+ * kept in the image, so the result can be relinked with other programs.
+ */
+std::vector<Instruction> DecodeBytecode(const Bytecode &bytecode);
+
+/**
+ * Serialize and write a .crkb file. Throws engine::error on I/O failure.
+ */
+void WriteBytecode(const std::string &path,
+                   const std::vector<Instruction> &program);
+
+}  // namespace cereka::scenario
@@ -0,0 +1,105 @@
+#include "compositor.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+#include <cmath>
+
+namespace cereka::render {
+
+namespace {
+
+SDL_Texture *CreateTarget(SDL_Renderer *renderer,
+                          int width,
+                          int height)
+{
+    SDL_Texture *tex = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!tex)
+        return nullptr;
+    // Layers are copied pixel for pixel and are opaque.
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
+    return tex;
+}
+
+}  // namespace
+
+Compositor::Compositor(SDL_Renderer *renderer,
+                       int width,
+                       int height)
+    : renderer(renderer), width(width), height(height)
+{
+    scene = CreateTarget(renderer, width, height);
+    frame = scene ? CreateTarget(renderer, width, height) : nullptr;
+    if (!Valid())
+        CEREKA_LOG_WARN("no render targets ({}), drawing every layer every frame", SDL_GetError());
+}
+
+Compositor::~Compositor()
+{
+    if (scene)
+        SDL_DestroyTexture(scene);
+    if (frame)
+        SDL_DestroyTexture(frame);
+}
+
+void Compositor::InvalidateScene()
+{
+    sceneDirty = true;
+}
+
+void Compositor::Invalidate(const SDL_FRect &rect)
+{
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+    // Whole pixels, plus one on each side for linear filtering at the edges.
+    const int x0 = int(std::floor(rect.x)) - 1;
+    const int y0 = int(std::floor(rect.y)) - 1;
+    const int x1 = int(std::ceil(rect.x + rect.w)) + 1;
+    const int y1 = int(std::ceil(rect.y + rect.h)) + 1;
+    const SDL_Rect screen{0, 0, width, height};
+    SDL_Rect r{x0, y0, x1 - x0, y1 - y0};
+    if (!SDL_GetRectIntersection(&r, &screen, &r))
+        return;
+    if (SDL_RectEmpty(&dirty))
+        dirty = r;
+    else
+        SDL_GetRectUnion(&dirty, &r, &dirty);
+}
+
+void Compositor::InvalidateAll()
+{
+    dirty = {0, 0, width, height};
+}
+
+void Compositor::Render(const std::function<void()> &drawScene,
+                        const std::function<void()> &drawOverlay)
+{
+    CEREKA_TRACE_ZONE("Composite");
+    if (sceneDirty) {
+        CEREKA_TRACE_ZONE("Composite.Scene");
+        SDL_SetRenderTarget(renderer, scene);
+        drawScene();
+        sceneDirty = false;
+        stats.sceneRedraws++;
+        InvalidateAll();
+    }
+
+    if (!SDL_RectEmpty(&dirty)) {
+        CEREKA_TRACE_ZONE("Composite.Dirty");
+        SDL_SetRenderTarget(renderer, frame);
+        SDL_SetRenderClipRect(renderer, &dirty);
+        SDL_FRect area;
+        SDL_RectToFRect(&dirty, &area);
+        SDL_RenderTexture(renderer, scene, &area, &area);
+        drawOverlay();
+        SDL_SetRenderClipRect(renderer, nullptr);
+        stats.redrawnPixels += uint64_t(dirty.w) * uint64_t(dirty.h);
+        dirty = {};
+    }
+
+    SDL_SetRenderTarget(renderer, nullptr);
+    SDL_RenderTexture(renderer, frame, nullptr, nullptr);
+    stats.frames++;
+}
+
+}  // namespace cereka::render
@@ -0,0 +1,83 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <functional>
+
+namespace cereka::render {
+
+struct CompositorStats {
+    uint64_t sceneRedraws = 0;     // times the scene layers were redrawn
+    uint64_t frames = 0;           // frames presented through the compositor
+    uint64_t redrawnPixels = 0;    // pixels recomposited into the frame target
+};
+
+/**
+ * Composites a frame from a cached scene layer and the UI drawn over it.
+ *
+ * The scene (background and characters) is rendered into a target texture
+ * only when InvalidateScene() says it changed. The composited frame lives in
+ * a second target that is updated only inside the dirty rectangle, the union
+ * of the areas passed to Invalidate() since the last frame: there the scene
+ * is copied back and the UI redrawn, clipped. Presenting then costs one copy
+ * of the frame target, since the back buffer does not survive a present.
+ *
+ * A typewriter frame thus redraws just the glyphs it revealed instead of the
+ * whole screen, layers included.
+ */
+class Compositor {
+   public:
+    /**
+     * Create width x height targets. Valid() is false if the renderer cannot
+     * render to textures; draw directly then.
+     */
+    Compositor(SDL_Renderer *renderer,
+               int width,
+               int height);
+    ~Compositor();
+
+    Compositor(const Compositor &) = delete;
+    Compositor &operator=(const Compositor &) = delete;
+
+    bool Valid() const
+    {
+        return scene && frame;
+    }
+
+    /**
+     * The background or characters changed: redraw the scene layer, and
+     * with it the whole frame.
+     */
+    void InvalidateScene();
+
+    /**
+     * Something over the scene changed inside `rect`.
+     */
+    void Invalidate(const SDL_FRect &rect);
+    void InvalidateAll();
+
+    /**
+     * Bring the frame up to date and copy it to the window. `drawScene`
+     * draws the scene layers, `drawOverlay` everything above them; both run
+     * with the target already set, and must submit their draws before
+     * returning.
+     */
+    void Render(const std::function<void()> &drawScene,
+                const std::function<void()> &drawOverlay);
+
+    const CompositorStats &Stats() const
+    {
+        return stats;
+    }
+
+   private:
+    SDL_Renderer *renderer;
+    int width;
+    int height;
+    SDL_Texture *scene = nullptr;
+    SDL_Texture *frame = nullptr;
+    bool sceneDirty = true;
+    SDL_Rect dirty{};  // empty when w or h is 0
+    CompositorStats stats;
+};
+
+}  // namespace cereka::render
@@ -0,0 +1,161 @@
+#include "file_watcher.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
+#ifdef __linux__
+#    include <cerrno>
+#    include <cstring>
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cereka::io {
+
+static void AddUnique(std::vector<std::string> &out,
+                      std::string path)
+{
+    if (std::find(out.begin(), out.end(), path) == out.end())
+        out.push_back(std::move(path));
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+{
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        CEREKA_LOG_WARN("inotify unavailable: {}", std::strerror(errno));
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+bool FileWatcher::Watch(const std::string &dir)
+{
+    std::error_code ec;
+    if (fd < 0 || !fs::is_directory(dir, ec))
+        return false;
+    AddDirectory(dir);
+    const fs::recursive_directory_iterator end;
+    for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec))
+            AddDirectory(it->path().string());
+    }
+    return true;
+}
+
+void FileWatcher::AddDirectory(const std::string &dir)
+{
+    const int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+        CEREKA_LOG_WARN("cannot watch '{}': {}", dir, std::strerror(errno));
+    else
+        dirs[wd] = dir;
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+    std::vector<std::string> changed;
+    if (fd < 0)
+        return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        for (ssize_t offset = 0; offset < n;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += ssize_t(sizeof(inotify_event) + event->len);
+
+            auto it = dirs.find(event->wd);
+            if (it == dirs.end() || event->len == 0)
+                continue;
+            std::string path = it->second + "/" + event->name;
+            if (event->mask & IN_ISDIR) {
+                // Files written into a new directory before it was watched
+                // are missed; editors create directories long before that.
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    AddDirectory(path);
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                AddUnique(changed, std::move(path));
+            }
+        }
+    }
+    return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+static int64_t WriteTime(const fs::path &path)
+{
+    std::error_code ec;
+    const auto t = fs::last_write_time(path, ec);
+    return ec ? 0 : int64_t(t.time_since_epoch().count());
+}
+
+bool FileWatcher::Watch(const std::string &dir)
+{
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec))
+        return false;
+    AddDirectory(dir);
+    return true;
+}
+
+void FileWatcher::AddDirectory(const std::string &dir)
+{
+    roots.push_back(dir);
+    std::error_code ec;
+    const fs::recursive_directory_iterator end;
+    for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec))
+            times[it->path().generic_string()] = WriteTime(it->path());
+    }
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+    std::vector<std::string> changed;
+    const uint64_t now = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count());
+    if (now - lastScanMs < RESCAN_INTERVAL_MS)
+        return changed;
+    lastScanMs = now;
+
+    std::error_code ec;
+    for (const std::string &root : roots) {
+        for (auto it = fs::recursive_directory_iterator(root, ec);
+             !ec && it != fs::recursive_directory_iterator();
+             it.increment(ec))
+        {
+            if (!it->is_regular_file(ec))
+                continue;
+            std::string path = it->path().generic_string();
+            const int64_t t = WriteTime(it->path());
+            auto [entry, inserted] = times.try_emplace(path, t);
+            if (inserted || entry->second != t) {
+                entry->second = t;
+                AddUnique(changed, std::move(path));
+            }
+        }
+    }
+    return changed;
+}
+
+#endif
+
+}  // namespace cereka::io
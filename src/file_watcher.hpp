@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cereka::io {
+
+/**
+ * Reports files that were written under a set of watched directories.
+ *
+ * On Linux this is inotify: the kernel queues an event when a file is
+ * closed after writing or renamed into place (as editors that save through
+ * a temporary file do), and Poll() just drains the queue without blocking.
+ * Elsewhere Poll() compares modification times, at most every
+ * RESCAN_INTERVAL_MS.
+ */
+class FileWatcher {
+   public:
+    static constexpr int RESCAN_INTERVAL_MS = 250;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    /**
+     * Watch `dir` and every directory below it, including ones created
+     * later. Returns false if it cannot be watched.
+     */
+    bool Watch(const std::string &dir);
+
+    /**
+     * Files written since the last call, each once, as `dir/relative/path`
+     * with `dir` as passed to Watch(). Never blocks.
+     */
+    std::vector<std::string> Poll();
+
+   private:
+    void AddDirectory(const std::string &dir);
+
+#ifdef __linux__
+    int fd = -1;
+    std::unordered_map<int, std::string> dirs;  // watch descriptor -> path
+#else
+    std::vector<std::string> roots;
+    std::unordered_map<std::string, int64_t> times;  // path -> last write time
+    uint64_t lastScanMs = 0;
+#endif
+};
+
+}  // namespace cereka::io
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace cereka::hash {
+
+inline constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+inline constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+/**
+ * 64-bit FNV-1a. Used to identify content (program images, source files,
+ * asset names), not for security.
+ */
+inline uint64_t Fnv1a64(const void *data,
+                        size_t size,
+                        uint64_t seed = FNV_OFFSET)
+{
+    const auto *p = static_cast<const unsigned char *>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+inline uint64_t Fnv1a64(std::string_view s,
+                        uint64_t seed = FNV_OFFSET)
+{
+    return Fnv1a64(s.data(), s.size(), seed);
+}
+
+}  // namespace cereka::hash
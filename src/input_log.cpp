@@ -0,0 +1,247 @@
+#include "input_log.hpp"
+#include "Cereka/exceptions.hpp"
+#include "lz.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace cereka::replay {
+
+namespace {
+
+enum class Record : uint8_t { Frame, Event, Skip, SkipSteps };
+
+// Every frame ends with at least a Record::Frame and its dt.
+constexpr uint32_t MIN_FRAME_RECORD = sizeof(Record) + sizeof(float);
+
+template<typename T>
+void Put(std::vector<std::byte> &out,
+         T v)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto *p = reinterpret_cast<const std::byte *>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+class Reader {
+   public:
+    Reader(const std::byte *data,
+           size_t size)
+        : data(data), size(size)
+    {
+    }
+
+    template<typename T>
+    T Get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (sizeof(T) > size - pos)
+            throw engine::error("Input recording truncated");
+        T v;
+        std::memcpy(&v, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+
+    bool AtEnd() const
+    {
+        return pos == size;
+    }
+
+   private:
+    const std::byte *data;
+    size_t size;
+    size_t pos = 0;
+};
+
+bool HasPointer(CerekaEvent::Type type)
+{
+    return type == CerekaEvent::MouseDown || type == CerekaEvent::MouseUp ||
+           type == CerekaEvent::MouseMove || type == CerekaEvent::MouseWheel;
+}
+
+}  // namespace
+
+InputRecorder::InputRecorder(std::string path,
+                             int width,
+                             int height,
+                             uint64_t programHash,
+                             std::vector<std::byte> start,
+                             std::vector<uint64_t> readHistory)
+    : path(std::move(path)),
+      width(width),
+      height(height),
+      programHash(programHash),
+      start(std::move(start)),
+      readHistory(std::move(readHistory))
+{
+}
+
+void InputRecorder::Event(const CerekaEvent &e)
+{
+    Put(records, Record::Event);
+    Put(records, uint8_t(e.type));
+    if (e.type == CerekaEvent::KeyDown)
+        Put(records, int32_t(e.key));
+    if (HasPointer(e.type)) {
+        Put(records, e.mouseX);
+        Put(records, e.mouseY);
+    }
+    if (e.type == CerekaEvent::MouseWheel)
+        Put(records, e.wheel);
+}
+
+void InputRecorder::Skip(SkipMode mode)
+{
+    Put(records, Record::Skip);
+    Put(records, uint8_t(mode));
+}
+
+void InputRecorder::SkipSteps(uint32_t steps)
+{
+    Put(records, Record::SkipSteps);
+    Put(records, steps);
+}
+
+void InputRecorder::EndFrame(float dt)
+{
+    Put(records, Record::Frame);
+    Put(records, dt);
+    frames++;
+}
+
+void InputRecorder::Finish()
+{
+    InputLogHeader header{};
+    std::memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+    header.version = INPUT_LOG_VERSION;
+    header.width = uint32_t(width);
+    header.height = uint32_t(height);
+    header.programHash = programHash;
+    header.frameCount = uint32_t(frames);
+    header.snapshotSize = uint32_t(start.size());
+    header.rawSize = uint32_t(records.size());
+    header.historyWords = uint32_t(readHistory.size());
+
+    // Idle frames repeat the same few bytes and compress very well.
+    std::vector<std::byte> payload = io::Compress(records.data(), records.size());
+    if (payload.size() < records.size())
+        header.flags |= INPUT_LOG_COMPRESSED;
+    else
+        payload = records;
+    header.payloadSize = uint32_t(payload.size());
+
+    std::vector<std::byte> out(sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+    out.insert(out.end(), start.begin(), start.end());
+    const auto *history = reinterpret_cast<const std::byte *>(readHistory.data());
+    out.insert(out.end(), history, history + readHistory.size() * sizeof(uint64_t));
+    out.insert(out.end(), payload.begin(), payload.end());
+    save::WriteFileAtomic(path, out);
+}
+
+InputLog ReadInputLog(const std::string &path)
+{
+    io::MappedFile file;
+    if (!file.Open(path))
+        throw engine::error("Could not open input recording '%s'", path.c_str());
+
+    InputLogHeader header;
+    if (file.Size() < sizeof(header))
+        throw engine::error("Input recording '%s' is too small", path.c_str());
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) != 0)
+        throw engine::error("'%s' is not an input recording", path.c_str());
+    if (header.version != INPUT_LOG_VERSION)
+        throw engine::error("Unsupported input recording version %u (expected %u)",
+                            unsigned(header.version),
+                            unsigned(INPUT_LOG_VERSION));
+    const uint64_t historyBytes = uint64_t(header.historyWords) * sizeof(uint64_t);
+    if (uint64_t(header.snapshotSize) + historyBytes + header.payloadSize !=
+        file.Size() - sizeof(header))
+    {
+        throw engine::error("Input recording '%s' has the wrong size", path.c_str());
+    }
+
+    InputLog log;
+    log.width = int(header.width);
+    log.height = int(header.height);
+    log.programHash = header.programHash;
+    const std::byte *snapshot = file.Data() + sizeof(header);
+    log.start = save::Deserialize(snapshot, header.snapshotSize);
+
+    const std::byte *history = snapshot + header.snapshotSize;
+    log.readHistory.resize(header.historyWords);
+    if (historyBytes > 0)
+        std::memcpy(log.readHistory.data(), history, historyBytes);
+
+    const std::byte *payload = history + historyBytes;
+    // Both sizes come from the file; check them before allocating.
+    const bool compressed = header.flags & INPUT_LOG_COMPRESSED;
+    const size_t maxRaw = compressed ? io::MaxDecompressedSize(header.payloadSize) :
+                                       header.payloadSize;
+    if (header.rawSize > maxRaw || header.frameCount > header.rawSize / MIN_FRAME_RECORD)
+        throw engine::error("Input recording '%s' is corrupt", path.c_str());
+    std::vector<std::byte> raw(header.rawSize);
+    if (compressed) {
+        io::Decompress(payload, header.payloadSize, raw.data(), raw.size());
+    }
+    else {
+        if (header.payloadSize != header.rawSize)
+            throw engine::error("Input recording '%s' has the wrong size", path.c_str());
+        if (!raw.empty())
+            std::memcpy(raw.data(), payload, raw.size());
+    }
+
+    Reader r(raw.data(), raw.size());
+    log.frames.reserve(header.frameCount);
+    InputFrame frame;
+    while (!r.AtEnd()) {
+        switch (r.Get<Record>()) {
+            case Record::Frame:
+                frame.dt = r.Get<float>();
+                log.frames.push_back(std::exchange(frame, {}));
+                break;
+            case Record::Event: {
+                InputAction action;
+                const uint8_t type = r.Get<uint8_t>();
+                if (type > CerekaEvent::Unknown)
+                    throw engine::error("Input recording corrupt: bad event type %u",
+                                        unsigned(type));
+                action.event.type = CerekaEvent::Type(type);
+                if (action.event.type == CerekaEvent::KeyDown)
+                    action.event.key = r.Get<int32_t>();
+                if (HasPointer(action.event.type)) {
+                    action.event.mouseX = r.Get<float>();
+                    action.event.mouseY = r.Get<float>();
+                }
+                if (action.event.type == CerekaEvent::MouseWheel)
+                    action.event.wheel = r.Get<float>();
+                frame.actions.push_back(action);
+                break;
+            }
+            case Record::Skip: {
+                const uint8_t mode = r.Get<uint8_t>();
+                if (mode > uint8_t(SkipMode::All))
+                    throw engine::error("Input recording corrupt: bad skip mode %u",
+                                        unsigned(mode));
+                frame.actions.push_back({InputAction::Skip, {}, SkipMode(mode)});
+                break;
+            }
+            case Record::SkipSteps:
+                frame.skipSteps = r.Get<uint32_t>();
+                break;
+            default:
+                throw engine::error("Input recording corrupt: unknown record");
+        }
+    }
+    // Input after the last frame never reached an Update(); it is dropped.
+    if (log.frames.size() != header.frameCount)
+        throw engine::error("Input recording corrupt: %zu frames, header says %u",
+                            log.frames.size(),
+                            unsigned(header.frameCount));
+    return log;
+}
+
+}  // namespace cereka::replay
@@ -0,0 +1,134 @@
+#pragma once
+#include "Cereka/Cereka.hpp"
+#include "snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cereka::replay {
+
+/*
+ * Input recording (.crkr), little-endian:
+ *
+ *   InputLogHeader
+ *   byte[snapshotSize]   save::Serialize() of the state recording started in
+ *   u64[historyWords]    the read-line history then (save::ReadHistory)
+ *   byte[payloadSize]    record stream, io::Compress()ed if flagged
+ *
+ * The record stream is a sequence of tagged records; a Frame record closes
+ * each frame:
+ *
+ *   Frame      f32 dt                        the frame's Update() delta
+ *   Event      u8 type, then by type:        a HandleEvent() call
+ *                KeyDown     i32 key
+ *                Mouse*      f32 x, f32 y
+ *                MouseWheel  f32 x, f32 y, f32 wheel
+ *   Skip       u8 mode                       a SetSkipMode() call
+ *   SkipSteps  u32 steps                     instructions skip mode ran
+ *
+ * Skip mode is bounded by time while playing; recording how far it got each
+ * frame, and which lines had been read, lets a replay take exactly the same
+ * path on any machine.
+ */
+
+inline constexpr char INPUT_LOG_MAGIC[4] = {'C', 'R', 'K', 'I'};
+inline constexpr uint16_t INPUT_LOG_VERSION = 2;
+
+enum InputLogFlags : uint16_t {
+    INPUT_LOG_COMPRESSED = 1 << 0,
+};
+
+struct InputLogHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t width;  // window size; menu layout and hit testing depend on it
+    uint32_t height;
+    uint64_t programHash;
+    uint32_t frameCount;
+    uint32_t snapshotSize;
+    uint32_t rawSize;      // size of the record stream
+    uint32_t payloadSize;  // bytes of it in the file (== rawSize if uncompressed)
+    uint32_t historyWords;
+    uint32_t reserved;
+};
+static_assert(sizeof(InputLogHeader) == 48);
+
+struct InputAction {
+    enum Kind : uint8_t { Event, Skip };
+    Kind kind = Event;
+    CerekaEvent event;
+    SkipMode skip = SkipMode::Off;
+};
+
+struct InputFrame {
+    std::vector<InputAction> actions;  // in the order they were made
+    float dt = 0.f;
+    std::optional<uint32_t> skipSteps;
+};
+
+struct InputLog {
+    int width = 0;
+    int height = 0;
+    uint64_t programHash = 0;
+    save::Snapshot start;
+    std::vector<uint64_t> readHistory;  // see save::ReadHistory::Words()
+    std::vector<InputFrame> frames;
+};
+
+/**
+ * Collects a session's input in memory and writes it out on Finish().
+ * A frame with no input costs five bytes.
+ */
+class InputRecorder {
+   public:
+    /**
+     * `start` is the serialized state the session starts from and
+     * `readHistory` the lines read by then.
+     */
+    InputRecorder(std::string path,
+                  int width,
+                  int height,
+                  uint64_t programHash,
+                  std::vector<std::byte> start,
+                  std::vector<uint64_t> readHistory);
+
+    void Event(const CerekaEvent &e);
+    void Skip(SkipMode mode);
+    void SkipSteps(uint32_t steps);
+    void EndFrame(float dt);
+
+    size_t Frames() const
+    {
+        return frames;
+    }
+
+    const std::string &Path() const
+    {
+        return path;
+    }
+
+    /**
+     * Write the recording. Throws engine::error on I/O failure.
+     */
+    void Finish();
+
+   private:
+    std::string path;
+    int width;
+    int height;
+    uint64_t programHash;
+    std::vector<std::byte> start;
+    std::vector<uint64_t> readHistory;
+    std::vector<std::byte> records;
+    size_t frames = 0;
+};
+
+/**
+ * Read a recording. Throws engine::error if it is missing or malformed.
+ */
+InputLog ReadInputLog(const std::string &path);
+
+}  // namespace cereka::replay
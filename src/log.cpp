@@ -0,0 +1,314 @@
+#include "log.hpp"
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cereka::log {
+
+namespace {
+
+constexpr size_t RING_SIZE = 4096;  // power of two
+
+/*
+ * Bounded multi-producer queue (Vyukov). Each slot carries a sequence number
+ * that tells producers and the single consumer whose turn it is, so neither
+ * side takes a lock.
+ */
+class Ring {
+   public:
+    Ring() : slots(RING_SIZE)
+    {
+        for (size_t i = 0; i < RING_SIZE; ++i)
+            slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool Push(const detail::Record &r)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & (RING_SIZE - 1)];
+            const size_t seq = slot.seq.load(std::memory_order_acquire);
+            const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = r;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;  // full
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Pop(detail::Record &out)
+    {
+        Slot &slot = slots[head & (RING_SIZE - 1)];
+        const size_t seq = slot.seq.load(std::memory_order_acquire);
+        if (intptr_t(seq) - intptr_t(head + 1) < 0)
+            return false;  // empty
+        out = slot.record;
+        slot.seq.store(head + RING_SIZE, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+   private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        detail::Record record;
+    };
+
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;  // consumer only
+};
+
+class Logger {
+   public:
+    Logger() : worker([this] { Run(); }) {}
+
+    ~Logger()
+    {
+        stopping.store(true, std::memory_order_release);
+        Wake();
+        worker.join();
+    }
+
+    void Submit(const detail::Record &r)
+    {
+        if (!ring.Push(r)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        submitted.fetch_add(1, std::memory_order_release);
+        Wake();
+    }
+
+    void Flush()
+    {
+        const uint64_t target = submitted.load(std::memory_order_acquire);
+        uint64_t done = written.load(std::memory_order_acquire);
+        while (done < target) {
+            Wake();
+            written.wait(done, std::memory_order_acquire);
+            done = written.load(std::memory_order_acquire);
+        }
+    }
+
+    std::atomic<Level> level{Level::Info};
+    std::atomic<FILE *> output{stderr};
+    std::atomic<uint64_t> dropped{0};
+
+   private:
+    void Wake()
+    {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+
+    void Run()
+    {
+        detail::Record r;
+        std::string line;
+        for (;;) {
+            const uint32_t seen = signal.load(std::memory_order_acquire);
+            bool any = false;
+            while (ring.Pop(r)) {
+                Format(r, line);
+                std::fwrite(line.data(), 1, line.size(), output.load(std::memory_order_relaxed));
+                written.fetch_add(1, std::memory_order_release);
+                any = true;
+            }
+            if (any) {
+                std::fflush(output.load(std::memory_order_relaxed));
+                written.notify_all();
+            }
+            if (stopping.load(std::memory_order_acquire)) {
+                if (!ring.Pop(r))
+                    return;
+                Format(r, line);
+                std::fwrite(line.data(), 1, line.size(), output.load(std::memory_order_relaxed));
+                written.fetch_add(1, std::memory_order_release);
+                continue;
+            }
+            signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    static void Format(const detail::Record &r,
+                       std::string &out);
+
+    Ring ring;
+    std::atomic<uint32_t> signal{0};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+};
+
+const char *LevelName(Level level)
+{
+    switch (level) {
+        case Level::Trace:
+            return "TRACE";
+        case Level::Debug:
+            return "DEBUG";
+        case Level::Info:
+            return "INFO";
+        case Level::Warn:
+            return "WARN";
+        case Level::Error:
+            return "ERROR";
+        default:
+            return "?";
+    }
+}
+
+void AppendArg(const detail::Record &r,
+               size_t index,
+               size_t &offset,
+               std::string &out)
+{
+    char buf[32];
+    auto take = [&](auto &v) {
+        std::memcpy(&v, r.payload + offset, sizeof(v));
+        offset += sizeof(v);
+    };
+
+    switch (r.types[index]) {
+        case detail::ArgType::Int: {
+            int64_t v;
+            take(v);
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+            break;
+        }
+        case detail::ArgType::Uint: {
+            uint64_t v;
+            take(v);
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+            break;
+        }
+        case detail::ArgType::Double: {
+            double v;
+            take(v);
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+            break;
+        }
+        case detail::ArgType::Bool: {
+            uint8_t v;
+            take(v);
+            out += v ? "true" : "false";
+            break;
+        }
+        case detail::ArgType::Char: {
+            char v;
+            take(v);
+            out += v;
+            break;
+        }
+        case detail::ArgType::String: {
+            uint16_t len;
+            take(len);
+            out.append(reinterpret_cast<const char *>(r.payload + offset), len);
+            offset += len;
+            break;
+        }
+    }
+}
+
+void Logger::Format(const detail::Record &r,
+                    std::string &out)
+{
+    char stamp[32];
+    std::snprintf(stamp, sizeof(stamp), "[%10.3f] ", r.timeNs / 1e9);
+    out.assign(stamp);
+    out += '[';
+    out += LevelName(r.level);
+    out += "] ";
+
+    size_t arg = 0;
+    size_t offset = 0;
+    for (const char *p = r.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (arg < r.argCount)
+                AppendArg(r, arg++, offset, out);
+            ++p;
+        }
+        else if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            out += *p++;
+        }
+        else {
+            out += *p;
+        }
+    }
+    if (out.empty() || out.back() != '\n')
+        out += '\n';
+}
+
+Logger &Instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+const auto g_start = std::chrono::steady_clock::now();
+
+}  // namespace
+
+void SetLevel(Level level)
+{
+    Instance().level.store(level, std::memory_order_relaxed);
+}
+
+Level GetLevel()
+{
+    return Instance().level.load(std::memory_order_relaxed);
+}
+
+void SetOutput(FILE *out)
+{
+    Instance().Flush();
+    Instance().output.store(out ? out : stderr, std::memory_order_relaxed);
+}
+
+void Flush()
+{
+    Instance().Flush();
+}
+
+uint64_t DroppedCount()
+{
+    return Instance().dropped.load(std::memory_order_relaxed);
+}
+
+namespace detail {
+
+void Initialize(Record &r,
+                Level level,
+                const char *format)
+{
+    r.timeNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - g_start)
+                            .count());
+    r.format = format;
+    r.level = level;
+    r.argCount = 0;
+    r.used = 0;
+}
+
+void Submit(const Record &r)
+{
+    Instance().Submit(r);
+}
+
+}  // namespace detail
+
+}  // namespace cereka::log
@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+ * Asynchronous structured logging.
+ *
+ *   CEREKA_LOG_INFO("entered menu with {} buttons", count);
+ *
+ * The calling thread only copies the format pointer and the raw arguments
+ * into a slot of a lock-free ring buffer; substituting the `{}` placeholders
+ * and the actual I/O happen on a background thread. If the ring is full the
+ * message is dropped (and counted) rather than blocking the caller.
+ *
+ * Levels below CEREKA_LOG_MIN_LEVEL are compiled out entirely, arguments
+ * included; the rest are filtered at runtime with SetLevel(). Format strings
+ * must be string literals.
+ */
+
+#define CEREKA_LOG_LEVEL_TRACE 0
+#define CEREKA_LOG_LEVEL_DEBUG 1
+#define CEREKA_LOG_LEVEL_INFO 2
+#define CEREKA_LOG_LEVEL_WARN 3
+#define CEREKA_LOG_LEVEL_ERROR 4
+
+#ifndef CEREKA_LOG_MIN_LEVEL
+#    define CEREKA_LOG_MIN_LEVEL CEREKA_LOG_LEVEL_DEBUG
+#endif
+
+namespace cereka::log {
+
+enum class Level : uint8_t { Trace, Debug, Info, Warn, Error, Off };
+
+void SetLevel(Level level);
+Level GetLevel();
+
+inline bool ShouldLog(Level level)
+{
+    return level >= GetLevel();
+}
+
+/**
+ * Send formatted lines to `out` instead of stderr. The stream is not closed.
+ */
+void SetOutput(FILE *out);
+
+/**
+ * Block until every message queued so far has been written.
+ */
+void Flush();
+
+/**
+ * Messages dropped because the ring buffer was full.
+ */
+uint64_t DroppedCount();
+
+namespace detail {
+
+enum class ArgType : uint8_t { Int, Uint, Double, Bool, Char, String };
+
+inline constexpr size_t MAX_ARGS = 8;
+inline constexpr size_t PAYLOAD_SIZE = 200;
+
+struct Record {
+    uint64_t timeNs;
+    const char *format;
+    Level level;
+    uint8_t argCount;
+    uint16_t used;
+    ArgType types[MAX_ARGS];
+    unsigned char payload[PAYLOAD_SIZE];
+};
+
+class Encoder {
+   public:
+    explicit Encoder(Record &r) : r(r) {}
+
+    template<typename T>
+    void Add(const T &value)
+    {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>)
+            Put(ArgType::Bool, uint8_t(value));
+        else if constexpr (std::is_same_v<U, char>)
+            Put(ArgType::Char, value);
+        else if constexpr (std::is_enum_v<U>)
+            Put(ArgType::Int, int64_t(value));
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+            Put(ArgType::Int, int64_t(value));
+        else if constexpr (std::is_integral_v<U>)
+            Put(ArgType::Uint, uint64_t(value));
+        else if constexpr (std::is_floating_point_v<U>)
+            Put(ArgType::Double, double(value));
+        else if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+            PutString(value ? std::string_view(value) : std::string_view("(null)"));
+        else if constexpr (std::is_convertible_v<const U &, std::string_view>)
+            PutString(std::string_view(value));
+        else
+            static_assert(sizeof(U) == 0, "unsupported log argument type");
+    }
+
+   private:
+    template<typename V>
+    void Put(ArgType type,
+             V v)
+    {
+        if (r.argCount >= MAX_ARGS || r.used + sizeof(V) > PAYLOAD_SIZE)
+            return;
+        r.types[r.argCount++] = type;
+        std::memcpy(r.payload + r.used, &v, sizeof(V));
+        r.used += sizeof(V);
+    }
+
+    void PutString(std::string_view s)
+    {
+        if (r.argCount >= MAX_ARGS || r.used + sizeof(uint16_t) > PAYLOAD_SIZE)
+            return;
+        const size_t room = PAYLOAD_SIZE - r.used - sizeof(uint16_t);
+        const uint16_t len = uint16_t(s.size() < room ? s.size() : room);
+        r.types[r.argCount++] = ArgType::String;
+        std::memcpy(r.payload + r.used, &len, sizeof(len));
+        std::memcpy(r.payload + r.used + sizeof(len), s.data(), len);
+        r.used += uint16_t(sizeof(len) + len);
+    }
+
+    Record &r;
+};
+
+void Initialize(Record &r,
+                Level level,
+                const char *format);
+void Submit(const Record &r);
+
+}  // namespace detail
+
+template<typename... Args>
+void Write(Level level,
+           const char *format,
+           const Args &...args)
+{
+    detail::Record r;
+    detail::Initialize(r, level, format);
+    detail::Encoder enc(r);
+    (enc.Add(args), ...);
+    detail::Submit(r);
+}
+
+}  // namespace cereka::log
+
+#define CEREKA_LOG_AT_(level, fmt, ...) \
+    do { \
+        if (::cereka::log::ShouldLog(level)) \
+            ::cereka::log::Write(level, fmt __VA_OPT__(, ) __VA_ARGS__); \
+    } while (0)
+
+#if CEREKA_LOG_MIN_LEVEL <= CEREKA_LOG_LEVEL_TRACE
+#    define CEREKA_LOG_TRACE(fmt, ...) \
+        CEREKA_LOG_AT_(::cereka::log::Level::Trace, fmt __VA_OPT__(, ) __VA_ARGS__)
+#else
+#    define CEREKA_LOG_TRACE(fmt, ...) ((void)0)
+#endif
+
+#if CEREKA_LOG_MIN_LEVEL <= CEREKA_LOG_LEVEL_DEBUG
+#    define CEREKA_LOG_DEBUG(fmt, ...) \
+        CEREKA_LOG_AT_(::cereka::log::Level::Debug, fmt __VA_OPT__(, ) __VA_ARGS__)
+#else
+#    define CEREKA_LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+
+#if CEREKA_LOG_MIN_LEVEL <= CEREKA_LOG_LEVEL_INFO
+#    define CEREKA_LOG_INFO(fmt, ...) \
+        CEREKA_LOG_AT_(::cereka::log::Level::Info, fmt __VA_OPT__(, ) __VA_ARGS__)
+#else
+#    define CEREKA_LOG_INFO(fmt, ...) ((void)0)
+#endif
+
+#if CEREKA_LOG_MIN_LEVEL <= CEREKA_LOG_LEVEL_WARN
+#    define CEREKA_LOG_WARN(fmt, ...) \
+        CEREKA_LOG_AT_(::cereka::log::Level::Warn, fmt __VA_OPT__(, ) __VA_ARGS__)
+#else
+#    define CEREKA_LOG_WARN(fmt, ...) ((void)0)
+#endif
+
+#define CEREKA_LOG_ERROR(fmt, ...) \
+    CEREKA_LOG_AT_(::cereka::log::Level::Error, fmt __VA_OPT__(, ) __VA_ARGS__)
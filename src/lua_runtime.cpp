@@ -0,0 +1,182 @@
+#include "lua_runtime.hpp"
+#include "Cereka/exceptions.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace cereka::scripting {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool ReadFile(const std::string &path,
+              std::string &out)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string CacheName(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.luac", static_cast<unsigned long long>(key));
+    return name;
+}
+
+}  // namespace
+
+LuaRuntime::LuaRuntime(ScriptHost &host) : host(host)
+{
+    lua.open_libraries(sol::lib::base,
+                       sol::lib::string,
+                       sol::lib::table,
+                       sol::lib::math,
+                       sol::lib::coroutine);
+    Bind();
+}
+
+void LuaRuntime::Bind()
+{
+    lua.set_function("bg", [this](const std::string &name) { host.ScriptBackground(name); });
+    lua.set_function("show", [this](const std::string &id, sol::optional<std::string> expression) {
+        host.ScriptShow(id, expression ? *expression : std::string());
+    });
+    lua.set_function("hide", [this](const std::string &id) { host.ScriptHide(id); });
+    lua.set_function("bgm", [this](sol::optional<std::string> name) {
+        host.ScriptMusic(name ? *name : std::string());
+    });
+    lua.set_function("sfx", [this](const std::string &name) { host.ScriptSound(name); });
+    lua.set_function("voice", [this](const std::string &name) { host.ScriptVoice(name); });
+
+    // Blocking calls: sol::yielding suspends the coroutine when they return.
+    lua.set_function("say",
+                     sol::yielding([this](const std::string &speaker, const std::string &text) {
+                         host.ScriptSay(speaker, text);
+                     }));
+    lua.set_function("narrate", sol::yielding([this](const std::string &text) {
+                         host.ScriptSay({}, text);
+                     }));
+    lua.set_function("menu", sol::yielding([this](sol::table choices) {
+                         // Nothing could be picked to resume the script.
+                         if (choices.size() == 0)
+                             throw sol::error("menu has no buttons");
+                         std::vector<std::string> labels;
+                         for (size_t i = 1; i <= choices.size(); ++i)
+                             labels.push_back(choices.get<std::string>(i));
+                         host.ScriptMenu(labels);
+                     }));
+}
+
+std::string LuaRuntime::Dump(const sol::protected_function &fn)
+{
+    sol::protected_function dump = lua["string"]["dump"];
+    sol::protected_function_result bytes = dump(fn);
+    if (!bytes.valid()) {
+        sol::error err = bytes;
+        throw engine::error("Could not dump Lua bytecode: %s", err.what());
+    }
+    return bytes.get<std::string>();
+}
+
+void LuaRuntime::Load(const std::string &filename)
+{
+    CEREKA_TRACE_ZONE("Lua.Load");
+    const uint64_t start = trace::NowNs();
+
+    std::string source;
+    if (!ReadFile(filename, source))
+        throw engine::error("Could not open script '%s'", filename.c_str());
+
+    const std::string chunkName = "@" + filename;
+    const uint64_t key =
+        hash::Fnv1a64(source, hash::Fnv1a64(std::string(LUA_VERSION) + chunkName));
+    const std::string cachePath =
+        cacheDir.empty() ? std::string() : cacheDir + "/" + CacheName(key);
+
+    sol::protected_function fn;
+    bool loaded = false;
+
+    std::string code;
+    if (!cachePath.empty() && ReadFile(cachePath, code)) {
+        sol::load_result cached =
+            lua.load_buffer(code.data(), code.size(), chunkName, sol::load_mode::binary);
+        if (cached.valid()) {
+            fn = cached;
+            loaded = true;
+            stats.cacheHits++;
+        }
+        else {
+            CEREKA_LOG_WARN("ignoring unreadable Lua cache entry {}", cachePath);
+        }
+    }
+
+    if (!loaded) {
+        stats.cacheMisses++;
+        sol::load_result parsed =
+            lua.load_buffer(source.data(), source.size(), chunkName, sol::load_mode::text);
+        if (!parsed.valid()) {
+            sol::error err = parsed;
+            throw engine::error("Lua compile error in %s: %s", filename.c_str(), err.what());
+        }
+        fn = parsed;
+
+        if (!cachePath.empty()) {
+            try {
+                code = Dump(fn);
+                const auto *bytes = reinterpret_cast<const std::byte *>(code.data());
+                fs::create_directories(cacheDir);
+                save::WriteFileAtomic(cachePath,
+                                      std::vector<std::byte>(bytes, bytes + code.size()));
+            }
+            catch (const std::exception &e) {
+                CEREKA_LOG_WARN("could not cache Lua bytecode: {}", e.what());
+            }
+        }
+    }
+
+    // The coroutine lives on its own Lua thread so that yielding never
+    // disturbs the main state.
+    runner = sol::thread::create(lua.lua_state());
+    script = sol::coroutine(runner.thread_state(), fn);
+    running = true;
+
+    stats.loadNs += trace::NowNs() - start;
+    CEREKA_LOG_DEBUG("loaded script {} (bytecode cache {})", filename, loaded ? "hit" : "miss");
+}
+
+bool LuaRuntime::Resume(int choice)
+{
+    if (!running)
+        return false;
+
+    CEREKA_TRACE_ZONE("Lua.Resume");
+    const uint64_t start = trace::NowNs();
+    sol::protected_function_result result = choice > 0 ? script(choice) : script();
+    const uint64_t elapsed = trace::NowNs() - start;
+
+    stats.resumes++;
+    stats.resumeNs += elapsed;
+    if (elapsed > stats.maxResumeNs)
+        stats.maxResumeNs = elapsed;
+
+    if (!result.valid()) {
+        sol::error err = result;
+        CEREKA_LOG_ERROR("Lua script error: {}", err.what());
+        running = false;
+    }
+    else if (result.status() != sol::call_status::yielded) {
+        running = false;
+    }
+    return running;
+}
+
+}  // namespace cereka::scripting
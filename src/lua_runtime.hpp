@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <sol/sol.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cereka::scripting {
+
+/**
+ * What a Lua script can do to the engine. Calls arrive on the main thread
+ * from inside LuaRuntime::Resume().
+ */
+class ScriptHost {
+   public:
+    virtual ~ScriptHost() = default;
+
+    virtual void ScriptBackground(std::string_view name) = 0;
+    virtual void ScriptShow(std::string_view id,
+                            std::string_view expression) = 0;
+    virtual void ScriptHide(std::string_view id) = 0;
+
+    /**
+     * Audio. An empty music name stops the music; a voice line plays with
+     * the next say() or narrate().
+     */
+    virtual void ScriptMusic(std::string_view name) = 0;
+    virtual void ScriptSound(std::string_view name) = 0;
+    virtual void ScriptVoice(std::string_view name) = 0;
+
+    /**
+     * Show a line; the script is suspended until the host resumes it.
+     * An empty speaker means narration.
+     */
+    virtual void ScriptSay(std::string_view speaker,
+                           std::string_view text) = 0;
+
+    /**
+     * Offer choices; the script is suspended until the host resumes it with
+     * the 1-based index of the chosen one.
+     */
+    virtual void ScriptMenu(const std::vector<std::string> &choices) = 0;
+};
+
+struct ScriptStats {
+    uint64_t resumes = 0;
+    uint64_t resumeNs = 0;  // total time spent inside Resume()
+    uint64_t maxResumeNs = 0;
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t loadNs = 0;  // time spent loading (and compiling) scripts
+};
+
+/**
+ * Runs a Lua script as a coroutine against a ScriptHost.
+ *
+ * The script calls plain functions -- bg, show, hide, bgm, sfx, voice, say,
+ * narrate, menu -- and the blocking ones (say, narrate, menu) yield back to
+ * the engine, which resumes the script once the player has read the line or
+ * picked a choice:
+ *
+ *   bg("street.png")
+ *   show("alice")
+ *   say("Alice", "Morning!")
+ *   if menu{"Wave", "Ignore"} == 1 then narrate("She waves back.") end
+ *
+ * A bare coroutine.yield() waits for the next frame.
+ *
+ * Scripts are compiled once to Lua bytecode (string.dump) and the result is
+ * cached as <cacheDir>/<hash>.luac, keyed by the source text, file name and
+ * Lua version, so later runs skip parsing. The cache is trusted input.
+ */
+class LuaRuntime {
+   public:
+    explicit LuaRuntime(ScriptHost &host);
+
+    LuaRuntime(const LuaRuntime &) = delete;
+    LuaRuntime &operator=(const LuaRuntime &) = delete;
+
+    /**
+     * Directory for cached bytecode. Empty (the default) disables the cache.
+     */
+    void SetCacheDir(std::string dir)
+    {
+        cacheDir = std::move(dir);
+    }
+
+    /**
+     * Load `filename` and make it the running script, replacing any previous
+     * one. Throws engine::error if it cannot be read or compiled.
+     */
+    void Load(const std::string &filename);
+
+    /**
+     * Run the script until it next yields. `choice` is passed back as the
+     * result of a pending menu() call (0 for none). Returns false once the
+     * script has finished or failed; errors are logged.
+     */
+    bool Resume(int choice = 0);
+
+    bool Running() const
+    {
+        return running;
+    }
+
+    const ScriptStats &Stats() const
+    {
+        return stats;
+    }
+
+   private:
+    void Bind();
+    std::string Dump(const sol::protected_function &fn);
+
+    ScriptHost &host;
+    std::string cacheDir;
+    sol::state lua;
+    sol::thread runner;
+    sol::coroutine script;
+    bool running = false;
+    ScriptStats stats;
+};
+
+}  // namespace cereka::scripting
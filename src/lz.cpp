@@ -0,0 +1,153 @@
+#include "lz.hpp"
+#include "Cereka/exceptions.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace cereka::io {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+// The last bytes are always emitted as literals so the match finder never
+// reads past the end of the input.
+constexpr size_t TAIL_LITERALS = 8;
+
+uint32_t Load32(const std::byte *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t Hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths of 15 and more spill into extra bytes, 255 at a time.
+void PutLength(std::vector<std::byte> &out,
+               size_t n)
+{
+    for (; n >= 255; n -= 255)
+        out.push_back(std::byte{255});
+    out.push_back(std::byte(n));
+}
+
+void PutSequence(std::vector<std::byte> &out,
+                 const std::byte *literals,
+                 size_t literalCount,
+                 size_t offset,
+                 size_t matchLength)
+{
+    const size_t m = matchLength ? matchLength - MIN_MATCH : 0;
+    const size_t high = literalCount < 15 ? literalCount : 15;
+    const uint8_t token = uint8_t(high << 4 | (m < 15 ? m : 15));
+    out.push_back(std::byte(token));
+    if (literalCount >= 15)
+        PutLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (!matchLength)
+        return;
+    out.push_back(std::byte(offset & 0xff));
+    out.push_back(std::byte(offset >> 8));
+    if (m >= 15)
+        PutLength(out, m - 15);
+}
+
+}  // namespace
+
+std::vector<std::byte> Compress(const std::byte *data,
+                                size_t size)
+{
+    std::vector<std::byte> out;
+    out.reserve(size / 2 + 16);
+
+    uint32_t table[1 << HASH_BITS];
+    std::memset(table, 0xff, sizeof(table));
+
+    size_t anchor = 0;
+    size_t i = 0;
+    const size_t limit = size > TAIL_LITERALS ? size - TAIL_LITERALS : 0;
+    while (i < limit) {
+        const uint32_t v = Load32(data + i);
+        const uint32_t h = Hash(v);
+        const size_t candidate = table[h];
+        table[h] = uint32_t(i);
+
+        if (candidate == 0xffffffffu || i - candidate > MAX_OFFSET ||
+            Load32(data + candidate) != v)
+        {
+            i++;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (i + length < limit && data[candidate + length] == data[i + length])
+            length++;
+
+        PutSequence(out, data + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+
+    PutSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+void Decompress(const std::byte *data,
+                size_t size,
+                std::byte *out,
+                size_t rawSize)
+{
+    size_t in = 0;
+    size_t pos = 0;
+
+    auto length = [&](size_t n) {
+        if (n != 15)
+            return n;
+        for (;;) {
+            if (in >= size)
+                throw engine::error("Compressed stream truncated");
+            const uint8_t b = uint8_t(data[in++]);
+            n += b;
+            if (b != 255)
+                return n;
+        }
+    };
+
+    while (in < size) {
+        const uint8_t token = uint8_t(data[in++]);
+
+        const size_t literals = length(token >> 4);
+        if (literals > size - in || literals > rawSize - pos)
+            throw engine::error("Compressed stream corrupt (literal run)");
+        if (literals)
+            std::memcpy(out + pos, data + in, literals);
+        in += literals;
+        pos += literals;
+
+        if (in == size)
+            break;  // final sequence has no match
+
+        if (size - in < 2)
+            throw engine::error("Compressed stream truncated");
+        const size_t offset = size_t(uint8_t(data[in])) | size_t(uint8_t(data[in + 1])) << 8;
+        in += 2;
+        const size_t match = length(token & 15) + MIN_MATCH;
+        if (offset == 0 || offset > pos || match > rawSize - pos)
+            throw engine::error("Compressed stream corrupt (match)");
+
+        // Byte by byte: matches may overlap their own output.
+        const std::byte *src = out + pos - offset;
+        for (size_t k = 0; k < match; ++k)
+            out[pos + k] = src[k];
+        pos += match;
+    }
+
+    if (pos != rawSize)
+        throw engine::error("Compressed stream has %zu bytes, expected %zu", pos, rawSize);
+}
+
+}  // namespace cereka::io
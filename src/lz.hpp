@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cereka::io {
+
+/**
+ * Small LZ77 byte compressor (LZ4-style sequences of literals and matches
+ * with 16-bit offsets). It is tuned for speed on small, repetitive buffers
+ * such as save snapshots, not for ratio. The stream does not record the
+ * decompressed size; containers store it next to the data.
+ */
+std::vector<std::byte> Compress(const std::byte *data,
+                                size_t size);
+
+/**
+ * Upper bound on what `size` bytes of a Compress() stream can expand to
+ * (a length byte of 255 is worth 255 output bytes). Containers check a
+ * stored size against it before allocating.
+ */
+constexpr size_t MaxDecompressedSize(size_t size)
+{
+    return size > SIZE_MAX / 255 ? SIZE_MAX : size * 255;
+}
+
+/**
+ * Decode a Compress() stream that expands to exactly `rawSize` bytes into
+ * `out`. Throws engine::error if the stream is corrupt or has the wrong size.
+ */
+void Decompress(const std::byte *data,
+                size_t size,
+                std::byte *out,
+                size_t rawSize);
+
+}  // namespace cereka::io
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace cereka::io {
+
+/**
+ * Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+   public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * Map `path` read-only. Returns false (leaving the object empty) if the
+     * file cannot be opened or mapped. Empty files map to a null view.
+     */
+    bool Open(const std::string &path);
+    void Close();
+
+    const std::byte *Data() const
+    {
+        return data;
+    }
+    size_t Size() const
+    {
+        return size;
+    }
+    bool IsOpen() const
+    {
+        return open;
+    }
+
+   private:
+    const std::byte *data = nullptr;
+    size_t size = 0;
+    bool open = false;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+}  // namespace cereka::io
@@ -0,0 +1,312 @@
+#include "program_analysis.hpp"
+#include "Cereka/exceptions.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace cereka::scenario {
+
+namespace {
+
+bool IsAssetOp(Op op)
+{
+    return op == Op::BG || op == Op::CHAR || op == Op::BGM || op == Op::SFX || op == Op::VOICE;
+}
+
+std::string At(size_t pc)
+{
+    return "instruction " + std::to_string(pc) + ": ";
+}
+
+}  // namespace
+
+std::shared_ptr<const ProgramAnalysis> ProgramAnalysis::Analyze(
+    std::shared_ptr<const Bytecode> program)
+{
+    CEREKA_TRACE_ZONE("AnalyzeProgram");
+    std::shared_ptr<ProgramAnalysis> result(new ProgramAnalysis());
+    ProgramAnalysis &a = *result;
+    a.program = std::move(program);
+    const Bytecode &code = *a.program;
+    const size_t n = code.Size();
+    std::string errors;
+
+    // Opcodes, labels and assets.
+    std::unordered_map<std::string_view, size_t> labels;
+    std::map<std::pair<Op, std::string_view>, int32_t> assetIndex;
+    a.assetAt.assign(n, -1);
+    bool haveEntry = false;
+    for (size_t i = 0; i < n; ++i) {
+        const Op op = code.OpAt(i);
+        if (uint8_t(op) > uint8_t(Op::HIDE)) {
+            errors += At(i) + "unknown opcode " + std::to_string(unsigned(op)) + "\n";
+            continue;
+        }
+        if (op == Op::LABEL) {
+            auto [it, inserted] = labels.emplace(code.A(i), i);
+            if (!inserted)
+                errors += At(i) + "label '" + std::string(code.A(i)) +
+                          "' is already defined at instruction " + std::to_string(it->second) +
+                          "\n";
+        }
+        else if (op == Op::MENU && !haveEntry) {
+            a.entry = i;
+            haveEntry = true;
+        }
+        else if (IsAssetOp(op) && !code.A(i).empty()) {
+            auto [it, inserted] =
+                assetIndex.try_emplace({op, code.A(i)}, int32_t(a.assets.size()));
+            if (inserted)
+                a.assets.push_back({op, code.A(i)});
+            a.assetAt[i] = it->second;
+        }
+    }
+
+    // Resolved target of the JUMP or BUTTON at `i`; NO_TARGET, after
+    // recording why, if it has none.
+    auto target = [&](size_t i) -> uint32_t {
+        const uint32_t t = code.Target(i);
+        const std::string_view label = code.OpAt(i) == Op::JUMP ? code.A(i) : code.B(i);
+        if (t != NO_TARGET && t < n)
+            return t;
+        if (t != NO_TARGET)
+            errors += At(i) + "target " + std::to_string(t) + " is out of range\n";
+        else if (!label.empty())
+            errors += At(i) + "unknown label '" + std::string(label) + "'\n";
+        else if (code.OpAt(i) == Op::JUMP)
+            errors += At(i) + "jump without a label\n";
+        return NO_TARGET;
+    };
+
+    // Bytecode::Bind() has checked the choice ranges of every instruction
+    // but JUMP and BUTTON, whose `arg` is their target instead.
+    for (size_t i = 0; i < n; ++i) {
+        if (code.OpAt(i) == Op::JUMP || code.OpAt(i) == Op::BUTTON)
+            continue;
+        for (size_t c = 0; c < code.ChoiceCount(i); ++c) {
+            const PackedChoice &choice = code.Choice(i, c);
+            if (choice.target == NO_TARGET && !code.String(choice.label).empty())
+                errors +=
+                    At(i) + "unknown label '" + std::string(code.String(choice.label)) + "'\n";
+        }
+    }
+
+    // Menu tables: a MENU and the BG and BUTTON lines after it.
+    a.menuAt.assign(n, -1);
+    std::vector<bool> inMenu(n, false);
+    for (size_t i = 0; i < n; ++i) {
+        if (code.OpAt(i) != Op::MENU)
+            continue;
+        MenuTable menu{uint32_t(i), uint32_t(i + 1), {}, {}};
+        while (menu.end < n &&
+               (code.OpAt(menu.end) == Op::BG || code.OpAt(menu.end) == Op::BUTTON))
+        {
+            inMenu[menu.end] = true;
+            menu.end++;
+        }
+        for (uint32_t j = menu.begin + 1; j < menu.end; ++j) {
+            if (code.OpAt(j) == Op::BG) {
+                menu.background = code.A(j);
+                continue;
+            }
+            const bool exit = code.ExitButton(j);
+            const uint32_t t = target(j);
+            menu.buttons.push_back({code.A(j), exit || t == NO_TARGET ? menu.end : t, exit});
+        }
+        if (menu.buttons.empty())
+            errors += At(i) + "menu has no buttons\n";
+        a.menuAt[i] = int32_t(a.menus.size());
+        a.menus.push_back(std::move(menu));
+    }
+
+    // Basic blocks. Leaders are the entry point, jump and button targets,
+    // menus and whatever follows a jump, an end or a menu block.
+    std::vector<bool> leader(n + 1, false);
+    leader[0] = true;
+    leader[a.entry] = true;
+    for (size_t i = 0; i < n; ++i) {
+        const Op op = code.OpAt(i);
+        if (op == Op::JUMP) {
+            const uint32_t t = target(i);
+            if (t != NO_TARGET)
+                leader[t] = true;
+            leader[i + 1] = true;
+        }
+        else if (op == Op::END) {
+            leader[i + 1] = true;
+        }
+        else if (op == Op::BUTTON && !inMenu[i]) {
+            target(i);
+            a.warnings.push_back(At(i) + "button '" + std::string(code.A(i)) +
+                                 "' is not part of a menu and is skipped");
+        }
+    }
+    for (const MenuTable &menu : a.menus) {
+        leader[menu.begin] = true;
+        leader[menu.end] = true;
+        for (const MenuButton &button : menu.buttons) {
+            if (button.target < n)
+                leader[button.target] = true;
+        }
+    }
+
+    a.blockOf.assign(n, 0);
+    for (size_t i = 0; i < n;) {
+        const uint32_t index = uint32_t(a.blocks.size());
+        size_t end = i + 1;
+        if (a.menuAt[i] >= 0)
+            end = a.menus[a.menuAt[i]].end;
+        else {
+            while (end < n && !leader[end])
+                end++;
+        }
+        for (size_t j = i; j < end; ++j)
+            a.blockOf[j] = index;
+        a.blocks.push_back({uint32_t(i), uint32_t(end), {}, false});
+        i = end;
+    }
+
+    for (BasicBlock &block : a.blocks) {
+        auto link = [&](size_t pc) {
+            if (pc >= n)
+                return;
+            const uint32_t succ = a.blockOf[pc];
+            std::vector<uint32_t> &succs = block.successors;
+            if (std::find(succs.begin(), succs.end(), succ) == succs.end())
+                succs.push_back(succ);
+        };
+        const size_t last = block.end - 1;
+        const Op op = code.OpAt(last);
+        if (a.menuAt[block.begin] >= 0) {
+            for (const MenuButton &button : a.menus[a.menuAt[block.begin]].buttons) {
+                if (!button.exit)
+                    link(button.target);
+            }
+        }
+        else if (op == Op::JUMP) {
+            const uint32_t t = code.Target(last);
+            if (t != NO_TARGET)
+                link(t);
+        }
+        else if (op != Op::END) {
+            link(block.end);
+        }
+    }
+
+    if (!errors.empty()) {
+        errors.pop_back();
+        throw engine::error(errors);
+    }
+
+    // Reachability from the entry point.
+    if (!a.blocks.empty()) {
+        std::vector<uint32_t> stack{a.blockOf[a.entry]};
+        a.blocks[stack.back()].reachable = true;
+        while (!stack.empty()) {
+            const uint32_t b = stack.back();
+            stack.pop_back();
+            for (uint32_t succ : a.blocks[b].successors) {
+                if (!a.blocks[succ].reachable) {
+                    a.blocks[succ].reachable = true;
+                    stack.push_back(succ);
+                }
+            }
+        }
+    }
+
+    // Report each run of unreachable blocks once, unless all it holds is
+    // labels and ends (a trailing `end` after a jump, say).
+    for (size_t b = 0; b < a.blocks.size();) {
+        if (a.blocks[b].reachable) {
+            b++;
+            continue;
+        }
+        const size_t first = a.blocks[b].begin;
+        while (b < a.blocks.size() && !a.blocks[b].reachable)
+            b++;
+        const size_t last = a.blocks[b - 1].end - 1;
+        std::string_view label;
+        bool content = false;
+        for (size_t i = first; i <= last; ++i) {
+            const Op op = code.OpAt(i);
+            if (op == Op::LABEL && label.empty())
+                label = code.A(i);
+            content |= op != Op::LABEL && op != Op::END;
+        }
+        if (!content)
+            continue;
+        std::string warning = "instructions " + std::to_string(first) + "-" +
+                              std::to_string(last) + " are unreachable";
+        if (!label.empty())
+            warning += " (label '" + std::string(label) + "')";
+        a.warnings.push_back(std::move(warning));
+    }
+
+    // Asset reachability: a block reaches its own assets and those of its
+    // successors. Iterate to a fixpoint; in reverse order, forward flow
+    // settles in one pass and only loops need more.
+    a.reachWords = (a.assets.size() + 63) / 64;
+    a.reach.assign(a.blocks.size() * a.reachWords, 0);
+    if (a.reachWords > 0) {
+        for (size_t b = 0; b < a.blocks.size(); ++b) {
+            for (size_t i = a.blocks[b].begin; i < a.blocks[b].end; ++i) {
+                const int32_t asset = a.assetAt[i];
+                if (asset >= 0)
+                    a.reach[b * a.reachWords + asset / 64] |= uint64_t(1) << (asset % 64);
+            }
+        }
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (size_t b = a.blocks.size(); b-- > 0;) {
+                uint64_t *own = &a.reach[b * a.reachWords];
+                for (uint32_t succ : a.blocks[b].successors) {
+                    const uint64_t *other = &a.reach[succ * a.reachWords];
+                    for (size_t w = 0; w < a.reachWords; ++w) {
+                        const uint64_t merged = own[w] | other[w];
+                        changed |= merged != own[w];
+                        own[w] = merged;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+const MenuTable *ProgramAnalysis::MenuAt(size_t pc) const
+{
+    if (pc >= menuAt.size() || menuAt[pc] < 0)
+        return nullptr;
+    return &menus[menuAt[pc]];
+}
+
+std::vector<AssetUse> ProgramAnalysis::ReachableAssets(size_t pc) const
+{
+    std::vector<AssetUse> out;
+    if (pc >= blockOf.size() || reachWords == 0)
+        return out;
+
+    // What the rest of this block uses, plus what its successors reach.
+    const BasicBlock &block = blocks[blockOf[pc]];
+    std::vector<uint64_t> bits(reachWords, 0);
+    for (size_t i = pc; i < block.end; ++i) {
+        if (assetAt[i] >= 0)
+            bits[assetAt[i] / 64] |= uint64_t(1) << (assetAt[i] % 64);
+    }
+    for (uint32_t succ : block.successors) {
+        for (size_t w = 0; w < reachWords; ++w)
+            bits[w] |= reach[succ * reachWords + w];
+    }
+
+    for (size_t w = 0; w < reachWords; ++w) {
+        for (uint64_t word = bits[w]; word; word &= word - 1)
+            out.push_back(assets[w * 64 + size_t(std::countr_zero(word))]);
+    }
+    return out;
+}
+
+}  // namespace cereka::scenario
@@ -0,0 +1,144 @@
+#pragma once
+#include "bytecode.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cereka::scenario {
+
+struct MenuButton {
+    std::string_view text;
+    uint32_t target;  // where the button continues (the menu's end if it has no label)
+    bool exit;
+};
+
+/**
+ * A MENU instruction together with the BG and BUTTON lines after it.
+ */
+struct MenuTable {
+    uint32_t begin;  // the MENU instruction
+    uint32_t end;    // first instruction after the menu block
+    std::string_view background;  // last BG in the block, if any
+    std::vector<MenuButton> buttons;
+};
+
+/**
+ * Straight-line run of instructions [begin, end). A menu block is one block
+ * whose successors are its buttons' targets.
+ */
+struct BasicBlock {
+    uint32_t begin;
+    uint32_t end;
+    std::vector<uint32_t> successors;  // block indices
+    bool reachable = false;
+};
+
+/**
+ * An asset named by a BG, CHAR, BGM, SFX or VOICE instruction.
+ */
+struct AssetUse {
+    Op op;
+    std::string_view name;
+
+    bool operator==(const AssetUse &) const = default;
+};
+
+/**
+ * Load-time control-flow analysis of a program.
+ *
+ * Validates every JUMP and BUTTON target, duplicate labels and menus,
+ * precomputes the button table of every menu so entering one is a lookup,
+ * splits the program into basic blocks, flags blocks that cannot be
+ * reached from the entry point, and computes for every block the set of
+ * assets any path from it can still use.
+ */
+class ProgramAnalysis {
+   public:
+    /**
+     * Analyze `program`. Throws engine::error listing every problem that
+     * would break the script at run time; softer findings (unreachable code,
+     * stray buttons) end up in Warnings().
+     */
+    static std::shared_ptr<const ProgramAnalysis> Analyze(std::shared_ptr<const Bytecode> program);
+
+    /**
+     * Where execution starts: the first MENU, or 0 if there is none.
+     */
+    size_t EntryPoint() const
+    {
+        return entry;
+    }
+
+    /**
+     * The menu whose MENU instruction is at `pc`, or nullptr.
+     */
+    const MenuTable *MenuAt(size_t pc) const;
+
+    const std::vector<MenuTable> &Menus() const
+    {
+        return menus;
+    }
+
+    const std::vector<BasicBlock> &Blocks() const
+    {
+        return blocks;
+    }
+
+    /**
+     * Index of the block containing instruction `pc`.
+     */
+    size_t BlockOf(size_t pc) const
+    {
+        return blockOf[pc];
+    }
+
+    bool IsReachable(size_t pc) const
+    {
+        return pc < blockOf.size() && blocks[blockOf[pc]].reachable;
+    }
+
+    /**
+     * Every distinct asset the program uses.
+     */
+    const std::vector<AssetUse> &Assets() const
+    {
+        return assets;
+    }
+
+    /**
+     * Assets that can still be used once execution is at `pc`, on any path.
+     * For a menu's branches, ask for each button's target.
+     */
+    std::vector<AssetUse> ReachableAssets(size_t pc) const;
+
+    const std::vector<std::string> &Warnings() const
+    {
+        return warnings;
+    }
+
+    const Bytecode &Program() const
+    {
+        return *program;
+    }
+
+   private:
+    ProgramAnalysis() = default;
+
+    std::shared_ptr<const Bytecode> program;
+    size_t entry = 0;
+    std::vector<MenuTable> menus;
+    std::vector<int32_t> menuAt;  // per instruction: index into menus, or -1
+    std::vector<BasicBlock> blocks;
+    std::vector<uint32_t> blockOf;
+    std::vector<AssetUse> assets;
+    std::vector<int32_t> assetAt;  // per instruction: index into assets, or -1
+    // Per block, a bitset over `assets` of what is reachable from its start.
+    size_t reachWords = 0;
+    std::vector<uint64_t> reach;
+    std::vector<std::string> warnings;
+};
+
+}  // namespace cereka::scenario
@@ -0,0 +1,199 @@
+#include "project_compiler.hpp"
+#include "Cereka/exceptions.hpp"
+#include "bytecode.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "mapped_file.hpp"
+#include "script_parser.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace cereka::scenario {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bump when the parser emits different instructions for the same source.
+constexpr uint32_t PARSER_REVISION = 1;
+
+uint64_t UnitKey(const std::byte *data,
+                 size_t size)
+{
+    const uint32_t salt[2] = {BYTECODE_VERSION, PARSER_REVISION};
+    return hash::Fnv1a64(data, size, hash::Fnv1a64(salt, sizeof(salt)));
+}
+
+std::string CacheName(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.crkb", static_cast<unsigned long long>(key));
+    return name;
+}
+
+}  // namespace
+
+ProjectCompiler::ProjectCompiler(std::string cacheDir,
+                                 size_t threads)
+    : cacheDir(std::move(cacheDir)), pool(threads)
+{
+}
+
+ProjectCompiler::Unit ProjectCompiler::CompileUnit(const std::string &path) const
+{
+    CEREKA_TRACE_ZONE("CompileUnit");
+    Unit unit;
+
+    io::MappedFile file;
+    if (!file.Open(path)) {
+        unit.error = "could not open script '" + path + "'";
+        return unit;
+    }
+
+    const uint64_t key = UnitKey(file.Data(), file.Size());
+    const std::string cachePath =
+        cacheDir.empty() ? std::string() : cacheDir + "/" + CacheName(key);
+    if (!cachePath.empty() && fs::exists(cachePath)) {
+        try {
+            unit.program = DecodeBytecode(*Bytecode::Map(cachePath));
+            unit.cached = true;
+            return unit;
+        }
+        catch (const engine::error &e) {
+            CEREKA_LOG_WARN("ignoring unreadable script cache entry {}: {}", cachePath, e.what());
+        }
+    }
+
+    try {
+        const std::string_view text(reinterpret_cast<const char *>(file.Data()), file.Size());
+        unit.program = ParseVNScript(text, path);
+    }
+    catch (const CompileError &e) {
+        if (!fs::exists("compiler.lua")) {
+            unit.error = e.what();
+            return unit;
+        }
+        // Not cached: the result depends on compiler.lua as well.
+        CEREKA_LOG_WARN("{}; falling back to compiler.lua", e.what());
+        unit.program = CompileVNScript(path);
+        if (unit.program.empty())
+            unit.error = "compiler.lua failed on '" + path + "'";
+        return unit;
+    }
+
+    if (!cachePath.empty()) {
+        try {
+            fs::create_directories(cacheDir);
+            save::WriteFileAtomic(cachePath, SerializeBytecode(unit.program));
+        }
+        catch (const std::exception &e) {
+            CEREKA_LOG_WARN("could not cache compiled script {}: {}", path, e.what());
+        }
+    }
+    return unit;
+}
+
+std::vector<Instruction> ProjectCompiler::Compile(const std::vector<std::string> &files)
+{
+    CEREKA_TRACE_ZONE("CompileProject");
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<Unit> units(files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+        pool.Submit([this, &units, &files, i] { units[i] = CompileUnit(files[i]); });
+    pool.Wait();
+
+    stats = {};
+    stats.units = units.size();
+    std::string errors;
+    size_t total = 0;
+    for (const Unit &unit : units) {
+        if (!unit.error.empty())
+            errors += unit.error + "\n";
+        else if (unit.cached)
+            stats.cacheHits++;
+        else
+            stats.compiled++;
+        total += unit.program.size();
+    }
+
+    // Link: one label namespace across all files, in manifest order.
+    std::vector<Instruction> program;
+    program.reserve(total);
+    std::unordered_map<std::string, size_t> labelOwner;
+    for (size_t i = 0; i < units.size(); ++i) {
+        for (Instruction &ins : units[i].program) {
+            if (ins.op == Op::LABEL) {
+                auto [it, inserted] = labelOwner.emplace(ins.a, i);
+                if (!inserted)
+                    errors += files[i] + ": label '" + ins.a + "' is already defined in " +
+                              files[it->second] + "\n";
+            }
+            program.push_back(std::move(ins));
+        }
+    }
+
+    size_t unit = 0, unitEnd = units.empty() ? 0 : units[0].program.size();
+    auto check = [&](const std::string &label) {
+        if (!label.empty() && !labelOwner.count(label))
+            errors += files[unit] + ": unknown label '" + label + "'\n";
+    };
+    for (size_t i = 0; i < program.size(); ++i) {
+        while (i >= unitEnd)
+            unitEnd += units[++unit].program.size();
+        const Instruction &ins = program[i];
+        if (ins.op == Op::JUMP)
+            check(ins.a);
+        else if (ins.op == Op::BUTTON)
+            check(ins.b);
+        for (const ChoiceOption &c : ins.choices)
+            check(c.targetLabel);
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.buildNs =
+        uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    if (!errors.empty()) {
+        errors.pop_back();
+        throw engine::error(errors);
+    }
+
+    CEREKA_LOG_INFO("compiled {} script files ({} from cache) into {} instructions in {} ms",
+                    stats.units,
+                    stats.cacheHits,
+                    program.size(),
+                    stats.buildNs / 1000000);
+    return program;
+}
+
+std::vector<Instruction> ProjectCompiler::CompileManifest(const std::string &path)
+{
+    return Compile(ReadManifest(path));
+}
+
+std::vector<std::string> ReadManifest(const std::string &path)
+{
+    std::ifstream f(path);
+    if (!f)
+        throw engine::error("Could not open project manifest '%s'", path.c_str());
+
+    const fs::path base = fs::path(path).parent_path();
+    std::vector<std::string> files;
+    std::string line;
+    while (std::getline(f, line)) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        const size_t last = line.find_last_not_of(" \t\r");
+        files.push_back((base / line.substr(first, last - first + 1)).string());
+    }
+    return files;
+}
+
+}  // namespace cereka::scenario
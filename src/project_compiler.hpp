@@ -0,0 +1,78 @@
+#pragma once
+#include "thread_pool.hpp"
+#include "vn_instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cereka::scenario {
+
+struct ProjectStats {
+    size_t units = 0;
+    size_t cacheHits = 0;
+    size_t compiled = 0;
+    uint64_t buildNs = 0;  // wall time of the last Compile()
+};
+
+/**
+ * Builds a game split across many script files into one program.
+ *
+ * Files are compiled in parallel, one per job on a thread pool, and linked
+ * in the order given: their instructions are concatenated and all labels
+ * share one namespace, so `jump` and buttons may target a label in any
+ * file. Duplicate or unknown labels are link errors.
+ *
+ * Each compiled file is cached in `cacheDir` as a .crkb image named after
+ * a hash of its contents, so after editing one file a rebuild only
+ * compiles that one; the others are just hashed and mapped back in.
+ */
+class ProjectCompiler {
+   public:
+    /**
+     * An empty `cacheDir` disables the cache. `threads` as for ThreadPool.
+     */
+    explicit ProjectCompiler(std::string cacheDir = ".cereka-cache/scripts",
+                             size_t threads = 0);
+
+    ProjectCompiler(const ProjectCompiler &) = delete;
+    ProjectCompiler &operator=(const ProjectCompiler &) = delete;
+
+    /**
+     * Compile and link `files`. Throws engine::error listing every syntax
+     * error (as file:line:column) or link error found.
+     */
+    std::vector<Instruction> Compile(const std::vector<std::string> &files);
+
+    /**
+     * Compile the files listed in a manifest (see ReadManifest()).
+     */
+    std::vector<Instruction> CompileManifest(const std::string &path);
+
+    const ProjectStats &Stats() const
+    {
+        return stats;
+    }
+
+   private:
+    struct Unit {
+        std::vector<Instruction> program;
+        std::string error;
+        bool cached = false;
+    };
+
+    Unit CompileUnit(const std::string &path) const;
+
+    std::string cacheDir;
+    threading::ThreadPool pool;
+    ProjectStats stats;
+};
+
+/**
+ * Read a project manifest: one script path per line, relative to the
+ * manifest's directory. Blank lines and lines starting with `#` are
+ * skipped. Throws engine::error if it cannot be read.
+ */
+std::vector<std::string> ReadManifest(const std::string &path);
+
+}  // namespace cereka::scenario
@@ -0,0 +1,73 @@
+#include "read_history.hpp"
+#include "snapshot.hpp"
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace cereka::save {
+
+void ReadHistory::Reset(size_t instructions,
+                        uint64_t hash)
+{
+    programHash = hash;
+    bits = instructions;
+    words.assign((instructions + 63) / 64, 0);
+}
+
+size_t ReadHistory::Count() const
+{
+    size_t n = 0;
+    for (uint64_t w : words)
+        n += size_t(std::popcount(w));
+    return n;
+}
+
+void ReadHistory::SetWords(const std::vector<uint64_t> &marks)
+{
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] = i < marks.size() ? marks[i] : 0;
+    if (bits % 64 != 0 && !words.empty())
+        words.back() &= (uint64_t(1) << (bits % 64)) - 1;
+}
+
+bool ReadHistory::Load(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        return false;
+
+    ReadHistoryHeader header;
+    if (!f.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return false;
+    if (std::memcmp(header.magic, READ_HISTORY_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != READ_HISTORY_VERSION || header.programHash != programHash ||
+        header.bits != bits)
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> stored(words.size());
+    if (!f.read(reinterpret_cast<char *>(stored.data()),
+                std::streamsize(stored.size() * sizeof(uint64_t))))
+        return false;
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] |= stored[i];
+    return true;
+}
+
+void ReadHistory::Save(const std::string &path) const
+{
+    ReadHistoryHeader header{};
+    std::memcpy(header.magic, READ_HISTORY_MAGIC, sizeof(header.magic));
+    header.version = READ_HISTORY_VERSION;
+    header.programHash = programHash;
+    header.bits = bits;
+
+    std::vector<std::byte> out(sizeof(header) + words.size() * sizeof(uint64_t));
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (!words.empty())
+        std::memcpy(out.data() + sizeof(header), words.data(), words.size() * sizeof(uint64_t));
+    WriteFileAtomic(path, out);
+}
+
+}  // namespace cereka::save
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cereka::save {
+
+inline constexpr char READ_HISTORY_MAGIC[4] = {'C', 'R', 'K', 'R'};
+inline constexpr uint32_t READ_HISTORY_VERSION = 1;
+
+struct ReadHistoryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t programHash;
+    uint64_t bits;  // instruction count; followed by ceil(bits / 64) words
+};
+static_assert(sizeof(ReadHistoryHeader) == 24);
+
+/**
+ * One bit per instruction of a program, set once the line at that index has
+ * been shown. Instruction indices are only meaningful for one program image,
+ * so the history is tied to the image hash and discarded when it changes.
+ */
+class ReadHistory {
+   public:
+    /**
+     * Start an empty history for a program of `instructions` instructions.
+     */
+    void Reset(size_t instructions,
+               uint64_t programHash);
+
+    void Mark(size_t index)
+    {
+        if (index < bits)
+            words[index >> 6] |= uint64_t(1) << (index & 63);
+    }
+
+    bool Seen(size_t index) const
+    {
+        return index < bits && (words[index >> 6] >> (index & 63) & 1);
+    }
+
+    size_t Count() const;
+
+    const std::vector<uint64_t> &Words() const
+    {
+        return words;
+    }
+
+    /**
+     * Replace every mark with `marks`, as returned by Words() for the same
+     * program; words past the end of either are ignored or cleared.
+     */
+    void SetWords(const std::vector<uint64_t> &marks);
+
+    /**
+     * Merge the history stored at `path` into this one. Returns false, and
+     * leaves the history unchanged, if the file is missing, malformed or was
+     * written for a different program.
+     */
+    bool Load(const std::string &path);
+
+    /**
+     * Throws engine::error if the file cannot be written.
+     */
+    void Save(const std::string &path) const;
+
+   private:
+    uint64_t programHash = 0;
+    size_t bits = 0;
+    std::vector<uint64_t> words;
+};
+
+}  // namespace cereka::save
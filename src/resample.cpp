@@ -0,0 +1,294 @@
+#include "resample.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define CEREKA_RESAMPLE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+namespace cereka::render {
+
+namespace {
+
+constexpr double LANCZOS_SUPPORT = 3.0;
+
+double Sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= std::numbers::pi;
+    return std::sin(x) / x;
+}
+
+double Lanczos(double x)
+{
+    return std::abs(x) < LANCZOS_SUPPORT ? Sinc(x) * Sinc(x / LANCZOS_SUPPORT) : 0.0;
+}
+
+// Normalized filter taps for every output pixel along one axis.
+struct Kernel {
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<float> weights;  // `taps` per output pixel
+    int taps = 0;
+};
+
+Kernel MakeKernel(int in,
+                  int out)
+{
+    const double scale = double(in) / out;
+    const double filterScale = std::max(scale, 1.0);
+    const double support = LANCZOS_SUPPORT * filterScale;
+
+    Kernel k;
+    k.taps = int(std::ceil(support)) * 2 + 1;
+    k.start.resize(out);
+    k.count.resize(out);
+    k.weights.assign(size_t(out) * k.taps, 0.f);
+
+    std::vector<double> w(k.taps);
+    for (int i = 0; i < out; ++i) {
+        const double center = (i + 0.5) * scale;
+        const int lo = std::max(int(center - support + 0.5), 0);
+        const int hi = std::min(int(center + support + 0.5), in);
+        const int n = std::min(hi - lo, k.taps);
+        double total = 0.0;
+        for (int j = 0; j < n; ++j) {
+            w[j] = Lanczos((j + lo - center + 0.5) / filterScale);
+            total += w[j];
+        }
+        for (int j = 0; j < n; ++j)
+            k.weights[size_t(i) * k.taps + j] = float(total != 0.0 ? w[j] / total : 0.0);
+        k.start[i] = lo;
+        k.count[i] = n;
+    }
+    return k;
+}
+
+#ifdef CEREKA_RESAMPLE_SSE2
+
+struct Pixel {
+    __m128 v;
+};
+
+inline Pixel Zero()
+{
+    return {_mm_setzero_ps()};
+}
+
+inline Pixel Load(const uint8_t *p)
+{
+    int32_t v;
+    std::memcpy(&v, p, 4);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+    return {_mm_cvtepi32_ps(_mm_unpacklo_epi16(x, zero))};
+}
+
+inline Pixel MulAdd(Pixel acc,
+                    Pixel p,
+                    float w)
+{
+    return {_mm_add_ps(acc.v, _mm_mul_ps(p.v, _mm_set1_ps(w)))};
+}
+
+inline void Store(uint8_t *p,
+                  Pixel acc)
+{
+    // Round, then saturate the Lanczos overshoot to 0..255.
+    __m128i x = _mm_cvtps_epi32(acc.v);
+    x = _mm_packs_epi32(x, x);
+    x = _mm_packus_epi16(x, x);
+    const int32_t v = _mm_cvtsi128_si32(x);
+    std::memcpy(p, &v, 4);
+}
+
+#else
+
+struct Pixel {
+    float c[4];
+};
+
+inline Pixel Zero()
+{
+    return {};
+}
+
+inline Pixel Load(const uint8_t *p)
+{
+    return {{float(p[0]), float(p[1]), float(p[2]), float(p[3])}};
+}
+
+inline Pixel MulAdd(Pixel acc,
+                    Pixel p,
+                    float w)
+{
+    for (int i = 0; i < 4; ++i)
+        acc.c[i] += p.c[i] * w;
+    return acc;
+}
+
+inline void Store(uint8_t *p,
+                  Pixel acc)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = uint8_t(std::clamp(std::lrint(acc.c[i]), 0L, 255L));
+}
+
+#endif
+
+void ResampleRows(const uint8_t *src,
+                  int srcPitch,
+                  int srcWidth,
+                  int rows,
+                  uint8_t *dst,
+                  int dstPitch,
+                  const Kernel &k)
+{
+    const int out = int(k.start.size());
+    // Each source pixel feeds several taps; widen a row to floats once.
+    std::vector<Pixel> row(srcWidth);
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t *in = src + size_t(y) * srcPitch;
+        for (int x = 0; x < srcWidth; ++x)
+            row[x] = Load(in + x * 4);
+        uint8_t *o = dst + size_t(y) * dstPitch;
+        for (int x = 0; x < out; ++x) {
+            const float *w = &k.weights[size_t(x) * k.taps];
+            const Pixel *p = &row[k.start[x]];
+            // Two accumulators hide the latency of the dependent adds.
+            Pixel even = Zero(), odd = Zero();
+            int j = 0;
+            for (; j + 1 < k.count[x]; j += 2) {
+                even = MulAdd(even, p[j], w[j]);
+                odd = MulAdd(odd, p[j + 1], w[j + 1]);
+            }
+            if (j < k.count[x])
+                even = MulAdd(even, p[j], w[j]);
+            Store(o + x * 4, MulAdd(even, odd, 1.f));
+        }
+    }
+}
+
+void ResampleColumns(const uint8_t *src,
+                     int srcPitch,
+                     int width,
+                     uint8_t *dst,
+                     int dstPitch,
+                     const Kernel &k)
+{
+    const int out = int(k.start.size());
+    std::vector<Pixel> acc(width);
+    for (int y = 0; y < out; ++y) {
+        std::fill(acc.begin(), acc.end(), Zero());
+        const float *w = &k.weights[size_t(y) * k.taps];
+        // Whole source rows at a time, so reads stay sequential.
+        for (int j = 0; j < k.count[y]; ++j) {
+            const uint8_t *row = src + size_t(k.start[y] + j) * srcPitch;
+            for (int x = 0; x < width; ++x)
+                acc[x] = MulAdd(acc[x], Load(row + x * 4), w[j]);
+        }
+        uint8_t *o = dst + size_t(y) * dstPitch;
+        for (int x = 0; x < width; ++x)
+            Store(o + x * 4, acc[x]);
+    }
+}
+
+}  // namespace
+
+SDL_Surface *ResampleSurface(SDL_Surface *src,
+                             int width,
+                             int height)
+{
+    CEREKA_TRACE_ZONE("ResampleSurface");
+    if (!src || width <= 0 || height <= 0)
+        return nullptr;
+
+    SDL_Surface *converted = nullptr;
+    if (SDL_BYTESPERPIXEL(src->format) != 4 || SDL_ISPIXELFORMAT_FOURCC(src->format)) {
+        converted = SDL_ConvertSurface(src, SDL_PIXELFORMAT_ARGB8888);
+        if (!converted)
+            return nullptr;
+        src = converted;
+    }
+
+    SDL_Surface *dst = SDL_CreateSurface(width, height, src->format);
+    if (dst) {
+        // Horizontal pass first: it shrinks the rows the vertical pass reads.
+        std::vector<uint8_t> tmp(size_t(width) * 4 * src->h);
+        SDL_LockSurface(src);
+        ResampleRows(static_cast<const uint8_t *>(src->pixels),
+                     src->pitch,
+                     src->w,
+                     src->h,
+                     tmp.data(),
+                     width * 4,
+                     MakeKernel(src->w, width));
+        SDL_UnlockSurface(src);
+        ResampleColumns(tmp.data(),
+                        width * 4,
+                        width,
+                        static_cast<uint8_t *>(dst->pixels),
+                        dst->pitch,
+                        MakeKernel(src->h, height));
+
+        SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+        if (SDL_GetSurfaceBlendMode(src, &mode))
+            SDL_SetSurfaceBlendMode(dst, mode);
+    }
+
+    SDL_DestroySurface(converted);
+    return dst;
+}
+
+SDL_Point DrawSize(std::string_view asset,
+                   int w,
+                   int h,
+                   int screenWidth,
+                   int screenHeight)
+{
+    if (asset.starts_with("bg/"))
+        return {screenWidth, screenHeight};
+    if (asset.starts_with("characters/") && h > 0) {
+        const float scale = screenHeight * 0.8f / h;
+        return {int(std::lround(w * scale)), int(std::lround(h * scale))};
+    }
+    return {w, h};
+}
+
+SDL_Surface *PrescaleForDisplay(std::string_view asset,
+                                SDL_Surface *surface,
+                                int screenWidth,
+                                int screenHeight)
+{
+    if (!surface)
+        return nullptr;
+    const SDL_Point size = DrawSize(asset, surface->w, surface->h, screenWidth, screenHeight);
+    // Only ever shrink: enlarging costs VRAM and the GPU filters it as well.
+    if (size.x <= 0 || size.y <= 0 || size.x >= surface->w || size.y >= surface->h)
+        return surface;
+
+    // Filtering straight alpha bleeds the color of transparent pixels into
+    // the edges, so resample premultiplied.
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    SDL_GetSurfaceBlendMode(surface, &mode);
+    if (SDL_ISPIXELFORMAT_ALPHA(surface->format) && mode != SDL_BLENDMODE_BLEND_PREMULTIPLIED) {
+        if (!SDL_PremultiplySurfaceAlpha(surface, false))
+            return surface;
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+    }
+
+    SDL_Surface *scaled = ResampleSurface(surface, size.x, size.y);
+    if (!scaled)
+        return surface;
+    SDL_DestroySurface(surface);
+    return scaled;
+}
+
+}  // namespace cereka::render
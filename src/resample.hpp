@@ -0,0 +1,40 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <string_view>
+
+namespace cereka::render {
+
+/**
+ * Resample a surface with a Lanczos-3 filter widened by the scale factor,
+ * so that downscaling averages over every source pixel instead of skipping
+ * some as the GPU's bilinear minification does. Works on any 32-bit format,
+ * one channel per byte; others are converted to ARGB8888 first. Alpha
+ * should already be premultiplied. Returns a new surface, or nullptr.
+ */
+SDL_Surface *ResampleSurface(SDL_Surface *src,
+                             int width,
+                             int height);
+
+/**
+ * Size, in render pixels, at which Draw() puts an asset of w x h pixels on
+ * a screenWidth x screenHeight target: backgrounds ("bg/...") fill the
+ * screen and characters ("characters/...") are 80% of its height. Other
+ * assets are drawn at their own size.
+ */
+SDL_Point DrawSize(std::string_view asset,
+                   int w,
+                   int h,
+                   int screenWidth,
+                   int screenHeight);
+
+/**
+ * Downscale `surface` to its DrawSize() if that is smaller, premultiplying
+ * alpha first (the result then has SDL_BLENDMODE_BLEND_PREMULTIPLIED).
+ * Takes ownership of `surface` and returns it or its replacement.
+ */
+SDL_Surface *PrescaleForDisplay(std::string_view asset,
+                                SDL_Surface *surface,
+                                int screenWidth,
+                                int screenHeight);
+
+}  // namespace cereka::render
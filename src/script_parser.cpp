@@ -0,0 +1,299 @@
+#include "script_parser.hpp"
+#include "mapped_file.hpp"
+#include "trace.hpp"
+#include <cstring>
+
+namespace cereka::scenario {
+
+CompileError::CompileError(const std::string &source,
+                           int line,
+                           int column,
+                           const std::string &what)
+    : engine::Error(source + ":" + std::to_string(line) + ":" + std::to_string(column) + ": " +
+                    what),
+      source(source), line(line), column(column), reason(what)
+{
+}
+
+namespace {
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Ends a bare word.
+bool IsDelimiter(char c)
+{
+    return IsSpace(c) || c == '#' || c == '"';
+}
+
+class Parser {
+   public:
+    Parser(std::string_view text,
+           const std::string &name)
+        : name(name), p(text.data()), end(text.data() + text.size())
+    {
+    }
+
+    std::vector<Instruction> Run()
+    {
+        std::vector<Instruction> out;
+        // Most statements are a line of 20-60 bytes.
+        out.reserve(size_t(end - p) / 32 + 1);
+
+        while (p < end) {
+            const char *nl = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+            lineStart = p;
+            lineEnd = nl ? nl : end;
+            line++;
+            Statement(out);
+            p = nl ? nl + 1 : end;
+        }
+        return out;
+    }
+
+   private:
+    [[noreturn]] void Fail(const char *at,
+                           const std::string &what) const
+    {
+        throw CompileError(name, line, int(at - lineStart) + 1, what);
+    }
+
+    void SkipSpace()
+    {
+        while (p < lineEnd && IsSpace(*p))
+            p++;
+    }
+
+    bool AtLineEnd()
+    {
+        SkipSpace();
+        return p == lineEnd || *p == '#';
+    }
+
+    std::string_view Word()
+    {
+        SkipSpace();
+        const char *start = p;
+        while (p < lineEnd && !IsDelimiter(*p))
+            p++;
+        return {start, size_t(p - start)};
+    }
+
+    std::string_view ExpectWord(const char *what)
+    {
+        SkipSpace();
+        const char *at = p;
+        std::string_view w = Word();
+        if (w.empty())
+            Fail(at, std::string("expected ") + what);
+        return w;
+    }
+
+    std::string String()
+    {
+        SkipSpace();
+        if (p == lineEnd || *p != '"')
+            Fail(p, "expected a quoted string");
+        const char *open = p++;
+
+        // Common case: no escapes, so the text is one contiguous run.
+        const char *close = p;
+        while (close < lineEnd && *close != '"' && *close != '\\')
+            close++;
+        if (close < lineEnd && *close == '"') {
+            std::string s(p, size_t(close - p));
+            p = close + 1;
+            return s;
+        }
+
+        std::string s;
+        for (;;) {
+            // Copy the plain run up to the next quote or escape in one go.
+            const char *run = p;
+            while (p < lineEnd && *p != '"' && *p != '\\')
+                p++;
+            s.append(run, size_t(p - run));
+
+            if (p == lineEnd)
+                Fail(open, "unterminated string");
+            if (*p == '"') {
+                p++;
+                return s;
+            }
+
+            if (++p == lineEnd)
+                Fail(open, "unterminated string");
+            switch (*p) {
+                case 'n':
+                    s += '\n';
+                    break;
+                case 't':
+                    s += '\t';
+                    break;
+                case '"':
+                case '\\':
+                    s += *p;
+                    break;
+                default:
+                    Fail(p - 1, std::string("unknown escape '\\") + *p + "'");
+            }
+            p++;
+        }
+    }
+
+    // A speaker or character name: a bare word or a quoted string.
+    std::string Name(const char *what)
+    {
+        SkipSpace();
+        if (p < lineEnd && *p == '"')
+            return String();
+        return std::string(ExpectWord(what));
+    }
+
+    void ExpectLineEnd()
+    {
+        if (AtLineEnd())
+            return;
+        const char *at = p;
+        const std::string_view w = Word();
+        Fail(at, "unexpected '" + std::string(w.empty() ? std::string_view(at, 1) : w) + "'");
+    }
+
+    void Emit(std::vector<Instruction> &out,
+              Op op,
+              std::string a = {},
+              std::string b = {},
+              bool exit = false)
+    {
+        out.push_back({op, std::move(a), std::move(b), exit, {}});
+    }
+
+    void Statement(std::vector<Instruction> &out)
+    {
+        if (AtLineEnd())
+            return;
+
+        const char *at = p;
+        const bool menuBlock = inMenuBlock;
+        inMenuBlock = false;
+
+        // "Narration." / "Speaker": "Line."
+        if (*p == '"') {
+            std::string first = String();
+            SkipSpace();
+            if (p < lineEnd && *p == ':') {
+                p++;
+                Emit(out, Op::SAY, std::move(first), String());
+            }
+            else {
+                Emit(out, Op::NARRATE, {}, std::move(first));
+            }
+            ExpectLineEnd();
+            return;
+        }
+
+        const std::string_view keyword = Word();
+
+        // Speaker: "Line."
+        if (keyword.size() > 1 && keyword.back() == ':') {
+            Emit(out, Op::SAY, std::string(keyword.substr(0, keyword.size() - 1)), String());
+        }
+        else if (keyword == "label") {
+            Emit(out, Op::LABEL, std::string(ExpectWord("a label name")));
+        }
+        else if (keyword == "bg") {
+            Emit(out, Op::BG, std::string(ExpectWord("an image name")));
+            inMenuBlock = menuBlock;
+        }
+        else if (keyword == "char" || keyword == "show") {
+            std::string id = Name("a character id");
+            std::string expression = AtLineEnd() ? std::string() : std::string(Word());
+            Emit(out, Op::CHAR, std::move(id), std::move(expression));
+        }
+        else if (keyword == "hide") {
+            Emit(out, Op::HIDE, Name("a character id"));
+        }
+        else if (keyword == "bgm") {
+            Emit(out, Op::BGM, AtLineEnd() ? std::string() : std::string(Word()));
+        }
+        else if (keyword == "sfx") {
+            Emit(out, Op::SFX, std::string(ExpectWord("a sound name")));
+        }
+        else if (keyword == "voice") {
+            Emit(out, Op::VOICE, std::string(ExpectWord("a sound name")));
+        }
+        else if (keyword == "say") {
+            std::string speaker = Name("a speaker");
+            Emit(out, Op::SAY, std::move(speaker), String());
+        }
+        else if (keyword == "narrate") {
+            Emit(out, Op::NARRATE, {}, String());
+        }
+        else if (keyword == "jump") {
+            Emit(out, Op::JUMP, std::string(ExpectWord("a label name")));
+        }
+        else if (keyword == "menu") {
+            Emit(out, Op::MENU);
+            inMenuBlock = true;
+        }
+        else if (keyword == "button") {
+            if (!menuBlock)
+                Fail(at, "'button' outside a menu block");
+            std::string text = String();
+            std::string target;
+            bool exit = false;
+            while (!AtLineEnd()) {
+                const char *opt = p;
+                const std::string_view w = Word();
+                if (w == "->" && target.empty())
+                    target = ExpectWord("a label name");
+                else if (w == "exit" && !exit)
+                    exit = true;
+                else
+                    Fail(opt, "expected '-> label' or 'exit'");
+            }
+            Emit(out, Op::BUTTON, std::move(text), std::move(target), exit);
+            inMenuBlock = true;
+        }
+        else if (keyword == "end") {
+            Emit(out, Op::END);
+        }
+        else {
+            Fail(at, "unknown statement '" + std::string(keyword) + "'");
+        }
+
+        ExpectLineEnd();
+    }
+
+    const std::string &name;
+    const char *p;
+    const char *end;
+    const char *lineStart = nullptr;
+    const char *lineEnd = nullptr;
+    int line = 0;
+    bool inMenuBlock = false;
+};
+
+}  // namespace
+
+std::vector<Instruction> ParseVNScript(std::string_view text,
+                                       const std::string &name)
+{
+    CEREKA_TRACE_ZONE("ParseVNScript");
+    // A UTF-8 byte order mark is not part of the first statement.
+    if (text.size() >= 3 && std::memcmp(text.data(), "\xEF\xBB\xBF", 3) == 0)
+        text.remove_prefix(3);
+    return Parser(text, name).Run();
+}
+
+std::vector<Instruction> ParseVNScriptFile(const std::string &path)
+{
+    io::MappedFile file;
+    if (!file.Open(path))
+        throw engine::error("Could not open script '%s'", path.c_str());
+    return ParseVNScript({reinterpret_cast<const char *>(file.Data()), file.Size()}, path);
+}
+
+}  // namespace cereka::scenario
@@ -0,0 +1,66 @@
+#pragma once
+#include "Cereka/exceptions.hpp"
+#include "vn_instruction.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Native compiler for the VN script format.
+ *
+ * One statement per line; indentation is free and `#` starts a comment.
+ * Text is double-quoted with \" \\ \n and \t escapes; names and paths are
+ * bare words.
+ *
+ *   label start
+ *   bg street.png
+ *   char alice happy             # or: show alice happy
+ *   hide alice
+ *   bgm rain.ogg                 # loops until the next bgm; bare `bgm` stops
+ *   sfx door.wav
+ *   voice alice_001.ogg          # voices the next line
+ *   Alice: "Good morning."       # or: say Alice "Good morning."
+ *   "Mysterious man": "Hm."      # quoted speakers may contain spaces
+ *   "The street is quiet."       # or: narrate "..."
+ *   menu
+ *     bg crossroads.png
+ *     button "Go left" -> left
+ *     button "Quit" exit
+ *   jump start
+ *   end
+ *
+ * A menu block is the run of `bg` and `button` lines right after `menu`.
+ */
+
+namespace cereka::scenario {
+
+/**
+ * Syntax error at a 1-based line and byte column of the source.
+ */
+class CompileError : public engine::Error {
+   public:
+    CompileError(const std::string &source,
+                 int line,
+                 int column,
+                 const std::string &what);
+
+    std::string source;
+    int line;
+    int column;
+    std::string reason;
+};
+
+/**
+ * Compile script text. `name` is used in error messages.
+ * Throws CompileError.
+ */
+std::vector<Instruction> ParseVNScript(std::string_view text,
+                                       const std::string &name = "<script>");
+
+/**
+ * Compile a script file, reading it through a memory mapping. Throws
+ * CompileError, or engine::error if the file cannot be opened.
+ */
+std::vector<Instruction> ParseVNScriptFile(const std::string &path);
+
+}  // namespace cereka::scenario
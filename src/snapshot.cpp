@@ -0,0 +1,320 @@
+#include "snapshot.hpp"
+#include "Cereka/exceptions.hpp"
+#include "log.hpp"
+#include "lz.hpp"
+#include "trace.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+
+namespace cereka::save {
+
+namespace {
+
+// Payloads below this size are stored as-is; compressing them is not worth
+// the header overhead.
+constexpr size_t COMPRESS_THRESHOLD = 64;
+
+class Writer {
+   public:
+    explicit Writer(std::vector<std::byte> &out) : out(out) {}
+
+    template<typename T>
+    void Put(T v)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto *p = reinterpret_cast<const std::byte *>(&v);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    void PutString(const std::string &s)
+    {
+        Put(uint32_t(s.size()));
+        const auto *p = reinterpret_cast<const std::byte *>(s.data());
+        out.insert(out.end(), p, p + s.size());
+    }
+
+   private:
+    std::vector<std::byte> &out;
+};
+
+class Reader {
+   public:
+    Reader(const std::byte *data,
+           size_t size)
+        : data(data), size(size)
+    {
+    }
+
+    template<typename T>
+    T Get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Need(sizeof(T));
+        T v;
+        std::memcpy(&v, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+
+    std::string GetString()
+    {
+        const uint32_t n = Get<uint32_t>();
+        Need(n);
+        std::string s(reinterpret_cast<const char *>(data + pos), n);
+        pos += n;
+        return s;
+    }
+
+    // Element count of a following array; bounded by the bytes left so a
+    // corrupt count cannot trigger a huge allocation.
+    uint32_t GetCount()
+    {
+        const uint32_t n = Get<uint32_t>();
+        if (n > size - pos)
+            throw engine::error("Snapshot corrupt: bad element count %u", n);
+        return n;
+    }
+
+    bool AtEnd() const
+    {
+        return pos == size;
+    }
+
+   private:
+    void Need(size_t n) const
+    {
+        if (n > size - pos)
+            throw engine::error("Snapshot truncated");
+    }
+
+    const std::byte *data;
+    size_t size;
+    size_t pos = 0;
+};
+
+}  // namespace
+
+void Serialize(const Snapshot &s,
+               std::vector<std::byte> &out)
+{
+    out.clear();
+    Writer w(out);
+    w.Put(s.programHash);
+    w.Put(s.pc);
+    w.Put(s.menuEndPC);
+    w.Put(s.state);
+    w.Put(uint8_t(s.scriptFinished));
+    w.Put(uint8_t(s.inMenu));
+
+    w.PutString(s.speaker);
+    w.PutString(s.name);
+    w.PutString(s.text);
+    w.Put(s.dialoguePage);
+    w.Put(s.revealed);
+
+    w.PutString(s.background);
+    w.Put(uint32_t(s.characters.size()));
+    for (const auto &id : s.characters)
+        w.PutString(id);
+    w.PutString(s.music);
+
+    w.Put(uint32_t(s.buttons.size()));
+    for (const auto &b : s.buttons) {
+        w.PutString(b.text);
+        w.Put(b.target);
+        w.Put(uint8_t(b.exit));
+    }
+}
+
+Snapshot Deserialize(const std::byte *data,
+                     size_t size)
+{
+    Reader r(data, size);
+    Snapshot s;
+    s.programHash = r.Get<uint64_t>();
+    s.pc = r.Get<uint32_t>();
+    s.menuEndPC = r.Get<uint32_t>();
+    s.state = r.Get<uint8_t>();
+    s.scriptFinished = r.Get<uint8_t>() != 0;
+    s.inMenu = r.Get<uint8_t>() != 0;
+
+    s.speaker = r.GetString();
+    s.name = r.GetString();
+    s.text = r.GetString();
+    s.dialoguePage = r.Get<uint32_t>();
+    s.revealed = r.Get<uint32_t>();
+
+    s.background = r.GetString();
+    s.characters.resize(r.GetCount());
+    for (auto &id : s.characters)
+        id = r.GetString();
+    s.music = r.GetString();
+
+    s.buttons.resize(r.GetCount());
+    for (auto &b : s.buttons) {
+        b.text = r.GetString();
+        b.target = r.Get<uint32_t>();
+        b.exit = r.Get<uint8_t>() != 0;
+    }
+
+    if (!r.AtEnd())
+        throw engine::error("Snapshot has trailing bytes");
+    return s;
+}
+
+std::vector<std::byte> Pack(const std::byte *raw,
+                            size_t size,
+                            bool compress)
+{
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.rawSize = uint32_t(size);
+
+    std::vector<std::byte> payload;
+    if (compress && size >= COMPRESS_THRESHOLD) {
+        payload = io::Compress(raw, size);
+        if (payload.size() < size)
+            header.flags |= SNAPSHOT_COMPRESSED;
+    }
+    if (!(header.flags & SNAPSHOT_COMPRESSED))
+        payload.assign(raw, raw + size);
+    header.payloadSize = uint32_t(payload.size());
+
+    std::vector<std::byte> out(sizeof(header) + payload.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (!payload.empty())
+        std::memcpy(out.data() + sizeof(header), payload.data(), payload.size());
+    return out;
+}
+
+std::vector<std::byte> Unpack(const std::byte *file,
+                              size_t size)
+{
+    SnapshotHeader header;
+    if (size < sizeof(header))
+        throw engine::error("Snapshot too small");
+    std::memcpy(&header, file, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+        throw engine::error("Not a snapshot file");
+    if (header.version != SNAPSHOT_VERSION)
+        throw engine::error("Unsupported snapshot version %u (expected %u)",
+                            unsigned(header.version),
+                            unsigned(SNAPSHOT_VERSION));
+    if (header.payloadSize != size - sizeof(header))
+        throw engine::error("Snapshot payload size mismatch");
+
+    const std::byte *payload = file + sizeof(header);
+    const bool compressed = header.flags & SNAPSHOT_COMPRESSED;
+    const size_t maxRaw = compressed ? io::MaxDecompressedSize(header.payloadSize) :
+                                       header.payloadSize;
+    if (header.rawSize > maxRaw)
+        throw engine::error("Snapshot payload size mismatch");
+    std::vector<std::byte> raw(header.rawSize);
+    if (compressed) {
+        io::Decompress(payload, header.payloadSize, raw.data(), raw.size());
+    }
+    else {
+        if (header.payloadSize != header.rawSize)
+            throw engine::error("Snapshot payload size mismatch");
+        if (!raw.empty())
+            std::memcpy(raw.data(), payload, raw.size());
+    }
+    return raw;
+}
+
+void WriteFileAtomic(const std::string &path,
+                     const std::vector<std::byte> &data)
+{
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f)
+            throw engine::error("Could not open '%s' for writing", tmp.c_str());
+        f.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+        if (!f)
+            throw engine::error("Failed to write '%s'", tmp.c_str());
+    }
+    // std::rename does not replace an existing file on Windows.
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        throw engine::error("Could not rename '%s' to '%s'", tmp.c_str(), path.c_str());
+}
+
+void WriteSnapshot(const std::string &path,
+                   const Snapshot &snapshot)
+{
+    std::vector<std::byte> raw;
+    Serialize(snapshot, raw);
+    WriteFileAtomic(path, Pack(raw.data(), raw.size(), true));
+}
+
+Snapshot ReadSnapshot(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        throw engine::error("Could not open save '%s'", path.c_str());
+    std::vector<char> file((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    const std::vector<std::byte> raw =
+        Unpack(reinterpret_cast<const std::byte *>(file.data()), file.size());
+    return Deserialize(raw.data(), raw.size());
+}
+
+Autosaver::Autosaver() : pool(1) {}
+
+Autosaver::~Autosaver()
+{
+    Wait();
+}
+
+void Autosaver::Save(std::string path,
+                     std::vector<std::byte> raw)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingPath = std::move(path);
+    pending = std::move(raw);
+    hasPending = true;
+    if (scheduled)
+        return;  // the queued job will pick up the newest state
+    scheduled = true;
+    pool.Submit([this] { WritePending(); });
+}
+
+void Autosaver::Wait()
+{
+    pool.Wait();
+}
+
+void Autosaver::WritePending()
+{
+    for (;;) {
+        std::string path;
+        std::vector<std::byte> raw;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!hasPending) {
+                scheduled = false;
+                return;
+            }
+            path = std::move(pendingPath);
+            raw = std::move(pending);
+            hasPending = false;
+        }
+
+        CEREKA_TRACE_ZONE("Autosave");
+        try {
+            WriteFileAtomic(path, Pack(raw.data(), raw.size(), true));
+            written.fetch_add(1, std::memory_order_relaxed);
+        }
+        catch (const engine::error &e) {
+            CEREKA_LOG_ERROR("autosave failed: {}", e.what());
+        }
+    }
+}
+
+}  // namespace cereka::save
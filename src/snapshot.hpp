@@ -0,0 +1,136 @@
+#pragma once
+#include "thread_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cereka::save {
+
+inline constexpr char SNAPSHOT_MAGIC[4] = {'C', 'R', 'K', 'S'};
+inline constexpr uint16_t SNAPSHOT_VERSION = 2;
+
+enum SnapshotFlags : uint16_t {
+    SNAPSHOT_COMPRESSED = 1 << 0,
+};
+
+/**
+ * File header; the payload follows immediately. All fields little-endian.
+ */
+struct SnapshotHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t rawSize;      // size of the serialized state
+    uint32_t payloadSize;  // bytes after the header (== rawSize if uncompressed)
+};
+static_assert(sizeof(SnapshotHeader) == 16);
+
+struct ButtonState {
+    std::string text;
+    uint32_t target = 0;
+    bool exit = false;
+};
+
+/**
+ * Everything needed to put a session back where it was. Assets are referred
+ * to by script id, so a snapshot stays valid when images change on disk.
+ */
+struct Snapshot {
+    uint64_t programHash = 0;  // hash::Fnv1a64 of the program image
+    uint32_t pc = 0;
+    uint32_t menuEndPC = 0;
+    uint8_t state = 0;  // CerekaState
+    bool scriptFinished = false;
+
+    std::string speaker;
+    std::string name;
+    std::string text;
+    uint32_t dialoguePage = 0;
+    uint32_t revealed = 0;
+
+    std::string background;
+    std::vector<std::string> characters;
+    std::string music;
+
+    bool inMenu = false;
+    std::vector<ButtonState> buttons;
+};
+
+/**
+ * Encode `snapshot` into `out` (cleared first). Reusing `out` across calls
+ * avoids allocating once it has grown to size.
+ */
+void Serialize(const Snapshot &snapshot,
+               std::vector<std::byte> &out);
+
+/**
+ * Decode the output of Serialize(). Throws engine::error on truncated or
+ * malformed input.
+ */
+Snapshot Deserialize(const std::byte *data,
+                     size_t size);
+
+/**
+ * Wrap serialized state in a file image (header + optionally compressed
+ * payload), and the reverse. Unpack throws engine::error on bad input.
+ */
+std::vector<std::byte> Pack(const std::byte *raw,
+                            size_t size,
+                            bool compress);
+std::vector<std::byte> Unpack(const std::byte *file,
+                              size_t size);
+
+/**
+ * Write `data` to `path` through a temporary file and a rename, so a crash
+ * mid-write never leaves a truncated save behind. Throws engine::error.
+ */
+void WriteFileAtomic(const std::string &path,
+                     const std::vector<std::byte> &data);
+
+void WriteSnapshot(const std::string &path,
+                   const Snapshot &snapshot);
+Snapshot ReadSnapshot(const std::string &path);
+
+/**
+ * Background autosave. The caller serializes on its own thread (cheap) and
+ * hands the bytes over; compression and file I/O happen on a worker. If
+ * saves arrive faster than they can be written, intermediate ones are
+ * skipped and only the newest is written.
+ */
+class Autosaver {
+   public:
+    Autosaver();
+    ~Autosaver();
+
+    Autosaver(const Autosaver &) = delete;
+    Autosaver &operator=(const Autosaver &) = delete;
+
+    void Save(std::string path,
+              std::vector<std::byte> raw);
+
+    /**
+     * Block until every pending save has been written.
+     */
+    void Wait();
+
+    uint64_t Written() const
+    {
+        return written.load(std::memory_order_relaxed);
+    }
+
+   private:
+    void WritePending();
+
+    std::mutex mutex;
+    std::string pendingPath;
+    std::vector<std::byte> pending;
+    bool hasPending = false;
+    bool scheduled = false;
+    std::atomic<uint64_t> written{0};
+    threading::ThreadPool pool;
+};
+
+}  // namespace cereka::save
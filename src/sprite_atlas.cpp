@@ -0,0 +1,97 @@
+#include "sprite_atlas.hpp"
+#include "log.hpp"
+
+namespace cereka::render {
+
+namespace {
+
+constexpr int WHITE_SIZE = 4;
+
+}  // namespace
+
+SpriteAtlas::SpriteAtlas(SDL_Renderer *renderer,
+                         int pageSize)
+    : renderer(renderer), pageSize(pageSize)
+{
+    if (!AddPage())
+        return;
+
+    SDL_Rect slot;
+    if (!pages.back().packer.Pack(WHITE_SIZE, WHITE_SIZE, slot))
+        return;
+    std::vector<Uint32> pixels(WHITE_SIZE * WHITE_SIZE, 0xffffffffu);
+    SDL_UpdateTexture(
+        pages.back().texture, &slot, pixels.data(), WHITE_SIZE * int(sizeof(Uint32)));
+    uploads++;
+
+    // Sample the middle of the block so linear filtering never reaches the
+    // transparent padding around it.
+    const float inv = 1.0f / pageSize;
+    white.texture = pages.back().texture;
+    white.uv = {(slot.x + WHITE_SIZE * 0.5f) * inv, (slot.y + WHITE_SIZE * 0.5f) * inv, 0.f, 0.f};
+    white.width = 1.f;
+    white.height = 1.f;
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+    for (auto &page : pages) {
+        if (page.texture)
+            SDL_DestroyTexture(page.texture);
+    }
+}
+
+bool SpriteAtlas::AddPage()
+{
+    SDL_Texture *tex = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, pageSize, pageSize);
+    if (!tex) {
+        CEREKA_LOG_ERROR("failed to create atlas page: {}", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+
+    // Static textures start with undefined contents; clear so that filtering
+    // at sprite edges samples transparent texels.
+    std::vector<Uint32> zero(size_t(pageSize) * pageSize, 0);
+    SDL_UpdateTexture(tex, nullptr, zero.data(), pageSize * int(sizeof(Uint32)));
+
+    pages.push_back({tex, ShelfPacker(pageSize, pageSize)});
+    return true;
+}
+
+Sprite SpriteAtlas::Insert(SDL_Surface *surface)
+{
+    if (!surface)
+        return {};
+
+    SDL_Surface *converted = nullptr;
+    if (surface->format != SDL_PIXELFORMAT_ARGB8888) {
+        converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+        if (!converted)
+            return {};
+        surface = converted;
+    }
+
+    SDL_Rect slot;
+    bool packed = !pages.empty() && pages.back().packer.Pack(surface->w, surface->h, slot);
+    if (!packed && surface->w <= pageSize && surface->h <= pageSize && AddPage())
+        packed = pages.back().packer.Pack(surface->w, surface->h, slot);
+
+    Sprite sprite;
+    if (packed) {
+        SDL_UpdateTexture(pages.back().texture, &slot, surface->pixels, surface->pitch);
+        uploads++;
+        const float inv = 1.0f / pageSize;
+        sprite.texture = pages.back().texture;
+        sprite.uv = {slot.x * inv, slot.y * inv, slot.w * inv, slot.h * inv};
+        sprite.width = float(slot.w);
+        sprite.height = float(slot.h);
+    }
+
+    if (converted)
+        SDL_DestroySurface(converted);
+    return sprite;
+}
+
+}  // namespace cereka::render
@@ -0,0 +1,79 @@
+#pragma once
+#include "atlas_packer.hpp"
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+
+namespace cereka::render {
+
+/**
+ * A rectangle of some texture, with normalized texture coordinates.
+ */
+struct Sprite {
+    SDL_Texture *texture = nullptr;
+    SDL_FRect uv{0.f, 0.f, 1.f, 1.f};
+    float width = 0.f;
+    float height = 0.f;
+
+    explicit operator bool() const
+    {
+        return texture != nullptr;
+    }
+};
+
+/**
+ * Pages of small images (glyphs, UI pieces) packed into shared textures so
+ * that they can be drawn together without texture switches.
+ *
+ * The first page also holds a small opaque white block; drawing White() with
+ * a vertex color gives a solid rectangle from the same texture as the text.
+ */
+class SpriteAtlas {
+   public:
+    SpriteAtlas(SDL_Renderer *renderer,
+                int pageSize = 1024);
+    ~SpriteAtlas();
+
+    SpriteAtlas(const SpriteAtlas &) = delete;
+    SpriteAtlas &operator=(const SpriteAtlas &) = delete;
+
+    /**
+     * Copy a surface into the atlas. Returns an empty sprite if it is larger
+     * than a page or a new page cannot be created.
+     */
+    Sprite Insert(SDL_Surface *surface);
+
+    /**
+     * A single white texel, for solid-colour quads.
+     */
+    const Sprite &White() const
+    {
+        return white;
+    }
+
+    size_t PageCount() const
+    {
+        return pages.size();
+    }
+
+    uint64_t Uploads() const
+    {
+        return uploads;
+    }
+
+   private:
+    struct Page {
+        SDL_Texture *texture = nullptr;
+        ShelfPacker packer;
+    };
+
+    bool AddPage();
+
+    SDL_Renderer *renderer;
+    int pageSize;
+    std::vector<Page> pages;
+    Sprite white;
+    uint64_t uploads = 0;
+};
+
+}  // namespace cereka::render
@@ -0,0 +1,108 @@
+#include "sprite_batch.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace cereka::render {
+
+SpriteBatch::SpriteBatch(SDL_Renderer *renderer) : renderer(renderer) {}
+
+void SpriteBatch::Draw(SDL_Texture *texture,
+                       const SDL_FRect &uv,
+                       const SDL_FRect &dst,
+                       SDL_FColor color,
+                       int layer)
+{
+    const uint32_t base = uint32_t(vertices.size());
+    const float x1 = dst.x + dst.w;
+    const float y1 = dst.y + dst.h;
+    const float u1 = uv.x + uv.w;
+    const float v1 = uv.y + uv.h;
+
+    vertices.push_back({{dst.x, dst.y}, color, {uv.x, uv.y}});
+    vertices.push_back({{x1, dst.y}, color, {u1, uv.y}});
+    vertices.push_back({{x1, y1}, color, {u1, v1}});
+    vertices.push_back({{dst.x, y1}, color, {uv.x, v1}});
+
+    const uint32_t first = uint32_t(indices.size());
+    for (int i : {0, 1, 2, 0, 2, 3})
+        indices.push_back(i);
+
+    items.push_back({layer, texture, uint32_t(items.size()), base, 4, first, 6});
+    stats.quads++;
+}
+
+void SpriteBatch::DrawGeometry(SDL_Texture *texture,
+                               const SDL_Vertex *v,
+                               int vertexCount,
+                               const int *idx,
+                               int indexCount,
+                               int layer)
+{
+    if (vertexCount <= 0 || indexCount <= 0)
+        return;
+
+    const uint32_t base = uint32_t(vertices.size());
+    const uint32_t first = uint32_t(indices.size());
+    vertices.insert(vertices.end(), v, v + vertexCount);
+    indices.insert(indices.end(), idx, idx + indexCount);
+    items.push_back({layer,
+                     texture,
+                     uint32_t(items.size()),
+                     base,
+                     uint32_t(vertexCount),
+                     first,
+                     uint32_t(indexCount)});
+    stats.quads += uint64_t(indexCount) / 6;
+}
+
+void SpriteBatch::Flush()
+{
+    CEREKA_TRACE_ZONE("SpriteBatch.Flush");
+    if (items.empty())
+        return;
+
+    std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+        if (a.layer != b.layer)
+            return a.layer < b.layer;
+        if (a.texture != b.texture)
+            return std::less<SDL_Texture *>()(a.texture, b.texture);
+        return a.sequence < b.sequence;
+    });
+
+    // Each run of consecutive items with one texture becomes a single call;
+    // a run may continue into the next layer if that starts with the same
+    // texture.
+    size_t i = 0;
+    while (i < items.size()) {
+        SDL_Texture *texture = items[i].texture;
+        outVertices.clear();
+        outIndices.clear();
+        for (; i < items.size() && items[i].texture == texture; ++i) {
+            const Item &item = items[i];
+            const int rebase = int(outVertices.size());
+            outVertices.insert(outVertices.end(),
+                               vertices.begin() + item.firstVertex,
+                               vertices.begin() + item.firstVertex + item.vertexCount);
+            for (uint32_t k = 0; k < item.indexCount; ++k)
+                outIndices.push_back(indices[item.firstIndex + k] + rebase);
+        }
+
+        SDL_RenderGeometry(renderer,
+                           texture,
+                           outVertices.data(),
+                           int(outVertices.size()),
+                           outIndices.data(),
+                           int(outIndices.size()));
+        stats.drawCalls++;
+        if (!bound || texture != boundTexture)
+            stats.textureSwitches++;
+        boundTexture = texture;
+        bound = true;
+    }
+
+    items.clear();
+    vertices.clear();
+    indices.clear();
+}
+
+}  // namespace cereka::render
@@ -0,0 +1,119 @@
+#pragma once
+#include "sprite_atlas.hpp"
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+
+namespace cereka::render {
+
+/**
+ * Draw order of the scene. Lower layers are drawn first.
+ */
+enum Layer : int {
+    LAYER_BACKGROUND = 0,
+    LAYER_CHARACTERS = 100,  // + slot, so overlapping characters keep their order
+    // Boxes and the text on them are separate layers: within a layer quads
+    // are grouped by texture, which could put a box over its text.
+    LAYER_UI = 1000,  // menu buttons
+    LAYER_UI_TEXT = 1001,
+    LAYER_DIALOGUE = 1002,  // dialogue and name boxes, over the menu
+    LAYER_DIALOGUE_TEXT = 1003,
+};
+
+struct BatchStats {
+    uint64_t drawCalls = 0;        // SDL_RenderGeometry calls
+    uint64_t textureSwitches = 0;  // calls binding a different texture than the one before
+    uint64_t quads = 0;
+};
+
+/**
+ * Collects the quads of a frame and submits them with as few
+ * SDL_RenderGeometry calls as possible.
+ *
+ * Submissions are sorted by (layer, texture) in Flush(), keeping submission
+ * order within a texture, and every run of one texture becomes a single call.
+ * Quads in the same layer may therefore be reordered relative to quads of a
+ * *different* texture; use separate layers when that matters.
+ */
+class SpriteBatch {
+   public:
+    explicit SpriteBatch(SDL_Renderer *renderer);
+
+    /**
+     * Queue a quad covering `dst` textured with `uv` of `texture`.
+     */
+    void Draw(SDL_Texture *texture,
+              const SDL_FRect &uv,
+              const SDL_FRect &dst,
+              SDL_FColor color,
+              int layer);
+
+    void Draw(const Sprite &sprite,
+              const SDL_FRect &dst,
+              SDL_FColor color,
+              int layer)
+    {
+        Draw(sprite.texture, sprite.uv, dst, color, layer);
+    }
+
+    /**
+     * Queue a whole texture stretched over `dst`.
+     */
+    void DrawTexture(SDL_Texture *texture,
+                     const SDL_FRect &dst,
+                     int layer)
+    {
+        Draw(texture, {0.f, 0.f, 1.f, 1.f}, dst, {1.f, 1.f, 1.f, 1.f}, layer);
+    }
+
+    /**
+     * Queue prebuilt triangles (e.g. a retained text mesh). Indices are
+     * relative to `vertices`.
+     */
+    void DrawGeometry(SDL_Texture *texture,
+                      const SDL_Vertex *vertices,
+                      int vertexCount,
+                      const int *indices,
+                      int indexCount,
+                      int layer);
+
+    /**
+     * Sort and submit everything queued since the last Flush().
+     */
+    void Flush();
+
+    /**
+     * Counters since construction; diff two snapshots for per-frame values.
+     */
+    const BatchStats &Stats() const
+    {
+        return stats;
+    }
+
+   private:
+    struct Item {
+        int layer;
+        SDL_Texture *texture;
+        uint32_t sequence;
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    SDL_Renderer *renderer;
+    std::vector<Item> items;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    // Sorted, rebased geometry; kept to reuse the allocations.
+    std::vector<SDL_Vertex> outVertices;
+    std::vector<int> outIndices;
+
+    // Texture of the last call, which may carry over between flushes.
+    SDL_Texture *boundTexture = nullptr;
+    bool bound = false;
+    BatchStats stats;
+};
+
+}  // namespace cereka::render
@@ -1,9 +1,11 @@
+#include "text_renderer.hpp"
 #include "Cereka/exceptions.hpp"
+#include "log.hpp"
+#include "trace.hpp"
 #include "SDL3/SDL_error.h"
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include <cassert>
-#include <iostream>
 
 namespace cereka::text_renderer {
 
@@ -19,9 +21,277 @@ TTF_Font *OpenFont(const std::string &fontPath,
 {
     TTF_Font *font = TTF_OpenFont(fontPath.c_str(), fontSize);
     if (!font) {
-        std::cerr << "Failed to open font '" << fontPath << "': " << SDL_GetError() << std::endl;
+        CEREKA_LOG_ERROR("failed to open font '{}': {}", fontPath, SDL_GetError());
     }
     return font;
 }
 
+TTF_Font *OpenFont(SDL_IOStream *io,
+                   const std::string &name,
+                   int fontSize)
+{
+    TTF_Font *font = io ? TTF_OpenFontIO(io, true, fontSize) : nullptr;
+    if (!font) {
+        CEREKA_LOG_ERROR("failed to open font '{}': {}", name, SDL_GetError());
+    }
+    return font;
+}
+
+GlyphAtlas::GlyphAtlas(render::SpriteAtlas &atlas,
+                       TTF_Font *font)
+    : atlas(atlas), font(font)
+{
+}
+
+Glyph GlyphAtlas::Rasterize(Uint32 codepoint)
+{
+    CEREKA_TRACE_ZONE("RenderText");
+    Glyph glyph;
+    int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+    if (TTF_GetGlyphMetrics(font, codepoint, &minx, &maxx, &miny, &maxy, &advance))
+        glyph.advance = advance;
+
+    if (codepoint == ' ' || codepoint == '\t' || codepoint == '\n' || codepoint == '\r')
+        return glyph;
+
+    SDL_Surface *surf = TTF_RenderGlyph_Blended(font, codepoint, {255, 255, 255, 255});
+    if (!surf)
+        return glyph;
+
+    const render::Sprite sprite = atlas.Insert(surf);
+    if (sprite) {
+        stats.uploads++;
+        glyph.texture = sprite.texture;
+        glyph.uv = sprite.uv;
+        glyph.width = sprite.width;
+        glyph.height = sprite.height;
+    }
+    else {
+        CEREKA_LOG_WARN("glyph U+{} does not fit in an atlas page", codepoint);
+    }
+
+    SDL_DestroySurface(surf);
+    return glyph;
+}
+
+const Glyph &GlyphAtlas::Get(Uint32 codepoint)
+{
+    auto it = glyphs.find(codepoint);
+    if (it != glyphs.end()) {
+        stats.hits++;
+        return it->second;
+    }
+    stats.misses++;
+    return glyphs.emplace(codepoint, Rasterize(codepoint)).first->second;
+}
+
+int GlyphAtlas::Kerning(Uint32 previous,
+                        Uint32 codepoint) const
+{
+    int kerning = 0;
+    if (previous && TTF_GetGlyphKerning(font, previous, codepoint, &kerning))
+        return kerning;
+    return 0;
+}
+
+float GlyphAtlas::MeasureText(std::string_view text)
+{
+    const char *p = text.data();
+    size_t left = text.size();
+    Uint32 previous = 0;
+    float width = 0.f;
+    while (left > 0) {
+        Uint32 cp = SDL_StepUTF8(&p, &left);
+        width += Kerning(previous, cp) + Get(cp).advance;
+        previous = cp;
+    }
+    return width;
+}
+
+void GlyphAtlas::DrawText(render::SpriteBatch &batch,
+                          std::string_view text,
+                          float x,
+                          float y,
+                          SDL_Color color,
+                          int layer,
+                          float scale)
+{
+    const SDL_FColor fc{color.r / 255.f, color.g / 255.f, color.b / 255.f, color.a / 255.f};
+    const char *p = text.data();
+    size_t left = text.size();
+    Uint32 previous = 0;
+    float pen = x;
+    while (left > 0) {
+        Uint32 cp = SDL_StepUTF8(&p, &left);
+        const Glyph &glyph = Get(cp);
+        pen += Kerning(previous, cp) * scale;
+        if (glyph.texture)
+            batch.Draw(glyph.texture,
+                       glyph.uv,
+                       {pen, y, glyph.width * scale, glyph.height * scale},
+                       fc,
+                       layer);
+        pen += glyph.advance * scale;
+        previous = cp;
+    }
+}
+
+void GlyphAtlas::Append(TextMesh &mesh,
+                        const Glyph &glyph,
+                        float x,
+                        float y,
+                        SDL_FColor color,
+                        float scale) const
+{
+    if (!glyph.texture)
+        return;
+
+    TextMesh::Batch *batch = nullptr;
+    for (auto &b : mesh.batches) {
+        if (b.texture == glyph.texture) {
+            batch = &b;
+            break;
+        }
+    }
+    if (!batch) {
+        mesh.batches.push_back({glyph.texture, {}, {}});
+        batch = &mesh.batches.back();
+    }
+
+    const int base = int(batch->vertices.size());
+    const float w = glyph.width * scale;
+    const float h = glyph.height * scale;
+    const SDL_FRect &uv = glyph.uv;
+
+    batch->vertices.push_back({{x, y}, color, {uv.x, uv.y}});
+    batch->vertices.push_back({{x + w, y}, color, {uv.x + uv.w, uv.y}});
+    batch->vertices.push_back({{x + w, y + h}, color, {uv.x + uv.w, uv.y + uv.h}});
+    batch->vertices.push_back({{x, y + h}, color, {uv.x, uv.y + uv.h}});
+
+    for (int i : {0, 1, 2, 0, 2, 3})
+        batch->indices.push_back(base + i);
+}
+
+void GlyphAtlas::AppendText(TextMesh &mesh,
+                            std::string_view text,
+                            float x,
+                            float y,
+                            SDL_FColor color,
+                            float scale)
+{
+    const char *p = text.data();
+    size_t left = text.size();
+    Uint32 previous = 0;
+    float pen = x;
+    while (left > 0) {
+        Uint32 cp = SDL_StepUTF8(&p, &left);
+        const Glyph &glyph = Get(cp);
+        pen += Kerning(previous, cp) * scale;
+        Append(mesh, glyph, pen, y, color, scale);
+        pen += glyph.advance * scale;
+        previous = cp;
+    }
+}
+
+void GlyphAtlas::Draw(render::SpriteBatch &batch,
+                      const TextMesh &mesh,
+                      int layer) const
+{
+    for (const auto &b : mesh.batches) {
+        batch.DrawGeometry(b.texture,
+                           b.vertices.data(),
+                           int(b.vertices.size()),
+                           b.indices.data(),
+                           int(b.indices.size()),
+                           layer);
+    }
+}
+
+int GlyphAtlas::LineHeight() const
+{
+    return TTF_GetFontHeight(font);
+}
+
+int GlyphAtlas::LineSkip() const
+{
+    return TTF_GetFontLineSkip(font);
+}
+
+TextLayout LayoutText(GlyphAtlas &atlas,
+                      std::string_view text,
+                      float maxWidth,
+                      int maxLines)
+{
+    TextLayout layout;
+    auto &out = layout.glyphs;
+
+    const char *p = text.data();
+    size_t left = text.size();
+    Uint32 previous = 0;
+    float pen = 0.f;
+    int line = 0;
+    size_t lineStart = 0;
+    size_t lastSpace = size_t(-1);
+
+    while (left > 0) {
+        Uint32 cp = SDL_StepUTF8(&p, &left);
+
+        if (cp == '\n') {
+            out.push_back({cp, &atlas.Get(cp), pen, 0.f, line});
+            line++;
+            lineStart = out.size();
+            pen = 0.f;
+            previous = 0;
+            continue;
+        }
+
+        const Glyph &glyph = atlas.Get(cp);
+        float x = pen + atlas.Kerning(previous, cp);
+
+        if (cp != ' ' && x + glyph.advance > maxWidth && out.size() > lineStart) {
+            line++;
+            if (lastSpace != size_t(-1) && lastSpace >= lineStart && lastSpace + 1 < out.size()) {
+                // Carry the partial word after the last space down to the new line.
+                const float shift = out[lastSpace + 1].x;
+                for (size_t i = lastSpace + 1; i < out.size(); ++i) {
+                    out[i].x -= shift;
+                    out[i].line = line;
+                }
+                lineStart = lastSpace + 1;
+                const auto &last = out.back();
+                pen = last.x + last.glyph->advance;
+                x = pen + atlas.Kerning(previous, cp);
+            }
+            else {
+                lineStart = out.size();
+                pen = 0.f;
+                x = 0.f;
+            }
+        }
+
+        if (cp == ' ')
+            lastSpace = out.size();
+        out.push_back({cp, &glyph, x, 0.f, line});
+        pen = x + glyph.advance;
+        previous = cp;
+    }
+
+    if (maxLines < 1)
+        maxLines = 1;
+    const float lineSkip = float(atlas.LineSkip());
+    int currentPage = -1;
+    for (size_t i = 0; i < out.size(); ++i) {
+        const int page = out[i].line / maxLines;
+        out[i].y = (out[i].line % maxLines) * lineSkip;
+        while (currentPage < page) {
+            layout.pageStarts.push_back(i);
+            currentPage++;
+        }
+    }
+    if (layout.pageStarts.empty())
+        layout.pageStarts.push_back(0);
+
+    return layout;
+}
+
 }  // namespace cereka::text_renderer
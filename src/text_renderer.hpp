@@ -1,6 +1,13 @@
 #pragma once
+#include "sprite_atlas.hpp"
+#include "sprite_batch.hpp"
 #include <SDL3_ttf/SDL_ttf.h>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace cereka::text_renderer {
 
@@ -9,7 +16,7 @@ namespace cereka::text_renderer {
  *
  * This must be called before attempting to use any TTF functions.
  */
-bool init_ttf();
+void init_ttf();
 
 /**
  * Open the font for the application
@@ -18,4 +25,182 @@ bool init_ttf();
  */
 TTF_Font *OpenFont(const std::string &fontPath,
                    int fontSize);
+
+/**
+ * Open a font from a stream, e.g. one from assets::AssetSource. The stream
+ * is closed with the font; `name` is only used in error messages.
+ */
+TTF_Font *OpenFont(SDL_IOStream *io,
+                   const std::string &name,
+                   int fontSize);
+
+/**
+ * A glyph resident in an atlas page.
+ */
+struct Glyph {
+    SDL_Texture *texture = nullptr;  // null for glyphs with no pixels (whitespace)
+    SDL_FRect uv{};
+    float width = 0.f;
+    float height = 0.f;
+    int advance = 0;
+};
+
+/**
+ * Quads for a piece of text that is kept across frames, grouped by atlas page.
+ */
+struct TextMesh {
+    struct Batch {
+        SDL_Texture *texture = nullptr;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+    };
+    std::vector<Batch> batches;
+
+    void Clear()
+    {
+        batches.clear();
+    }
+};
+
+struct GlyphStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t uploads = 0;  // glyphs copied into atlas pages
+};
+
+/**
+ * Glyph cache for one TTF_Font (i.e. one face at one size).
+ *
+ * Glyphs are rasterized once, on first use, into a shared SpriteAtlas and then
+ * drawn as textured quads through a SpriteBatch, so text and UI pieces from
+ * the same page go out in one call.
+ */
+class GlyphAtlas {
+   public:
+    GlyphAtlas(render::SpriteAtlas &atlas,
+               TTF_Font *font);
+
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+    /**
+     * Look up a glyph, rasterizing it into the atlas on a miss.
+     */
+    const Glyph &Get(Uint32 codepoint);
+
+    /**
+     * Kerning adjustment between two codepoints, in pixels.
+     */
+    int Kerning(Uint32 previous,
+                Uint32 codepoint) const;
+
+    /**
+     * Width in pixels of a UTF-8 string drawn on a single line.
+     */
+    float MeasureText(std::string_view text);
+
+    /**
+     * Queue quads for a UTF-8 string with its top-left corner at (x, y).
+     */
+    void DrawText(render::SpriteBatch &batch,
+                  std::string_view text,
+                  float x,
+                  float y,
+                  SDL_Color color,
+                  int layer,
+                  float scale = 1.0f);
+
+    /**
+     * Append a glyph quad to a retained mesh.
+     */
+    void Append(TextMesh &mesh,
+                const Glyph &glyph,
+                float x,
+                float y,
+                SDL_FColor color,
+                float scale = 1.0f) const;
+
+    /**
+     * Append a UTF-8 string on a single line, with its top-left corner at
+     * (x, y), to a retained mesh.
+     */
+    void AppendText(TextMesh &mesh,
+                    std::string_view text,
+                    float x,
+                    float y,
+                    SDL_FColor color,
+                    float scale = 1.0f);
+
+    /**
+     * Queue a retained mesh.
+     */
+    void Draw(render::SpriteBatch &batch,
+              const TextMesh &mesh,
+              int layer) const;
+
+    int LineHeight() const;
+    int LineSkip() const;
+
+    const GlyphStats &Stats() const
+    {
+        return stats;
+    }
+
+    TTF_Font *Font() const
+    {
+        return font;
+    }
+
+   private:
+    Glyph Rasterize(Uint32 codepoint);
+
+    render::SpriteAtlas &atlas;
+    TTF_Font *font;
+    std::unordered_map<Uint32, Glyph> glyphs;
+    GlyphStats stats;
+};
+
+/**
+ * One codepoint of laid-out text, positioned relative to the text box origin.
+ */
+struct PositionedGlyph {
+    Uint32 codepoint = 0;
+    const Glyph *glyph = nullptr;  // owned by the GlyphAtlas
+    float x = 0.f;
+    float y = 0.f;
+    int line = 0;
+};
+
+/**
+ * Word-wrapped, paginated text. Glyphs are indexed by codepoint, not by byte,
+ * and page p covers glyphs [pageStarts[p], pageStarts[p + 1]).
+ */
+struct TextLayout {
+    std::vector<PositionedGlyph> glyphs;
+    std::vector<size_t> pageStarts;
+
+    size_t PageCount() const
+    {
+        return pageStarts.size();
+    }
+    size_t PageBegin(size_t page) const
+    {
+        return page < pageStarts.size() ? pageStarts[page] : glyphs.size();
+    }
+    size_t PageEnd(size_t page) const
+    {
+        return page + 1 < pageStarts.size() ? pageStarts[page + 1] : glyphs.size();
+    }
+};
+
+/**
+ * Lay out UTF-8 text once: break lines at spaces against maxWidth (falling
+ * back to breaking inside a word when it alone is too wide), honour explicit
+ * newlines, and split into pages of at most maxLines lines.
+ */
+TextLayout LayoutText(GlyphAtlas &atlas,
+                      std::string_view text,
+                      float maxWidth,
+                      int maxLines);
+
 }  // namespace cereka::text_renderer
@@ -0,0 +1,181 @@
+#include "texture_cache.hpp"
+#include <utility>
+
+namespace cereka::assets {
+
+struct TextureHandle::Entry {
+    std::string path;
+    SDL_Texture *texture = nullptr;
+    size_t bytes = 0;
+    int refs = 0;
+    bool inLru = false;
+    std::list<Entry *>::iterator lruPos;
+};
+
+static size_t TextureBytes(SDL_Texture *texture)
+{
+    float w = 0, h = 0;
+    SDL_GetTextureSize(texture, &w, &h);
+    return size_t(w) * size_t(h) * 4;
+}
+
+TextureHandle::TextureHandle(TextureCache *cache,
+                             Entry *entry)
+    : cache(cache), entry(entry)
+{
+    cache->AddRef(entry);
+}
+
+TextureHandle::TextureHandle(const TextureHandle &other) : cache(other.cache), entry(other.entry)
+{
+    if (entry)
+        cache->AddRef(entry);
+}
+
+TextureHandle::TextureHandle(TextureHandle &&other) noexcept
+    : cache(std::exchange(other.cache, nullptr)), entry(std::exchange(other.entry, nullptr))
+{
+}
+
+TextureHandle &TextureHandle::operator=(TextureHandle other) noexcept
+{
+    std::swap(cache, other.cache);
+    std::swap(entry, other.entry);
+    return *this;
+}
+
+TextureHandle::~TextureHandle()
+{
+    Reset();
+}
+
+void TextureHandle::Reset()
+{
+    if (entry)
+        cache->Release(entry);
+    cache = nullptr;
+    entry = nullptr;
+}
+
+SDL_Texture *TextureHandle::Get() const
+{
+    return entry ? entry->texture : nullptr;
+}
+
+const std::string &TextureHandle::Path() const
+{
+    static const std::string empty;
+    return entry ? entry->path : empty;
+}
+
+TextureCache::TextureCache(size_t budgetBytes,
+                           Loader loader)
+    : loader(std::move(loader))
+{
+    stats.budgetBytes = budgetBytes;
+}
+
+TextureCache::~TextureCache()
+{
+    for (auto &[path, entry] : entries) {
+        if (entry->texture)
+            SDL_DestroyTexture(entry->texture);
+    }
+}
+
+TextureHandle TextureCache::Acquire(const std::string &path)
+{
+    auto it = entries.find(path);
+    if (it != entries.end()) {
+        stats.hits++;
+        return TextureHandle(this, it->second.get());
+    }
+
+    stats.misses++;
+    SDL_Texture *texture = loader(path);
+    if (!texture)
+        return {};
+
+    auto entry = std::make_unique<Entry>();
+    entry->path = path;
+    entry->texture = texture;
+    entry->bytes = TextureBytes(texture);
+    stats.residentBytes += entry->bytes;
+    stats.textures++;
+
+    Entry *raw = entry.get();
+    entries.emplace(path, std::move(entry));
+    TextureHandle handle(this, raw);
+    EvictToBudget(stats.budgetBytes);
+    return handle;
+}
+
+bool TextureCache::Contains(const std::string &path) const
+{
+    return entries.count(path) != 0;
+}
+
+bool TextureCache::Reload(const std::string &path)
+{
+    auto it = entries.find(path);
+    if (it == entries.end())
+        return false;
+    SDL_Texture *texture = loader(path);
+    if (!texture)
+        return false;
+
+    Entry &entry = *it->second;
+    if (entry.texture)
+        SDL_DestroyTexture(entry.texture);
+    stats.residentBytes -= entry.bytes;
+    entry.texture = texture;
+    entry.bytes = TextureBytes(texture);
+    stats.residentBytes += entry.bytes;
+    EvictToBudget(stats.budgetBytes);
+    return true;
+}
+
+void TextureCache::SetBudget(size_t bytes)
+{
+    stats.budgetBytes = bytes;
+    EvictToBudget(bytes);
+}
+
+void TextureCache::Trim()
+{
+    EvictToBudget(0);
+}
+
+void TextureCache::AddRef(Entry *entry)
+{
+    if (entry->refs++ == 0 && entry->inLru) {
+        lru.erase(entry->lruPos);
+        entry->inLru = false;
+    }
+}
+
+void TextureCache::Release(Entry *entry)
+{
+    if (--entry->refs > 0)
+        return;
+    entry->lruPos = lru.insert(lru.end(), entry);
+    entry->inLru = true;
+    EvictToBudget(stats.budgetBytes);
+}
+
+void TextureCache::EvictToBudget(size_t budget)
+{
+    while (stats.residentBytes > budget && !lru.empty()) {
+        Entry *victim = lru.front();
+        lru.pop_front();
+        stats.residentBytes -= victim->bytes;
+        stats.textures--;
+        stats.evictions++;
+        if (victim->texture)
+            SDL_DestroyTexture(victim->texture);
+        const std::string path = victim->path;
+        entries.erase(path);
+    }
+}
+
+}  // namespace cereka::assets
@@ -0,0 +1,119 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace cereka::assets {
+
+class TextureCache;
+
+/**
+ * Reference-counted handle to a texture owned by a TextureCache.
+ *
+ * While any handle to an entry is alive the entry cannot be evicted. Handles
+ * must not outlive the cache that produced them.
+ */
+class TextureHandle {
+   public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle &other);
+    TextureHandle(TextureHandle &&other) noexcept;
+    TextureHandle &operator=(TextureHandle other) noexcept;
+    ~TextureHandle();
+
+    SDL_Texture *Get() const;
+    const std::string &Path() const;
+
+    explicit operator bool() const
+    {
+        return Get() != nullptr;
+    }
+
+    void Reset();
+
+   private:
+    friend class TextureCache;
+    struct Entry;
+
+    TextureHandle(TextureCache *cache,
+                  Entry *entry);
+
+    TextureCache *cache = nullptr;
+    Entry *entry = nullptr;
+};
+
+struct TextureCacheStats {
+    size_t residentBytes = 0;
+    size_t budgetBytes = 0;
+    size_t textures = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * Texture cache keyed by asset path.
+ *
+ * Textures that are no longer referenced by any handle stay resident on an
+ * LRU list and are destroyed, oldest first, whenever resident bytes exceed the
+ * budget. Referenced textures are never evicted, so the budget can be
+ * exceeded temporarily if the visible scene alone is larger than it.
+ */
+class TextureCache {
+   public:
+    using Loader = std::function<SDL_Texture *(const std::string &path)>;
+
+    TextureCache(size_t budgetBytes,
+                 Loader loader);
+    ~TextureCache();
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    /**
+     * Return a handle to the texture for `path`, loading it on a miss.
+     * The handle is empty if the loader fails.
+     */
+    TextureHandle Acquire(const std::string &path);
+
+    bool Contains(const std::string &path) const;
+
+    /**
+     * Load `path` again if it is cached, swapping the new texture in under
+     * the existing handles. Returns false if it is not cached or the load
+     * fails, in which case the old texture stays.
+     */
+    bool Reload(const std::string &path);
+
+    void SetBudget(size_t bytes);
+
+    /**
+     * Destroy every texture that is not currently referenced.
+     */
+    void Trim();
+
+    const TextureCacheStats &Stats() const
+    {
+        return stats;
+    }
+
+   private:
+    friend class TextureHandle;
+    using Entry = TextureHandle::Entry;
+
+    void AddRef(Entry *entry);
+    void Release(Entry *entry);
+    void EvictToBudget(size_t budget);
+
+    Loader loader;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+    std::list<Entry *> lru;  // unreferenced entries, least recently used first
+    TextureCacheStats stats;
+};
+
+}  // namespace cereka::assets
@@ -0,0 +1,192 @@
+#include "texture_file.hpp"
+#include "Cereka/exceptions.hpp"
+#include "lz.hpp"
+#include "trace.hpp"
+#include <cstring>
+
+namespace cereka::assets {
+
+namespace {
+
+const TextureFileHeader *Validate(std::span<const std::byte> data)
+{
+    if (!IsTextureFile(data) || data.size() < TEXTURE_DATA_OFFSET) {
+        SDL_SetError("not a .ctex image");
+        return nullptr;
+    }
+    const auto *h = reinterpret_cast<const TextureFileHeader *>(data.data());
+    const SDL_PixelFormat format = SDL_PixelFormat(h->format);
+    const uint64_t rowBytes = uint64_t(h->width) * SDL_BYTESPERPIXEL(format);
+    // Every size is checked against the file before Pixels() allocates.
+    if (h->version != TEXTURE_VERSION || SDL_ISPIXELFORMAT_FOURCC(format) ||
+        SDL_ISPIXELFORMAT_INDEXED(format) || h->width == 0 || h->height == 0 ||
+        h->width > TEXTURE_MAX_DIMENSION || h->height > TEXTURE_MAX_DIMENSION || rowBytes == 0 ||
+        h->pitch < rowBytes || h->rawSize != uint64_t(h->height) * h->pitch ||
+        h->dataSize > data.size() - TEXTURE_DATA_OFFSET ||
+        h->rawSize > io::MaxDecompressedSize(h->dataSize) ||
+        (!(h->flags & TEXTURE_COMPRESSED) && h->dataSize != h->rawSize))
+    {
+        SDL_SetError("corrupt .ctex image");
+        return nullptr;
+    }
+    return h;
+}
+
+SDL_BlendMode BlendModeFor(const TextureFileHeader &h)
+{
+    if (!SDL_ISPIXELFORMAT_ALPHA(SDL_PixelFormat(h.format)))
+        return SDL_BLENDMODE_NONE;
+    if (h.flags & TEXTURE_PREMULTIPLIED)
+        return SDL_BLENDMODE_BLEND_PREMULTIPLIED;
+    return SDL_BLENDMODE_BLEND;
+}
+
+// Pixels of a validated image, decompressed into `scratch` if needed.
+const std::byte *Pixels(const TextureFileHeader &h,
+                        std::span<const std::byte> data,
+                        std::vector<std::byte> &scratch)
+{
+    const std::byte *stored = data.data() + TEXTURE_DATA_OFFSET;
+    if (!(h.flags & TEXTURE_COMPRESSED))
+        return stored;
+    scratch.resize(h.rawSize);
+    try {
+        io::Decompress(stored, h.dataSize, scratch.data(), scratch.size());
+    }
+    catch (const engine::error &e) {
+        SDL_SetError("%s", e.what());
+        return nullptr;
+    }
+    return scratch.data();
+}
+
+}  // namespace
+
+const TextureFileHeader *ReadTextureHeader(std::span<const std::byte> data)
+{
+    return Validate(data);
+}
+
+bool IsTextureFile(std::span<const std::byte> data)
+{
+    return data.size() >= sizeof(TextureFileHeader) &&
+           std::memcmp(data.data(), TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC)) == 0;
+}
+
+std::vector<std::byte> EncodeTextureFile(SDL_Surface *surface,
+                                         SDL_PixelFormat format,
+                                         uint32_t flags)
+{
+    if (surface->w > int(TEXTURE_MAX_DIMENSION) || surface->h > int(TEXTURE_MAX_DIMENSION))
+        throw engine::error("Image is %dx%d, larger than %u pixels on a side",
+                            surface->w,
+                            surface->h,
+                            unsigned(TEXTURE_MAX_DIMENSION));
+    SDL_Surface *converted = SDL_ConvertSurface(surface, format);
+    if (!converted)
+        throw engine::error("Could not convert image: %s", SDL_GetError());
+
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    const bool premultiplied =
+        SDL_GetSurfaceBlendMode(surface, &mode) && mode == SDL_BLENDMODE_BLEND_PREMULTIPLIED;
+    if (premultiplied)
+        flags |= TEXTURE_PREMULTIPLIED;
+    if (!SDL_ISPIXELFORMAT_ALPHA(format))
+        flags &= ~TEXTURE_PREMULTIPLIED;
+    if ((flags & TEXTURE_PREMULTIPLIED) && !premultiplied &&
+        !SDL_PremultiplySurfaceAlpha(converted, false))
+    {
+        SDL_DestroySurface(converted);
+        throw engine::error("Could not premultiply image: %s", SDL_GetError());
+    }
+
+    TextureFileHeader header{};
+    std::memcpy(header.magic, TEXTURE_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_VERSION;
+    header.width = uint32_t(converted->w);
+    header.height = uint32_t(converted->h);
+    header.pitch = uint32_t(converted->w * SDL_BYTESPERPIXEL(format));
+    header.format = uint32_t(format);
+    header.rawSize = uint64_t(header.height) * header.pitch;
+
+    // Rows are stored tightly packed, without the surface's padding.
+    std::vector<std::byte> raw(header.rawSize);
+    SDL_LockSurface(converted);
+    const auto *pixels = static_cast<const std::byte *>(converted->pixels);
+    for (uint32_t y = 0; y < header.height; ++y)
+        std::memcpy(raw.data() + size_t(y) * header.pitch,
+                    pixels + size_t(y) * converted->pitch,
+                    header.pitch);
+    SDL_UnlockSurface(converted);
+    SDL_DestroySurface(converted);
+
+    std::vector<std::byte> packed;
+    if (flags & TEXTURE_COMPRESSED) {
+        packed = io::Compress(raw.data(), raw.size());
+        if (packed.size() >= raw.size())
+            flags &= ~TEXTURE_COMPRESSED;
+    }
+    const std::vector<std::byte> &stored = flags & TEXTURE_COMPRESSED ? packed : raw;
+    header.flags = flags;
+    header.dataSize = stored.size();
+
+    std::vector<std::byte> out(TEXTURE_DATA_OFFSET + stored.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + TEXTURE_DATA_OFFSET, stored.data(), stored.size());
+    return out;
+}
+
+SDL_Texture *UploadTextureFile(SDL_Renderer *renderer,
+                               std::span<const std::byte> data)
+{
+    CEREKA_TRACE_ZONE("UploadTextureFile");
+    const TextureFileHeader *h = Validate(data);
+    if (!h)
+        return nullptr;
+
+    std::vector<std::byte> scratch;
+    const std::byte *pixels = Pixels(*h, data, scratch);
+    if (!pixels)
+        return nullptr;
+
+    SDL_Texture *tex = SDL_CreateTexture(renderer,
+                                         SDL_PixelFormat(h->format),
+                                         SDL_TEXTUREACCESS_STATIC,
+                                         int(h->width),
+                                         int(h->height));
+    if (!tex)
+        return nullptr;
+    if (!SDL_UpdateTexture(tex, nullptr, pixels, int(h->pitch))) {
+        SDL_DestroyTexture(tex);
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(tex, BlendModeFor(*h));
+    return tex;
+}
+
+SDL_Surface *DecodeTextureFile(std::span<const std::byte> data)
+{
+    CEREKA_TRACE_ZONE("DecodeTextureFile");
+    const TextureFileHeader *h = Validate(data);
+    if (!h)
+        return nullptr;
+
+    std::vector<std::byte> scratch;
+    const std::byte *pixels = Pixels(*h, data, scratch);
+    if (!pixels)
+        return nullptr;
+
+    SDL_Surface *surface =
+        SDL_CreateSurface(int(h->width), int(h->height), SDL_PixelFormat(h->format));
+    if (!surface)
+        return nullptr;
+    const size_t rowBytes = size_t(h->width) * SDL_BYTESPERPIXEL(SDL_PixelFormat(h->format));
+    for (uint32_t y = 0; y < h->height; ++y)
+        std::memcpy(static_cast<std::byte *>(surface->pixels) + size_t(y) * surface->pitch,
+                    pixels + size_t(y) * h->pitch,
+                    rowBytes);
+    SDL_SetSurfaceBlendMode(surface, BlendModeFor(*h));
+    return surface;
+}
+
+}  // namespace cereka::assets
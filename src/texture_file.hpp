@@ -0,0 +1,77 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace cereka::assets {
+
+/*
+ * Pre-decoded texture (.ctex), little-endian:
+ *
+ *   TextureFileHeader
+ *   pixels at TEXTURE_DATA_OFFSET, `height` rows of `pitch` bytes in
+ *   `format`, optionally io::Compress()ed
+ *
+ * Written offline by cereka_ctex in the pixel format the renderer uses, so
+ * loading is an upload from the mapped bytes with no image decode. The
+ * loader recognises the file by its magic, whatever the asset is called.
+ */
+
+inline constexpr char TEXTURE_MAGIC[4] = {'C', 'T', 'E', 'X'};
+inline constexpr uint32_t TEXTURE_VERSION = 1;
+inline constexpr size_t TEXTURE_DATA_OFFSET = 64;
+// Larger images are rejected as corrupt; no renderer takes them anyway.
+inline constexpr uint32_t TEXTURE_MAX_DIMENSION = 16384;
+
+enum TextureFileFlags : uint32_t {
+    TEXTURE_PREMULTIPLIED = 1 << 0,  // color channels already multiplied by alpha
+    TEXTURE_COMPRESSED = 1 << 1,     // pixels are an io::Compress() stream
+};
+
+struct TextureFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+    uint32_t format;  // SDL_PixelFormat
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t rawSize;   // height * pitch
+    uint64_t dataSize;  // bytes stored after the header
+};
+static_assert(sizeof(TextureFileHeader) <= TEXTURE_DATA_OFFSET);
+
+bool IsTextureFile(std::span<const std::byte> data);
+
+/**
+ * The header of a well-formed .ctex image, or nullptr.
+ */
+const TextureFileHeader *ReadTextureHeader(std::span<const std::byte> data);
+
+/**
+ * Convert `surface` to `format` (premultiplying alpha if asked, unless the
+ * surface's blend mode says it already is) and build a .ctex image. Throws
+ * engine::error.
+ */
+std::vector<std::byte> EncodeTextureFile(SDL_Surface *surface,
+                                         SDL_PixelFormat format,
+                                         uint32_t flags);
+
+/**
+ * Create a texture straight from a .ctex image. Uncompressed pixels are
+ * uploaded from `data` as is. Returns nullptr (with SDL_GetError() set) if
+ * the image is malformed or the upload fails.
+ */
+SDL_Texture *UploadTextureFile(SDL_Renderer *renderer,
+                               std::span<const std::byte> data);
+
+/**
+ * Unpack a .ctex image into a new surface that carries the right blend mode,
+ * for decoding off the main thread. Returns nullptr on malformed input.
+ */
+SDL_Surface *DecodeTextureFile(std::span<const std::byte> data);
+
+}  // namespace cereka::assets
@@ -0,0 +1,84 @@
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace cereka::threading {
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0) {
+        const size_t hw = std::thread::hardware_concurrency();
+        threads = std::max<size_t>(1, hw > 1 ? hw - 1 : 1);
+    }
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+        workers.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    Shutdown();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(mutex);
+        if (stopping)
+            return;
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && running == 0; });
+}
+
+void ThreadPool::Shutdown()
+{
+    {
+        std::lock_guard lock(mutex);
+        if (stopping && workers.empty())
+            return;
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    idle.notify_all();
+    for (auto &t : workers) {
+        if (t.joinable())
+            t.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    CEREKA_TRACE_THREAD_NAME("worker");
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            running++;
+        }
+
+        job();
+
+        {
+            std::lock_guard lock(mutex);
+            running--;
+            if (jobs.empty() && running == 0)
+                idle.notify_all();
+        }
+    }
+}
+
+}  // namespace cereka::threading
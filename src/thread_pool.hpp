@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cereka::threading {
+
+/**
+ * Fixed-size pool of worker threads draining a FIFO job queue.
+ */
+class ThreadPool {
+   public:
+    /**
+     * Start `threads` workers. Zero picks one less than the number of
+     * hardware threads (at least one), leaving a core for the main loop.
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void Submit(std::function<void()> job);
+
+    /**
+     * Block until the queue is empty and no job is running.
+     */
+    void Wait();
+
+    /**
+     * Drop queued jobs and join the workers. Running jobs finish first.
+     */
+    void Shutdown();
+
+    size_t Size() const
+    {
+        return workers.size();
+    }
+
+   private:
+    void WorkerLoop();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+}  // namespace cereka::threading
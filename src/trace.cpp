@@ -0,0 +1,212 @@
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cereka::trace {
+
+namespace {
+
+enum class EventType : uint8_t { Zone, Counter };
+
+struct Event {
+    const char *name;
+    uint64_t start;
+    union {
+        uint64_t end;
+        double value;
+    };
+    EventType type;
+};
+
+/*
+ * A ring slot is a sequence lock, so a dump can copy it while its thread keeps
+ * recording. `seq` is 2 * i + 1 while event i is written and 2 * i + 2 once it
+ * is complete; the fields are atomics only so the racy copy is well defined.
+ */
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> bits{0};  // end or value
+    std::atomic<EventType> type{EventType::Zone};
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> head{0};  // total events ever written
+    std::vector<Slot> slots = std::vector<Slot>(RING_CAPACITY);
+
+    void Push(const Event &e)
+    {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[h % RING_CAPACITY];
+        slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(e.name, std::memory_order_relaxed);
+        slot.start.store(e.start, std::memory_order_relaxed);
+        slot.bits.store(e.end, std::memory_order_relaxed);
+        slot.type.store(e.type, std::memory_order_relaxed);
+        slot.seq.store(2 * h + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    /**
+     * Copy event `i` into `e`. False if the slot has moved on to a later
+     * event, or is being written.
+     */
+    bool Read(uint64_t i,
+              Event &e) const
+    {
+        const Slot &slot = slots[i % RING_CAPACITY];
+        if (slot.seq.load(std::memory_order_acquire) != 2 * i + 2)
+            return false;
+        e.name = slot.name.load(std::memory_order_relaxed);
+        e.start = slot.start.load(std::memory_order_relaxed);
+        e.end = slot.bits.load(std::memory_order_relaxed);
+        e.type = slot.type.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == 2 * i + 2;
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    // Buffers are never freed so that events from exited threads survive.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &GetRegistry()
+{
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+ThreadBuffer &LocalBuffer()
+{
+    thread_local ThreadBuffer *buffer = [] {
+        Registry &reg = GetRegistry();
+        std::lock_guard lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+        reg.buffers.back()->tid = uint32_t(reg.buffers.size());
+        return reg.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+const uint64_t g_epoch = uint64_t(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+        .count());
+
+void WriteEscaped(FILE *f,
+                  const char *s)
+{
+    for (; s && *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            std::fputc('\\', f);
+        std::fputc(*s, f);
+    }
+}
+
+}  // namespace
+
+uint64_t NowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count()) -
+           g_epoch;
+}
+
+void RecordZone(const char *name,
+                uint64_t startNs,
+                uint64_t endNs)
+{
+    Event e;
+    e.name = name;
+    e.start = startNs;
+    e.end = endNs;
+    e.type = EventType::Zone;
+    LocalBuffer().Push(e);
+}
+
+void RecordCounter(const char *name,
+                   double value)
+{
+    Event e;
+    e.name = name;
+    e.start = NowNs();
+    e.value = value;
+    e.type = EventType::Counter;
+    LocalBuffer().Push(e);
+}
+
+void SetThreadName(const char *name)
+{
+    LocalBuffer().name.store(name, std::memory_order_release);
+}
+
+bool WriteChromeTrace(const std::string &path)
+{
+    FILE *f = std::fopen(path.c_str(), "w");
+    if (!f)
+        return false;
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    bool first = true;
+    auto sep = [&] {
+        if (!first)
+            std::fputs(",\n", f);
+        first = false;
+    };
+
+    Registry &reg = GetRegistry();
+    std::lock_guard lock(reg.mutex);
+    for (const auto &buf : reg.buffers) {
+        if (const char *name = buf->name.load(std::memory_order_acquire)) {
+            sep();
+            std::fprintf(f,
+                         "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                         "\"args\":{\"name\":\"",
+                         buf->tid);
+            WriteEscaped(f, name);
+            std::fputs("\"}}", f);
+        }
+
+        const uint64_t head = buf->head.load(std::memory_order_acquire);
+        const uint64_t begin = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            // Events overwritten while the dump runs are dropped.
+            Event e;
+            if (!buf->Read(i, e))
+                continue;
+            sep();
+            if (e.type == EventType::Zone) {
+                std::fprintf(f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"", buf->tid);
+                WriteEscaped(f, e.name);
+                std::fprintf(f,
+                             "\",\"ts\":%.3f,\"dur\":%.3f}",
+                             e.start / 1000.0,
+                             (e.end - e.start) / 1000.0);
+            }
+            else {
+                std::fprintf(f, "{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"name\":\"", buf->tid);
+                WriteEscaped(f, e.name);
+                std::fprintf(f,
+                             "\",\"ts\":%.3f,\"args\":{\"value\":%g}}",
+                             e.start / 1000.0,
+                             e.value);
+            }
+        }
+    }
+
+    std::fputs("\n]}\n", f);
+    return std::fclose(f) == 0;
+}
+
+}  // namespace cereka::trace
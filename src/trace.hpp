@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+ * Lightweight scoped tracing.
+ *
+ *   CEREKA_TRACE_ZONE("Draw");              // times the enclosing scope
+ *   CEREKA_TRACE_COUNTER("pc", pc);         // samples a value
+ *
+ * Names must be string literals (only the pointer is stored). Events go to a
+ * per-thread ring buffer and are written out as Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev both open. With CEREKA_ENABLE_TRACING
+ * off (the default) the macros expand to nothing and their arguments are not
+ * evaluated.
+ */
+
+#ifndef CEREKA_ENABLE_TRACING
+#    define CEREKA_ENABLE_TRACING 0
+#endif
+
+namespace cereka::trace {
+
+/**
+ * True when the engine was built with CEREKA_ENABLE_TRACING.
+ */
+constexpr bool Enabled()
+{
+    return CEREKA_ENABLE_TRACING != 0;
+}
+
+/**
+ * Events kept per thread; older events are overwritten.
+ */
+inline constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+uint64_t NowNs();
+
+void RecordZone(const char *name,
+                uint64_t startNs,
+                uint64_t endNs);
+void RecordCounter(const char *name,
+                   double value);
+
+/**
+ * Label the calling thread in the exported trace.
+ */
+void SetThreadName(const char *name);
+
+/**
+ * Write every buffered event as Chrome trace JSON. Returns false if the file
+ * cannot be written. Events recorded while the dump runs may be dropped.
+ */
+bool WriteChromeTrace(const std::string &path);
+
+class Zone {
+   public:
+    explicit Zone(const char *name) : name(name), start(NowNs()) {}
+    ~Zone()
+    {
+        RecordZone(name, start, NowNs());
+    }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+   private:
+    const char *name;
+    uint64_t start;
+};
+
+}  // namespace cereka::trace
+
+#define CEREKA_TRACE_CONCAT_(a, b) a##b
+#define CEREKA_TRACE_CONCAT(a, b) CEREKA_TRACE_CONCAT_(a, b)
+
+#if CEREKA_ENABLE_TRACING
+#    define CEREKA_TRACE_ZONE(name) \
+        ::cereka::trace::Zone CEREKA_TRACE_CONCAT(cerekaTraceZone_, __LINE__)(name)
+#    define CEREKA_TRACE_COUNTER(name, value) \
+        ::cereka::trace::RecordCounter(name, static_cast<double>(value))
+#    define CEREKA_TRACE_THREAD_NAME(name) ::cereka::trace::SetThreadName(name)
+#else
+#    define CEREKA_TRACE_ZONE(name) ((void)0)
+#    define CEREKA_TRACE_COUNTER(name, value) ((void)0)
+#    define CEREKA_TRACE_THREAD_NAME(name) ((void)0)
+#endif
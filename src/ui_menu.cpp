@@ -0,0 +1,215 @@
+#include "ui_menu.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace cereka::ui {
+
+namespace {
+
+constexpr float MARGIN = 20.f;
+constexpr float PITCH_X = Menu::BUTTON_WIDTH + Menu::SPACING;
+constexpr float PITCH_Y = Menu::BUTTON_HEIGHT + Menu::SPACING;
+
+constexpr SDL_FColor BUTTON_COLOR{0.f, 1.f, 1.f, 1.f};
+constexpr SDL_FColor HOVER_COLOR{0.6f, 1.f, 1.f, 1.f};
+constexpr SDL_FColor PRESSED_COLOR{0.f, 0.7f, 0.7f, 1.f};
+constexpr SDL_FColor LABEL_COLOR{1.f, 1.f, 1.f, 1.f};
+
+}  // namespace
+
+void HitGrid::Reset(const SDL_FRect &bounds,
+                    float cellWidth,
+                    float cellHeight)
+{
+    this->bounds = bounds;
+    this->cellWidth = std::max(cellWidth, 1.f);
+    this->cellHeight = std::max(cellHeight, 1.f);
+    columns = std::max(1, int(std::ceil(bounds.w / this->cellWidth)));
+    rows = std::max(1, int(std::ceil(bounds.h / this->cellHeight)));
+    cells.assign(size_t(columns) * rows, {});
+}
+
+void HitGrid::Insert(const SDL_FRect &rect,
+                     int id)
+{
+    const int c0 = std::max(0, int((rect.x - bounds.x) / cellWidth));
+    const int r0 = std::max(0, int((rect.y - bounds.y) / cellHeight));
+    const int c1 = std::min(columns - 1, int((rect.x + rect.w - bounds.x) / cellWidth));
+    const int r1 = std::min(rows - 1, int((rect.y + rect.h - bounds.y) / cellHeight));
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c)
+            cells[size_t(r) * columns + c].push_back({rect, id});
+    }
+}
+
+int HitGrid::Find(float x,
+                  float y) const
+{
+    if (x < bounds.x || y < bounds.y)
+        return -1;
+    const int c = int((x - bounds.x) / cellWidth);
+    const int r = int((y - bounds.y) / cellHeight);
+    if (c >= columns || r >= rows)
+        return -1;
+    for (const Entry &e : cells[size_t(r) * columns + c]) {
+        if (x >= e.rect.x && x <= e.rect.x + e.rect.w && y >= e.rect.y && y <= e.rect.y + e.rect.h)
+            return e.id;
+    }
+    return -1;
+}
+
+void Menu::Clear()
+{
+    items.clear();
+    laidOut = false;
+    scrollRow = 0;
+    hovered = -1;
+    pressed = -1;
+    labels.Clear();
+    labelsDirty = true;
+}
+
+void Menu::Add(MenuItem item)
+{
+    items.push_back(std::move(item));
+    laidOut = false;
+}
+
+void Menu::Layout(int screenWidth,
+                  int screenHeight)
+{
+    if (laidOut && screenWidth == layoutWidth && screenHeight == layoutHeight)
+        return;
+    CEREKA_TRACE_ZONE("Menu.Layout");
+    laidOut = true;
+    layoutWidth = screenWidth;
+    layoutHeight = screenHeight;
+
+    const int n = int(items.size());
+    const float classicTop = screenHeight * 0.4f;
+    if (classicTop + n * PITCH_Y - SPACING <= screenHeight - MARGIN) {
+        columns = 1;
+        top = classicTop;
+        totalRows = visibleRows = n;
+    }
+    else {
+        top = screenHeight * 0.1f;
+        visibleRows = std::max(1, int((screenHeight * 0.9f - top + SPACING) / PITCH_Y));
+        const int maxColumns = std::max(1, int((screenWidth - 2 * MARGIN + SPACING) / PITCH_X));
+        columns = std::clamp((n + visibleRows - 1) / visibleRows, 1, maxColumns);
+        totalRows = (n + columns - 1) / columns;
+    }
+    left = (screenWidth - (columns * PITCH_X - SPACING)) / 2;
+    scrollRow = std::clamp(scrollRow, 0, std::max(0, totalRows - visibleRows));
+
+    grid.Reset({left, top, columns * PITCH_X, std::max(totalRows, 1) * PITCH_Y}, PITCH_X, PITCH_Y);
+    for (int i = 0; i < n; ++i)
+        grid.Insert(ContentRect(i), i);
+    labelsDirty = true;
+}
+
+SDL_FRect Menu::ContentRect(size_t index) const
+{
+    const int col = int(index) % columns;
+    const int row = int(index) / columns;
+    return {left + col * PITCH_X, top + row * PITCH_Y, BUTTON_WIDTH, BUTTON_HEIGHT};
+}
+
+SDL_FRect Menu::ItemRect(int index) const
+{
+    if (index < 0 || size_t(index) >= items.size())
+        return {};
+    SDL_FRect r = ContentRect(size_t(index));
+    r.y -= scrollRow * PITCH_Y;
+    return r;
+}
+
+SDL_FRect Menu::Viewport() const
+{
+    return {left, top, columns * PITCH_X - SPACING, visibleRows * PITCH_Y - SPACING};
+}
+
+size_t Menu::FirstVisible() const
+{
+    return std::min(items.size(), size_t(scrollRow) * columns);
+}
+
+size_t Menu::LastVisible() const
+{
+    return std::min(items.size(), size_t(scrollRow + visibleRows) * columns);
+}
+
+int Menu::HitTest(float x,
+                  float y) const
+{
+    const SDL_FRect view = Viewport();
+    if (!laidOut || y < view.y || y > view.y + view.h)
+        return -1;
+    return grid.Find(x, y + scrollRow * PITCH_Y);
+}
+
+bool Menu::SetHovered(int index)
+{
+    if (index == hovered)
+        return false;
+    hovered = index;
+    return true;
+}
+
+bool Menu::SetPressed(int index)
+{
+    if (index == pressed)
+        return false;
+    pressed = index;
+    return true;
+}
+
+bool Menu::Scroll(int rows)
+{
+    const int row = std::clamp(scrollRow + rows, 0, std::max(0, totalRows - visibleRows));
+    if (row == scrollRow)
+        return false;
+    scrollRow = row;
+    labelsDirty = true;
+    return true;
+}
+
+void Menu::Draw(render::SpriteBatch &batch,
+                const render::Sprite &white,
+                text_renderer::GlyphAtlas *glyphs,
+                int boxLayer,
+                int textLayer)
+{
+    const size_t first = FirstVisible(), last = LastVisible();
+    for (size_t i = first; i < last; ++i) {
+        const int index = int(i);
+        const SDL_FColor color = index == pressed   ? PRESSED_COLOR
+                                 : index == hovered ? HOVER_COLOR
+                                                    : BUTTON_COLOR;
+        batch.Draw(white, ItemRect(index), color, boxLayer);
+    }
+
+    if (!glyphs)
+        return;
+    if (labelsDirty) {
+        CEREKA_TRACE_ZONE("Menu.Labels");
+        labels.Clear();
+        const float th = float(glyphs->LineHeight());
+        for (size_t i = first; i < last; ++i) {
+            if (items[i].text.empty())
+                continue;
+            const SDL_FRect r = ItemRect(int(i));
+            const float tw = glyphs->MeasureText(items[i].text);
+            glyphs->AppendText(labels,
+                               items[i].text,
+                               r.x + (r.w - tw) / 2,
+                               r.y + (r.h - th) / 2,
+                               LABEL_COLOR);
+        }
+        labelsDirty = false;
+    }
+    glyphs->Draw(batch, labels, textLayer);
+}
+
+}  // namespace cereka::ui
@@ -0,0 +1,160 @@
+#pragma once
+#include "sprite_batch.hpp"
+#include "text_renderer.hpp"
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cereka::ui {
+
+/**
+ * Uniform grid over a set of rectangles, so that finding the one under a
+ * point only looks at the rectangles sharing its cell, however many there
+ * are. Rectangles may span cells; the first inserted wins where they overlap.
+ */
+class HitGrid {
+   public:
+    /**
+     * Start over with cells of cellWidth x cellHeight covering `bounds`.
+     */
+    void Reset(const SDL_FRect &bounds,
+               float cellWidth,
+               float cellHeight);
+
+    void Insert(const SDL_FRect &rect,
+                int id);
+
+    /**
+     * Id of the rectangle containing (x, y), or -1.
+     */
+    int Find(float x,
+             float y) const;
+
+   private:
+    struct Entry {
+        SDL_FRect rect;
+        int id;
+    };
+
+    SDL_FRect bounds{};
+    float cellWidth = 1.f;
+    float cellHeight = 1.f;
+    int columns = 0;
+    int rows = 0;
+    std::vector<std::vector<Entry>> cells;  // row-major
+};
+
+struct MenuItem {
+    std::string text;
+    size_t target = 0;  // instruction to continue at
+    bool exit = false;
+};
+
+/**
+ * The button list of a menu, retained from EnterMenu() until the menu
+ * closes.
+ *
+ * Layout is computed once per screen size and shared by drawing and hit
+ * testing. A menu that fits keeps the classic single centered column below
+ * 40% of the screen height; longer ones (chapter select, galleries) become
+ * a grid that scrolls by whole rows. Only the visible rows are drawn and
+ * their labels are kept as one text mesh, rebuilt when the layout or the
+ * scroll position changes, so a frame costs the same for ten entries or a
+ * thousand.
+ */
+class Menu {
+   public:
+    static constexpr float BUTTON_WIDTH = 600.f;
+    static constexpr float BUTTON_HEIGHT = 80.f;
+    static constexpr float SPACING = 20.f;
+
+    void Clear();
+    void Add(MenuItem item);
+
+    const std::vector<MenuItem> &Items() const
+    {
+        return items;
+    }
+    size_t Size() const
+    {
+        return items.size();
+    }
+
+    /**
+     * Lay out for a screenWidth x screenHeight screen. Does nothing if the
+     * items and the size are unchanged since the last call.
+     */
+    void Layout(int screenWidth,
+                int screenHeight);
+
+    /**
+     * Index of the visible button under (x, y), or -1.
+     */
+    int HitTest(float x,
+                float y) const;
+
+    /**
+     * On-screen rectangle of button `index` at the current scroll position.
+     */
+    SDL_FRect ItemRect(int index) const;
+
+    /**
+     * The area the visible buttons occupy.
+     */
+    SDL_FRect Viewport() const;
+
+    int Hovered() const
+    {
+        return hovered;
+    }
+    int Pressed() const
+    {
+        return pressed;
+    }
+
+    // These return true if the menu's look changed.
+    bool SetHovered(int index);
+    bool SetPressed(int index);
+
+    /**
+     * Scroll by `rows` (negative is up), clamped to the content.
+     */
+    bool Scroll(int rows);
+
+    /**
+     * Queue the visible buttons on `boxLayer` and their labels on
+     * `textLayer`, which must be above it.
+     */
+    void Draw(render::SpriteBatch &batch,
+              const render::Sprite &white,
+              text_renderer::GlyphAtlas *glyphs,
+              int boxLayer,
+              int textLayer);
+
+   private:
+    // Items in the visible rows: [first, last).
+    size_t FirstVisible() const;
+    size_t LastVisible() const;
+    SDL_FRect ContentRect(size_t index) const;
+
+    std::vector<MenuItem> items;
+    bool laidOut = false;
+    int layoutWidth = 0;
+    int layoutHeight = 0;
+    float left = 0.f;
+    float top = 0.f;
+    int columns = 1;
+    int totalRows = 0;
+    int visibleRows = 0;
+    int scrollRow = 0;
+    HitGrid grid;  // in content coordinates, i.e. before scrolling
+
+    int hovered = -1;
+    int pressed = -1;
+
+    text_renderer::TextMesh labels;
+    bool labelsDirty = true;
+};
+
+}  // namespace cereka::ui
@@ -1,10 +1,10 @@
 #include "video.hpp"
 #include "Cereka/exceptions.hpp"
+#include "log.hpp"
 #include "SDL3/SDL_error.h"
 #include "SDL3/SDL_init.h"
 #include <SDL3/SDL.h>
 #include <cassert>
-#include <iostream>
 
 namespace cereka::video {
 
@@ -40,7 +40,7 @@ void deinit_video()
 
     // Close the video subsystem.
     if (SDL_WasInit(SDL_INIT_VIDEO)) {
-        SDL_Log("quitting SDL video subsystem");
+        CEREKA_LOG_DEBUG("quitting SDL video subsystem");
         SDL_QuitSubSystem(SDL_INIT_VIDEO);
     }
     if (SDL_WasInit(SDL_INIT_VIDEO)) {
@@ -59,18 +59,29 @@ void create_window(const char *title,
         flags |= SDL_WINDOW_FULLSCREEN;
 
     SDL_DisplayID id = SDL_GetPrimaryDisplay();
-    std::cout << "display id: " << id << std::endl;
-
     const SDL_DisplayMode *mode = SDL_GetCurrentDisplayMode(id);
-    video::width = mode->w;
-    video::height = mode->h;
+    if (mode)
+        CEREKA_LOG_INFO("display {}: {}x{}", id, mode->w, mode->h);
 
-    std::cout << "Width: " << video::width << std::endl;
-    std::cout << "Height: " << video::height << std::endl;
+    // Fullscreen, or no size given, takes the whole display.
+    if (fullscreen || width <= 0 || height <= 0) {
+        if (!mode)
+            throw engine::error("Could not query the display mode: %s", SDL_GetError());
+        width = mode->w;
+        height = mode->h;
+    }
 
-    video::window = SDL_CreateWindow(title, video::width, video::height, flags);
+    video::window = SDL_CreateWindow(title, width, height, flags);
     if (!video::window) {
         throw engine::error("Create window failed: %s", SDL_GetError());
     }
+
+    // Draw in the renderer's pixels, which differ from window units on
+    // high-density displays.
+    if (!SDL_GetWindowSizeInPixels(video::window, &video::width, &video::height)) {
+        video::width = width;
+        video::height = height;
+    }
+    CEREKA_LOG_INFO("window: {}x{} pixels", video::width, video::height);
 }
 }  // namespace cereka::video
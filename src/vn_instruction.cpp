@@ -1,17 +1,45 @@
 #include "vn_instruction.hpp"
+#include "log.hpp"
+#include "script_parser.hpp"
+#include "trace.hpp"
+#include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <memory>
 #include <sol/sol.hpp>
 #include <sstream>
 
 namespace cereka::scenario {
 
+static std::vector<Instruction> CompileWithLua(const std::string &filename);
+
 std::vector<Instruction> CompileVNScript(const std::string &filename)
 {
+    CEREKA_TRACE_ZONE("CompileVNScript");
+    try {
+        return ParseVNScriptFile(filename);
+    }
+    catch (const CompileError &e) {
+        // Scripts written for a custom compiler.lua keep working through it.
+        if (!std::filesystem::exists("compiler.lua")) {
+            CEREKA_LOG_ERROR("{}", e.what());
+            return {};
+        }
+        CEREKA_LOG_WARN("{}; falling back to compiler.lua", e.what());
+    }
+    catch (const engine::error &e) {
+        CEREKA_LOG_ERROR("{}", e.what());
+        return {};
+    }
+    return CompileWithLua(filename);
+}
+
+static std::vector<Instruction> CompileWithLua(const std::string &filename)
+{
+    CEREKA_TRACE_ZONE("CompileWithLua");
 
     std::ifstream f(filename);
     if (!f) {
-        std::cerr << "[ERROR] Could not open file: " << filename << "\n";
+        CEREKA_LOG_ERROR("could not open file: {}", filename);
         return {};
     }
 
@@ -19,40 +47,58 @@ std::vector<Instruction> CompileVNScript(const std::string &filename)
     buffer << f.rdbuf();
     std::string scriptText = buffer.str();
 
-    sol::state lua;
-    lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::table);
-
-    // Load your Lua compiler
-    sol::load_result loadRes = lua.load_file("compiler.lua");
-    if (!loadRes.valid()) {
-        sol::error err = loadRes;
-        std::cerr << "[ERROR] Failed to load compiler.lua: " << err.what() << "\n";
-        return {};
-    }
-    loadRes();  // execute the compiler.lua
+    // One Lua state per thread, reused across calls so that project builds
+    // load compiler.lua once per worker. Reloaded if the file changes.
+    struct CompilerContext {
+        sol::state lua;
+        sol::function compile;
+        std::filesystem::file_time_type stamp{};
+    };
+    thread_local std::unique_ptr<CompilerContext> context;
+
+    std::error_code ec;
+    const auto stamp = std::filesystem::last_write_time("compiler.lua", ec);
+    if (!context || context->stamp != stamp) {
+        context = std::make_unique<CompilerContext>();
+        sol::state &lua = context->lua;
+        lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::table);
+
+        // Load your Lua compiler
+        sol::load_result loadRes = lua.load_file("compiler.lua");
+        if (!loadRes.valid()) {
+            sol::error err = loadRes;
+            CEREKA_LOG_ERROR("failed to load compiler.lua: {}", err.what());
+            context.reset();
+            return {};
+        }
+        loadRes();  // execute the compiler.lua
 
-    sol::function compileFunc = lua["compile"];
-    if (!compileFunc.valid()) {
-        std::cerr << "[ERROR] Lua function 'compile' not found\n";
-        return {};
+        context->compile = lua["compile"];
+        if (!context->compile.valid()) {
+            CEREKA_LOG_ERROR("Lua function 'compile' not found");
+            context.reset();
+            return {};
+        }
+        context->stamp = stamp;
     }
+    sol::function &compileFunc = context->compile;
 
     sol::protected_function_result resultRes = compileFunc(scriptText);
     if (!resultRes.valid()) {
         sol::error err = resultRes;
-        std::cerr << "[ERROR] Lua compile failed: " << err.what() << "\n";
+        CEREKA_LOG_ERROR("Lua compile failed: {}", err.what());
         return {};
     }
 
     sol::table result = resultRes;
     if (!result.valid()) {
-        std::cerr << "[ERROR] Lua compile returned invalid table\n";
+        CEREKA_LOG_ERROR("Lua compile returned invalid table");
         return {};
     }
 
     sol::table instructions = result["instructions"];
     if (!instructions.valid()) {
-        std::cerr << "[ERROR] Lua result has no 'instructions' table\n";
+        CEREKA_LOG_ERROR("Lua result has no 'instructions' table");
         return {};
     }
 
@@ -60,14 +106,14 @@ std::vector<Instruction> CompileVNScript(const std::string &filename)
 
     for (auto &p : instructions.pairs()) {
         if (!p.second.is<sol::table>()) {
-            std::cerr << "[WARNING] Skipping non-table instruction\n";
+            CEREKA_LOG_WARN("skipping non-table instruction");
             continue;
         }
 
         sol::table t = p.second.as<sol::table>();
         std::string op = t["op"].get_or<std::string>("");
         if (op.empty()) {
-            std::cerr << "[WARNING] Instruction missing 'op'\n";
+            CEREKA_LOG_WARN("instruction missing 'op'");
             continue;
         }
 
@@ -90,8 +136,16 @@ std::vector<Instruction> CompileVNScript(const std::string &filename)
             ins.op = Op::BUTTON;
         else if (op == "MENU")
             ins.op = Op::MENU;
+        else if (op == "BGM")
+            ins.op = Op::BGM;
+        else if (op == "SFX")
+            ins.op = Op::SFX;
+        else if (op == "VOICE")
+            ins.op = Op::VOICE;
+        else if (op == "HIDE")
+            ins.op = Op::HIDE;
         else {
-            std::cerr << "[WARNING] Unknown op: " << op << "\n";
+            CEREKA_LOG_WARN("unknown op: {}", op);
             continue;
         }
 
@@ -5,7 +5,7 @@
 
 namespace cereka::scenario {
 
-enum class Op { BG, CHAR, SAY, NARRATE, LABEL, JUMP, MENU, BUTTON, END };
+enum class Op { BG, CHAR, SAY, NARRATE, LABEL, JUMP, MENU, BUTTON, END, BGM, SFX, VOICE, HIDE };
 
 struct ChoiceOption {
     std::string text;
@@ -20,6 +20,11 @@ struct Instruction {
     std::vector<ChoiceOption> choices;
 };
 
+/**
+ * Compile a script with the native parser (see script_parser.hpp). If it
+ * reports a syntax error and a compiler.lua exists in the working directory,
+ * that is tried instead. Errors are logged; the result is empty on failure.
+ */
 std::vector<Instruction> CompileVNScript(const std::string &filename);
 
 }  // namespace cereka::scenario
@@ -0,0 +1,47 @@
+#pragma once
+#include "Cereka/exceptions.hpp"
+#include <cstdio>
+
+/*
+ * Minimal checks for the unit tests. A failed check reports where it failed
+ * and the test carries on; main() returns test::Result() so ctest sees the
+ * failure.
+ */
+
+namespace cereka::test {
+
+inline int failures = 0;
+
+inline void Fail(const char *file,
+                 int line,
+                 const char *what)
+{
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    failures++;
+}
+
+inline int Result()
+{
+    if (failures)
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
+
+}  // namespace cereka::test
+
+#define CHECK(cond) \
+    ((cond) ? (void)0 : ::cereka::test::Fail(__FILE__, __LINE__, #cond))
+
+// `expr` must throw engine::error; anything else escapes and fails the test.
+#define CHECK_THROWS(expr) \
+    do { \
+        bool cerekaThrew = false; \
+        try { \
+            (void)(expr); \
+        } \
+        catch (const ::cereka::engine::error &) { \
+            cerekaThrew = true; \
+        } \
+        if (!cerekaThrew) \
+            ::cereka::test::Fail(__FILE__, __LINE__, "throws: " #expr); \
+    } while (0)
@@ -0,0 +1,144 @@
+#include "check.hpp"
+#include "input_log.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+const std::string PATH = "test_input_log.crki";
+
+std::vector<std::byte> ReadAll(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    std::vector<char> chars((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    std::vector<std::byte> out(chars.size());
+    std::memcpy(out.data(), chars.data(), chars.size());
+    return out;
+}
+
+void WriteAll(const std::string &path,
+              const std::vector<std::byte> &data)
+{
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+}
+
+// A short session: a click, a skip and a long idle stretch.
+std::vector<std::byte> Record(save::Snapshot &start)
+{
+    start.programHash = 99;
+    start.pc = 3;
+    start.text = "Hello.";
+    std::vector<std::byte> state;
+    save::Serialize(start, state);
+
+    replay::InputRecorder recorder(PATH, 640, 480, 99, state, {0x5, 0x80000000u});
+    recorder.Event({CerekaEvent::MouseDown, 0, 10.f, 20.f, 0.f});
+    recorder.Event({CerekaEvent::KeyDown, 32, 0.f, 0.f, 0.f});
+    recorder.EndFrame(0.016f);
+    recorder.Skip(SkipMode::Read);
+    recorder.SkipSteps(7);
+    recorder.Event({CerekaEvent::MouseWheel, 0, 1.f, 2.f, -3.f});
+    recorder.EndFrame(0.017f);
+    for (int i = 0; i < 500; ++i)
+        recorder.EndFrame(0.016f);
+    CHECK(recorder.Frames() == 502);
+    recorder.Finish();
+    return ReadAll(PATH);
+}
+
+void TestRoundTrip()
+{
+    save::Snapshot start;
+    const std::vector<std::byte> file = Record(start);
+    replay::InputLogHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    CHECK(header.flags & replay::INPUT_LOG_COMPRESSED);
+
+    const replay::InputLog log = replay::ReadInputLog(PATH);
+    CHECK(log.width == 640 && log.height == 480 && log.programHash == 99);
+    CHECK(log.start.pc == start.pc && log.start.text == start.text);
+    CHECK((log.readHistory == std::vector<uint64_t>{0x5, 0x80000000u}));
+    CHECK(log.frames.size() == 502);
+    if (log.frames.size() != 502)
+        return;
+
+    const replay::InputFrame &first = log.frames[0];
+    CHECK(first.dt == 0.016f && !first.skipSteps && first.actions.size() == 2);
+    CHECK(first.actions[0].event.type == CerekaEvent::MouseDown);
+    CHECK(first.actions[0].event.mouseX == 10.f && first.actions[0].event.mouseY == 20.f);
+    CHECK(first.actions[1].event.type == CerekaEvent::KeyDown && first.actions[1].event.key == 32);
+
+    const replay::InputFrame &second = log.frames[1];
+    CHECK(second.dt == 0.017f && second.skipSteps == 7u && second.actions.size() == 2);
+    CHECK(second.actions[0].kind == replay::InputAction::Skip);
+    CHECK(second.actions[0].skip == SkipMode::Read);
+    CHECK(second.actions[1].event.type == CerekaEvent::MouseWheel);
+    CHECK(second.actions[1].event.wheel == -3.f);
+
+    CHECK(log.frames.back().actions.empty() && log.frames.back().dt == 0.016f);
+}
+
+void TestRejectsCorrupt()
+{
+    save::Snapshot start;
+    const std::vector<std::byte> file = Record(start);
+
+    auto rejects = [](const std::vector<std::byte> &data) {
+        WriteAll(PATH, data);
+        CHECK_THROWS(replay::ReadInputLog(PATH));
+    };
+    auto patched = [&](auto &&edit) {
+        std::vector<std::byte> f = file;
+        replay::InputLogHeader h;
+        std::memcpy(&h, f.data(), sizeof(h));
+        edit(h);
+        std::memcpy(f.data(), &h, sizeof(h));
+        return f;
+    };
+
+    CHECK_THROWS(replay::ReadInputLog("does_not_exist.crki"));
+    const size_t headerSize = sizeof(replay::InputLogHeader);
+    rejects(std::vector<std::byte>(file.begin(), file.begin() + headerSize - 1));
+    rejects(std::vector<std::byte>(file.begin(), file.end() - 1));
+    rejects(patched([](replay::InputLogHeader &h) { h.magic[3] = 'R'; }));
+    rejects(patched([](replay::InputLogHeader &h) { h.version = 1; }));
+    rejects(patched([](replay::InputLogHeader &h) { h.snapshotSize++; }));
+    rejects(patched([](replay::InputLogHeader &h) { h.historyWords++; }));
+    rejects(patched([](replay::InputLogHeader &h) { h.rawSize--; }));
+
+    // Rejected before allocating for them.
+    rejects(patched([](replay::InputLogHeader &h) { h.rawSize = 0xffffffffu; }));
+    rejects(patched([](replay::InputLogHeader &h) { h.frameCount = 0xffffffffu; }));
+    rejects(patched([](replay::InputLogHeader &h) {
+        h.flags = 0;
+        h.rawSize = h.payloadSize + 1;
+    }));
+
+    // A record stream with an unknown record type.
+    replay::InputLogHeader h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    std::vector<std::byte> bad(file.begin(), file.end() - h.payloadSize);
+    const std::byte records[] = {std::byte{9}, std::byte{}, std::byte{}, std::byte{}, std::byte{}};
+    bad.insert(bad.end(), std::begin(records), std::end(records));
+    h.flags = 0;
+    h.frameCount = 1;
+    h.rawSize = h.payloadSize = sizeof(records);
+    std::memcpy(bad.data(), &h, sizeof(h));
+    rejects(bad);
+}
+
+}  // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestRejectsCorrupt();
+    std::remove(PATH.c_str());
+    return test::Result();
+}
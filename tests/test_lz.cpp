@@ -0,0 +1,125 @@
+#include "check.hpp"
+#include "lz.hpp"
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+std::vector<std::byte> Bytes(const char *s)
+{
+    std::vector<std::byte> out(std::strlen(s));
+    std::memcpy(out.data(), s, out.size());
+    return out;
+}
+
+bool RoundTrips(const std::vector<std::byte> &raw)
+{
+    const std::vector<std::byte> packed = io::Compress(raw.data(), raw.size());
+    if (raw.size() > io::MaxDecompressedSize(packed.size()))
+        return false;
+    std::vector<std::byte> out(raw.size());
+    io::Decompress(packed.data(), packed.size(), out.data(), out.size());
+    return out == raw;
+}
+
+void TestRoundTrip()
+{
+    std::mt19937 rng(1);
+
+    CHECK(RoundTrips({}));
+    for (size_t n = 1; n <= 40; ++n) {
+        std::vector<std::byte> raw(n);
+        for (auto &b : raw)
+            b = std::byte(rng() % 3);
+        CHECK(RoundTrips(raw));
+    }
+
+    CHECK(RoundTrips(Bytes("the cat sat on the mat; the cat sat on the hat")));
+
+    // Runs long enough for literal and match lengths to spill into extra bytes.
+    CHECK(RoundTrips(std::vector<std::byte>(100000, std::byte{7})));
+
+    std::vector<std::byte> noise(70000);
+    for (auto &b : noise)
+        b = std::byte(rng());
+    CHECK(RoundTrips(noise));
+
+    // Matches further back than the 16-bit offset window.
+    std::vector<std::byte> far = noise;
+    far.insert(far.end(), noise.begin(), noise.begin() + 1000);
+    CHECK(RoundTrips(far));
+}
+
+void TestMaxExpansion()
+{
+    // The best case for the codec is one long match; it must stay in bounds.
+    const std::vector<std::byte> zeros(size_t(1) << 20);
+    const std::vector<std::byte> packed = io::Compress(zeros.data(), zeros.size());
+    CHECK(zeros.size() <= io::MaxDecompressedSize(packed.size()));
+    CHECK(io::MaxDecompressedSize(SIZE_MAX) == SIZE_MAX);
+}
+
+void TestRejectsCorrupt()
+{
+    const std::vector<std::byte> raw = Bytes("abcabcabcabcabcabcabcabcabcabcabcabc");
+    const std::vector<std::byte> packed = io::Compress(raw.data(), raw.size());
+    std::vector<std::byte> out(raw.size() + 1);
+
+    // Wrong expected size, either way.
+    CHECK_THROWS(io::Decompress(packed.data(), packed.size(), out.data(), raw.size() - 1));
+    CHECK_THROWS(io::Decompress(packed.data(), packed.size(), out.data(), raw.size() + 1));
+
+    // Every truncation comes up short.
+    for (size_t n = 0; n < packed.size(); ++n)
+        CHECK_THROWS(io::Decompress(packed.data(), n, out.data(), raw.size()));
+
+    // One literal 'a', then a 4-byte match at offset 1 or 2.
+    const std::byte good[] = {std::byte{0x10}, std::byte{'a'}, std::byte{1}, std::byte{0}};
+    io::Decompress(good, sizeof(good), out.data(), 5);
+    CHECK(std::memcmp(out.data(), "aaaaa", 5) == 0);
+    const std::byte before[] = {std::byte{0x10}, std::byte{'a'}, std::byte{2}, std::byte{0}};
+    CHECK_THROWS(io::Decompress(before, sizeof(before), out.data(), 5));
+    const std::byte zero[] = {std::byte{0x10}, std::byte{'a'}, std::byte{0}, std::byte{0}};
+    CHECK_THROWS(io::Decompress(zero, sizeof(zero), out.data(), 5));
+
+    // A length continuation that never ends.
+    const std::byte endless[] = {std::byte{0xf0}, std::byte{255}, std::byte{255}};
+    CHECK_THROWS(io::Decompress(endless, sizeof(endless), out.data(), out.size()));
+}
+
+void TestMutations()
+{
+    // Damaged streams must decode or throw, never write out of bounds.
+    std::mt19937 rng(2);
+    std::vector<std::byte> raw(4096);
+    for (size_t i = 0; i < raw.size(); ++i)
+        raw[i] = std::byte(i % 97 < 50 ? i % 7 : rng() % 256);
+    const std::vector<std::byte> packed = io::Compress(raw.data(), raw.size());
+    std::vector<std::byte> out(raw.size());
+
+    for (int i = 0; i < 2000; ++i) {
+        std::vector<std::byte> damaged = packed;
+        for (int k = 0; k < 4; ++k)
+            damaged[rng() % damaged.size()] = std::byte(rng());
+        try {
+            io::Decompress(damaged.data(), damaged.size(), out.data(), out.size());
+        }
+        catch (const engine::error &) {
+        }
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestMaxExpansion();
+    TestRejectsCorrupt();
+    TestMutations();
+    return test::Result();
+}
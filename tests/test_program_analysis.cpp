@@ -0,0 +1,94 @@
+#include "check.hpp"
+#include "program_analysis.hpp"
+#include "script_parser.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace cereka;
+using scenario::Op;
+
+namespace {
+
+std::shared_ptr<const scenario::ProgramAnalysis> Analyze(const std::string &script)
+{
+    return scenario::ProgramAnalysis::Analyze(
+        scenario::Bytecode::Build(scenario::ParseVNScript(script)));
+}
+
+bool Has(const std::vector<scenario::AssetUse> &assets,
+         Op op,
+         std::string_view name)
+{
+    return std::find(assets.begin(), assets.end(), scenario::AssetUse{op, name}) != assets.end();
+}
+
+void TestValidProgram()
+{
+    const auto a = Analyze("menu\n"                         // 0
+                           "  bg title.png\n"               // 1
+                           "  button \"Start\" -> start\n"  // 2
+                           "  button \"Quit\" exit\n"       // 3
+                           "label start\n"                  // 4
+                           "bg street.png\n"                // 5
+                           "char alice\n"                   // 6
+                           "Alice: \"Hi.\"\n"               // 7
+                           "jump done\n"                    // 8
+                           "label orphan\n"                 // 9
+                           "bg never.png\n"                 // 10
+                           "label done\n"                   // 11
+                           "bgm end.ogg\n"                  // 12
+                           "end\n");                        // 13
+
+    CHECK(a->EntryPoint() == 0);
+    CHECK(a->Menus().size() == 1);
+    const scenario::MenuTable *menu = a->MenuAt(0);
+    CHECK(menu && !a->MenuAt(1));
+    if (menu) {
+        CHECK(menu->end == 4 && menu->background == "title.png");
+        CHECK(menu->buttons.size() == 2);
+        CHECK(menu->buttons[0].text == "Start" && menu->buttons[0].target == 4);
+        CHECK(menu->buttons[1].exit && menu->buttons[1].target == menu->end);
+    }
+
+    CHECK(a->IsReachable(5) && a->IsReachable(12) && !a->IsReachable(10));
+    CHECK(!a->IsReachable(14));
+    CHECK(a->BlockOf(1) == a->BlockOf(3));
+    CHECK(a->Warnings().size() == 1);
+    if (!a->Warnings().empty()) {
+        CHECK(a->Warnings()[0].find("unreachable") != std::string::npos);
+        CHECK(a->Warnings()[0].find("orphan") != std::string::npos);
+    }
+
+    CHECK(a->Assets().size() == 5);
+    const auto fromStart = a->ReachableAssets(0);
+    CHECK(Has(fromStart, Op::BG, "street.png") && Has(fromStart, Op::CHAR, "alice"));
+    CHECK(Has(fromStart, Op::BGM, "end.ogg") && !Has(fromStart, Op::BG, "never.png"));
+    const auto fromDone = a->ReachableAssets(11);
+    CHECK(fromDone.size() == 1 && Has(fromDone, Op::BGM, "end.ogg"));
+}
+
+void TestRejectsBrokenPrograms()
+{
+    CHECK_THROWS(Analyze("jump nowhere\n"));
+    CHECK_THROWS(Analyze("menu\n  button \"Go\" -> nowhere\n"));
+    CHECK_THROWS(Analyze("label a\nlabel a\nend\n"));
+    CHECK_THROWS(Analyze("menu\nend\n"));
+
+    std::vector<scenario::Instruction> program = scenario::ParseVNScript("end\n");
+    program[0].op = Op(200);
+    CHECK_THROWS(scenario::ProgramAnalysis::Analyze(scenario::Bytecode::Build(program)));
+
+    // Valid, if odd: nothing at all, and a loop with no way out.
+    CHECK(Analyze("")->Blocks().empty());
+    CHECK(Analyze("label a\nbg loop.png\njump a\n")->Warnings().empty());
+}
+
+}  // namespace
+
+int main()
+{
+    TestValidProgram();
+    TestRejectsBrokenPrograms();
+    return test::Result();
+}
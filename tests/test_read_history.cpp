@@ -0,0 +1,101 @@
+#include "check.hpp"
+#include "read_history.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+const std::string PATH = "test_read_history.crkr";
+
+void TestMarks()
+{
+    save::ReadHistory h;
+    h.Reset(130, 7);
+    CHECK(h.Count() == 0 && h.Words().size() == 3);
+    h.Mark(0);
+    h.Mark(64);
+    h.Mark(129);
+    h.Mark(129);
+    h.Mark(130);  // past the end: ignored
+    CHECK(h.Seen(0) && h.Seen(64) && h.Seen(129));
+    CHECK(!h.Seen(1) && !h.Seen(130) && !h.Seen(size_t(-1)));
+    CHECK(h.Count() == 3);
+
+    // Bits past the program and words past the history are dropped.
+    h.SetWords({~uint64_t(0), 0, ~uint64_t(0), ~uint64_t(0)});
+    CHECK(h.Count() == 64 + 2);
+    CHECK(!h.Seen(64) && h.Seen(128) && h.Seen(129));
+    h.SetWords({1});
+    CHECK(h.Count() == 1 && h.Seen(0));
+}
+
+void TestSaveLoad()
+{
+    save::ReadHistory h;
+    h.Reset(100, 7);
+    h.Mark(3);
+    h.Mark(99);
+    h.Save(PATH);
+
+    // Loading merges into what is already marked.
+    save::ReadHistory loaded;
+    loaded.Reset(100, 7);
+    loaded.Mark(50);
+    CHECK(loaded.Load(PATH));
+    CHECK(loaded.Seen(3) && loaded.Seen(50) && loaded.Seen(99) && loaded.Count() == 3);
+
+    // A different program, by hash or by size, keeps nothing.
+    save::ReadHistory other;
+    other.Reset(100, 8);
+    CHECK(!other.Load(PATH) && other.Count() == 0);
+    other.Reset(101, 7);
+    CHECK(!other.Load(PATH) && other.Count() == 0);
+
+    CHECK(!other.Load("does_not_exist.crkr"));
+}
+
+void TestRejectsCorrupt()
+{
+    save::ReadHistory h;
+    h.Reset(100, 7);
+    h.Mark(3);
+    h.Save(PATH);
+
+    std::ifstream in(PATH, std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    auto rejects = [](const std::vector<char> &data) {
+        std::ofstream(PATH, std::ios::binary | std::ios::trunc)
+            .write(data.data(), std::streamsize(data.size()));
+        save::ReadHistory fresh;
+        fresh.Reset(100, 7);
+        fresh.Mark(1);
+        CHECK(!fresh.Load(PATH));
+        CHECK(fresh.Count() == 1);
+    };
+
+    rejects(std::vector<char>(file.begin(), file.begin() + sizeof(save::ReadHistoryHeader) - 1));
+    rejects(std::vector<char>(file.begin(), file.end() - 1));
+    std::vector<char> badMagic = file;
+    badMagic[0] = 'X';
+    rejects(badMagic);
+    std::vector<char> badVersion = file;
+    badVersion[4]++;
+    rejects(badVersion);
+}
+
+}  // namespace
+
+int main()
+{
+    TestMarks();
+    TestSaveLoad();
+    TestRejectsCorrupt();
+    std::remove(PATH.c_str());
+    return test::Result();
+}
@@ -0,0 +1,110 @@
+#include "check.hpp"
+#include "script_parser.hpp"
+#include <string>
+#include <vector>
+
+using namespace cereka;
+using scenario::Op;
+
+namespace {
+
+bool Is(const scenario::Instruction &ins,
+        Op op,
+        const std::string &a = {},
+        const std::string &b = {})
+{
+    return ins.op == op && ins.a == a && ins.b == b;
+}
+
+// Where ParseVNScript() reports the first error, as "line:column", or "".
+std::string ErrorAt(const std::string &text)
+{
+    try {
+        scenario::ParseVNScript(text);
+    }
+    catch (const scenario::CompileError &e) {
+        return std::to_string(e.line) + ":" + std::to_string(e.column);
+    }
+    return {};
+}
+
+void TestGrammar()
+{
+    const std::vector<scenario::Instruction> p = scenario::ParseVNScript(
+        "\xEF\xBB\xBF"
+        "label start   # a comment\n"
+        "  bg street.png\n"
+        "char alice happy\n"
+        "show bob\n"
+        "hide alice\n"
+        "bgm rain.ogg\n"
+        "bgm\n"
+        "sfx door.wav\n"
+        "voice alice_001.ogg\n"
+        "Alice: \"Good \\\"morning\\\".\"\n"
+        "say \"Mysterious man\" \"Hm.\\n\\tYes\\\\no\"\n"
+        "\"Mysterious man\": \"Hm.\"\n"
+        "\"The street is quiet.\"\n"
+        "narrate \"Quiet.\"\n"
+        "\n"
+        "menu\n"
+        "  bg crossroads.png\n"
+        "  button \"Go left\" -> left\n"
+        "  button \"Quit\" exit\n"
+        "jump start\n"
+        "end\n");
+
+    CHECK(p.size() == 20);
+    if (p.size() != 20)
+        return;
+    CHECK(Is(p[0], Op::LABEL, "start"));
+    CHECK(Is(p[1], Op::BG, "street.png"));
+    CHECK(Is(p[2], Op::CHAR, "alice", "happy"));
+    CHECK(Is(p[3], Op::CHAR, "bob"));
+    CHECK(Is(p[4], Op::HIDE, "alice"));
+    CHECK(Is(p[5], Op::BGM, "rain.ogg"));
+    CHECK(Is(p[6], Op::BGM));
+    CHECK(Is(p[7], Op::SFX, "door.wav"));
+    CHECK(Is(p[8], Op::VOICE, "alice_001.ogg"));
+    CHECK(Is(p[9], Op::SAY, "Alice", "Good \"morning\"."));
+    CHECK(Is(p[10], Op::SAY, "Mysterious man", "Hm.\n\tYes\\no"));
+    CHECK(Is(p[11], Op::SAY, "Mysterious man", "Hm."));
+    CHECK(Is(p[12], Op::NARRATE, {}, "The street is quiet."));
+    CHECK(Is(p[13], Op::NARRATE, {}, "Quiet."));
+    CHECK(Is(p[14], Op::MENU));
+    CHECK(Is(p[15], Op::BG, "crossroads.png"));
+    CHECK(Is(p[16], Op::BUTTON, "Go left", "left") && !p[16].exit_button);
+    CHECK(Is(p[17], Op::BUTTON, "Quit") && p[17].exit_button);
+    CHECK(Is(p[18], Op::JUMP, "start"));
+    CHECK(Is(p[19], Op::END));
+
+    CHECK(scenario::ParseVNScript("").empty());
+    CHECK(scenario::ParseVNScript("# only a comment\n\n   \n").empty());
+    CHECK(scenario::ParseVNScript("end").size() == 1);  // no final newline
+}
+
+void TestErrors()
+{
+    CHECK(ErrorAt("label start\nfrobnicate\n") == "2:1");
+    CHECK(ErrorAt("bg\n") == "1:3");
+    CHECK(ErrorAt("hide\n") == "1:5");
+    CHECK(ErrorAt("hide alice bob\n") == "1:12");
+    CHECK(ErrorAt("say alice \"unterminated\n") == "1:11");
+    CHECK(ErrorAt("narrate \"bad \\q escape\"\n") != "");
+    CHECK(ErrorAt("button \"Stray\" -> x\n") == "1:1");
+    CHECK(ErrorAt("menu\nbutton \"A\" -> a -> b\n") == "2:17");
+    CHECK(ErrorAt("menu\nAlice: \"Hi.\"\nbutton \"A\" exit\n") == "3:1");
+    CHECK(ErrorAt("jump\n") != "");
+    CHECK(ErrorAt("end now\n") == "1:5");
+
+    CHECK_THROWS(scenario::ParseVNScriptFile("does_not_exist.vns"));
+}
+
+}  // namespace
+
+int main()
+{
+    TestGrammar();
+    TestErrors();
+    return test::Result();
+}
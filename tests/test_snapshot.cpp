@@ -0,0 +1,149 @@
+#include "check.hpp"
+#include "snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+save::Snapshot Sample()
+{
+    save::Snapshot s;
+    s.programHash = 0x0123456789abcdefull;
+    s.pc = 42;
+    s.menuEndPC = 50;
+    s.state = 2;
+    s.scriptFinished = true;
+    s.speaker = "alice";
+    s.name = "Alice";
+    s.text = std::string(300, 'x');  // long enough to be compressed
+    s.dialoguePage = 1;
+    s.revealed = 17;
+    s.background = "street.png";
+    s.characters = {"alice", "bob"};
+    s.music = "rain.ogg";
+    s.inMenu = true;
+    s.buttons = {{"Go left", 44, false}, {"Quit", 0, true}};
+    return s;
+}
+
+bool Same(const save::Snapshot &a,
+          const save::Snapshot &b)
+{
+    if (a.buttons.size() != b.buttons.size())
+        return false;
+    for (size_t i = 0; i < a.buttons.size(); ++i) {
+        if (a.buttons[i].text != b.buttons[i].text || a.buttons[i].target != b.buttons[i].target ||
+            a.buttons[i].exit != b.buttons[i].exit)
+        {
+            return false;
+        }
+    }
+    return a.programHash == b.programHash && a.pc == b.pc && a.menuEndPC == b.menuEndPC &&
+           a.state == b.state && a.scriptFinished == b.scriptFinished && a.speaker == b.speaker &&
+           a.name == b.name && a.text == b.text && a.dialoguePage == b.dialoguePage &&
+           a.revealed == b.revealed && a.background == b.background &&
+           a.characters == b.characters && a.music == b.music && a.inMenu == b.inMenu;
+}
+
+void TestRoundTrip()
+{
+    const save::Snapshot s = Sample();
+    std::vector<std::byte> raw;
+    save::Serialize(s, raw);
+    CHECK(Same(save::Deserialize(raw.data(), raw.size()), s));
+
+    save::Serialize(save::Snapshot{}, raw);
+    CHECK(Same(save::Deserialize(raw.data(), raw.size()), save::Snapshot{}));
+
+    save::Serialize(s, raw);
+    for (bool compress : {false, true}) {
+        const std::vector<std::byte> file = save::Pack(raw.data(), raw.size(), compress);
+        save::SnapshotHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        CHECK(bool(header.flags & save::SNAPSHOT_COMPRESSED) == compress);
+        CHECK(save::Unpack(file.data(), file.size()) == raw);
+    }
+
+    const std::string path = "test_snapshot.crks";
+    save::WriteSnapshot(path, s);
+    CHECK(Same(save::ReadSnapshot(path), s));
+    std::remove(path.c_str());
+}
+
+void TestRejectsCorruptState()
+{
+    std::vector<std::byte> raw;
+    save::Serialize(Sample(), raw);
+
+    for (size_t n = 0; n < raw.size(); ++n)
+        CHECK_THROWS(save::Deserialize(raw.data(), n));
+
+    std::vector<std::byte> trailing = raw;
+    trailing.push_back(std::byte{0});
+    CHECK_THROWS(save::Deserialize(trailing.data(), trailing.size()));
+
+    // A string length and an element count far beyond the data.
+    save::Snapshot s;
+    s.speaker = "a";
+    save::Serialize(s, raw);
+    std::vector<std::byte> longString = raw;
+    const uint32_t huge = 0xfffffff0u;
+    const size_t speakerAt = 8 + 4 + 4 + 1 + 1 + 1;
+    std::memcpy(longString.data() + speakerAt, &huge, sizeof(huge));
+    CHECK_THROWS(save::Deserialize(longString.data(), longString.size()));
+
+    save::Serialize(save::Snapshot{}, raw);
+    std::vector<std::byte> manyCharacters = raw;
+    const size_t charactersAt = speakerAt + 3 * 4 + 4 + 4 + 4;
+    std::memcpy(manyCharacters.data() + charactersAt, &huge, sizeof(huge));
+    CHECK_THROWS(save::Deserialize(manyCharacters.data(), manyCharacters.size()));
+}
+
+void TestRejectsCorruptFile()
+{
+    std::vector<std::byte> raw;
+    save::Serialize(Sample(), raw);
+    const std::vector<std::byte> file = save::Pack(raw.data(), raw.size(), true);
+
+    CHECK_THROWS(save::Unpack(file.data(), sizeof(save::SnapshotHeader) - 1));
+    CHECK_THROWS(save::Unpack(file.data(), file.size() - 1));
+
+    auto patched = [&](auto &&edit) {
+        std::vector<std::byte> f = file;
+        save::SnapshotHeader h;
+        std::memcpy(&h, f.data(), sizeof(h));
+        edit(h);
+        std::memcpy(f.data(), &h, sizeof(h));
+        return f;
+    };
+    const auto badMagic = patched([](save::SnapshotHeader &h) { h.magic[0] = 'X'; });
+    CHECK_THROWS(save::Unpack(badMagic.data(), badMagic.size()));
+    const auto badVersion = patched([](save::SnapshotHeader &h) { h.version++; });
+    CHECK_THROWS(save::Unpack(badVersion.data(), badVersion.size()));
+    const auto badPayload = patched([](save::SnapshotHeader &h) { h.payloadSize++; });
+    CHECK_THROWS(save::Unpack(badPayload.data(), badPayload.size()));
+    const auto shortRaw = patched([](save::SnapshotHeader &h) { h.rawSize--; });
+    CHECK_THROWS(save::Unpack(shortRaw.data(), shortRaw.size()));
+
+    // Rejected before allocating: more than the payload can expand to.
+    const auto hugeRaw = patched([](save::SnapshotHeader &h) { h.rawSize = 0xffffffffu; });
+    CHECK_THROWS(save::Unpack(hugeRaw.data(), hugeRaw.size()));
+    const auto unpacked = patched([](save::SnapshotHeader &h) {
+        h.flags = 0;
+        h.rawSize = h.payloadSize + 1;
+    });
+    CHECK_THROWS(save::Unpack(unpacked.data(), unpacked.size()));
+}
+
+}  // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestRejectsCorruptState();
+    TestRejectsCorruptFile();
+    return test::Result();
+}
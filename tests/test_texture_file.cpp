@@ -0,0 +1,125 @@
+#include "check.hpp"
+#include "texture_file.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+constexpr int W = 37;
+constexpr int H = 23;
+
+// Opaque, with a flat band so the compressed variant really compresses.
+SDL_Surface *Pattern()
+{
+    SDL_Surface *s = SDL_CreateSurface(W, H, SDL_PIXELFORMAT_RGBA32);
+    for (int y = 0; y < H; ++y) {
+        auto *row = static_cast<uint8_t *>(s->pixels) + y * s->pitch;
+        for (int x = 0; x < W; ++x) {
+            const bool flat = y < H / 2;
+            row[x * 4 + 0] = uint8_t(flat ? 10 : x * 7);
+            row[x * 4 + 1] = uint8_t(flat ? 20 : y * 11);
+            row[x * 4 + 2] = uint8_t(flat ? 30 : x ^ y);
+            row[x * 4 + 3] = 255;
+        }
+    }
+    return s;
+}
+
+bool SamePixels(SDL_Surface *a,
+                SDL_Surface *b)
+{
+    if (a->w != b->w || a->h != b->h || a->format != b->format)
+        return false;
+    for (int y = 0; y < a->h; ++y) {
+        if (std::memcmp(static_cast<const uint8_t *>(a->pixels) + y * a->pitch,
+                        static_cast<const uint8_t *>(b->pixels) + y * b->pitch,
+                        size_t(a->w) * 4) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestRoundTrip()
+{
+    SDL_Surface *source = Pattern();
+    for (uint32_t flags : {0u, uint32_t(assets::TEXTURE_COMPRESSED)}) {
+        const std::vector<std::byte> file =
+            assets::EncodeTextureFile(source, SDL_PIXELFORMAT_RGBA32, flags);
+        CHECK(assets::IsTextureFile(file));
+        const assets::TextureFileHeader *h = assets::ReadTextureHeader(file);
+        CHECK(h && h->width == W && h->height == H);
+        CHECK(h && (h->flags & assets::TEXTURE_COMPRESSED) == flags);
+
+        SDL_Surface *decoded = assets::DecodeTextureFile(file);
+        CHECK(decoded && SamePixels(source, decoded));
+        if (decoded)
+            SDL_DestroySurface(decoded);
+    }
+    SDL_DestroySurface(source);
+
+    const int tooWide = int(assets::TEXTURE_MAX_DIMENSION) + 1;
+    SDL_Surface *huge = SDL_CreateSurface(tooWide, 1, SDL_PIXELFORMAT_RGBA32);
+    CHECK_THROWS(assets::EncodeTextureFile(huge, SDL_PIXELFORMAT_RGBA32, 0));
+    SDL_DestroySurface(huge);
+}
+
+void TestRejectsCorrupt()
+{
+    SDL_Surface *source = Pattern();
+    const std::vector<std::byte> file =
+        assets::EncodeTextureFile(source, SDL_PIXELFORMAT_RGBA32, assets::TEXTURE_COMPRESSED);
+    SDL_DestroySurface(source);
+
+    auto rejected = [](const std::vector<std::byte> &data) {
+        return !assets::ReadTextureHeader(data) && !assets::DecodeTextureFile(data);
+    };
+    auto patched = [&](auto &&edit) {
+        std::vector<std::byte> f = file;
+        assets::TextureFileHeader h;
+        std::memcpy(&h, f.data(), sizeof(h));
+        edit(h);
+        std::memcpy(f.data(), &h, sizeof(h));
+        return f;
+    };
+    using Header = assets::TextureFileHeader;
+
+    CHECK(rejected(std::vector<std::byte>(file.begin(), file.begin() + sizeof(Header))));
+    CHECK(rejected(std::vector<std::byte>(file.begin(), file.end() - 1)));
+    CHECK(rejected(patched([](Header &h) { h.magic[0] = 'X'; })));
+    CHECK(rejected(patched([](Header &h) { h.version++; })));
+    CHECK(rejected(patched([](Header &h) { h.width = 0; })));
+    CHECK(rejected(patched([](Header &h) { h.pitch = h.width * 4 - 1; })));
+    CHECK(rejected(patched([](Header &h) { h.rawSize++; })));
+    CHECK(rejected(patched([](Header &h) { h.dataSize++; })));
+    CHECK(rejected(patched([](Header &h) { h.flags &= ~assets::TEXTURE_COMPRESSED; })));
+
+    // Sizes the file cannot back are rejected before anything is allocated.
+    CHECK(rejected(patched([](Header &h) {
+        h.width = h.height = assets::TEXTURE_MAX_DIMENSION + 1;
+        h.pitch = h.width * 4;
+        h.rawSize = uint64_t(h.height) * h.pitch;
+    })));
+    CHECK(rejected(patched([](Header &h) {
+        h.height = assets::TEXTURE_MAX_DIMENSION;
+        h.pitch = 0x10000000u;
+        h.rawSize = uint64_t(h.height) * h.pitch;
+    })));
+
+    // A well-formed header over a stream cut short.
+    const std::vector<std::byte> cut = patched([](Header &h) { h.dataSize--; });
+    CHECK(assets::ReadTextureHeader(cut));
+    CHECK(!assets::DecodeTextureFile(cut));
+}
+
+}  // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestRejectsCorrupt();
+    return test::Result();
+}
@@ -0,0 +1,576 @@
+// cereka_bench: headless end-to-end frame benchmark.
+//
+// Boots CerekaEngine on SDL's offscreen video driver with the software
+// renderer, runs named scenarios with synthetic input and prints one JSON
+// document with frame-time percentiles, heap allocations, texture uploads,
+// draw calls and texture switches per frame, and the mean time per Lua
+// resume (scripted scenarios) for each scenario, followed by the time to
+// load a 4K background as PNG versus as a pre-decoded .ctex (raw and
+// compressed). prescale_saved_mib is the texture memory saved by shrinking
+// images to their draw size on load. Audio runs on SDL's dummy driver;
+// voice_prefetch_hits counts voice lines that were decoded before their
+// line came up. redrawn_mpix_per_frame is the area recomposited per frame
+// (scene layers are cached and only dirty rectangles are redrawn).
+//
+//   cereka_bench [--frames N] [--scenario NAME]... [--assets DIR] [--out FILE]
+//
+// Paths in scripts are relative to the asset directory; missing background
+// and character images are generated as BMPs, and missing sounds as WAVs. Text is only drawn when
+// assets/fonts/Montserrat-Medium.ttf exists there.
+#include "Cereka/Cereka.hpp"
+#include "mapped_file.hpp"
+#include "texture_file.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace cereka;
+namespace fs = std::filesystem;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p,
+                     std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+struct Scenario {
+    const char *name;
+    std::vector<scenario::Instruction> program;
+    // Synthetic input for a frame; returns false when there is none.
+    std::function<bool(const CerekaEngine &, int frame, CerekaEvent &)> input;
+    // Lua source run through LoadScript() instead of `program`, if set.
+    const char *lua = nullptr;
+};
+
+scenario::Instruction Ins(scenario::Op op,
+                          std::string a = {},
+                          std::string b = {},
+                          bool exit = false)
+{
+    return {op, std::move(a), std::move(b), exit, {}};
+}
+
+bool KeyEvery(int frame,
+              int period,
+              CerekaEvent &e)
+{
+    if (frame % period != period - 1)
+        return false;
+    e = {CerekaEvent::KeyDown, ' '};
+    return true;
+}
+
+std::vector<Scenario> MakeScenarios()
+{
+    using scenario::Op;
+    std::vector<Scenario> out;
+
+    {
+        const std::string line =
+            "The rain had not stopped for three days, and the lanterns along the canal "
+            "flickered like they were trying to remember something important.";
+        std::vector<scenario::Instruction> p{Ins(Op::LABEL, "start"),
+                                             Ins(Op::BG, "bench_bg0.bmp")};
+        for (int i = 0; i < 50; ++i)
+            p.push_back(Ins(i % 2 ? Op::NARRATE : Op::SAY, "Alice", line));
+        p.push_back(Ins(Op::JUMP, "start"));
+        // Let each line fully type out before advancing.
+        out.push_back({"dialogue_typewriter", std::move(p), [](auto &, int f, auto &e) {
+                           return KeyEvery(f, 180, e);
+                       }});
+    }
+
+    {
+        std::vector<scenario::Instruction> p{Ins(Op::LABEL, "menu"), Ins(Op::MENU)};
+        p.push_back(Ins(Op::BG, "bench_bg1.bmp"));
+        for (int i = 0; i < 6; ++i)
+            p.push_back(Ins(Op::BUTTON, "Choice " + std::to_string(i), "picked"));
+        p.push_back(Ins(Op::LABEL, "picked"));
+        p.push_back(Ins(Op::NARRATE, "", "You picked something."));
+        p.push_back(Ins(Op::JUMP, "menu"));
+        out.push_back({"menu", std::move(p), [](const CerekaEngine &eng, int f, CerekaEvent &e) {
+                           // Buttons fire on release over the pressed button.
+                           if (f % 30 == 14 || f % 30 == 15) {
+                               e = {CerekaEvent::MouseUp, 0};
+                               if (f % 30 == 14)
+                                   e.type = CerekaEvent::MouseDown;
+                               e.mouseX = eng.Width() / 2.0f;
+                               e.mouseY = eng.Height() * 0.4f + 40;
+                               return true;
+                           }
+                           return KeyEvery(f, 30, e);
+                       }});
+    }
+
+    {
+        // A chapter select: hundreds of buttons, the pointer sweeping over
+        // them every frame and the wheel scrolling now and then. Frame cost
+        // should not depend on the number of entries.
+        std::vector<scenario::Instruction> p{Ins(Op::LABEL, "menu"), Ins(Op::MENU)};
+        for (int i = 0; i < 400; ++i)
+            p.push_back(Ins(Op::BUTTON, "Chapter " + std::to_string(i + 1), "menu"));
+        out.push_back({"chapter_select", std::move(p), [](auto &eng, int f, auto &e) {
+                           e = {CerekaEvent::MouseMove, 0};
+                           if (f % 60 == 59)
+                               e.type = CerekaEvent::MouseWheel;
+                           e.mouseX = float(f * 37 % std::max(1, eng.Width()));
+                           e.mouseY = float(f * 23 % std::max(1, eng.Height()));
+                           e.wheel = (f / 60) % 8 < 4 ? -1.f : 1.f;
+                           return true;
+                       }});
+    }
+
+    {
+        std::vector<scenario::Instruction> p{Ins(Op::LABEL, "loop")};
+        for (int i = 0; i < 8; ++i) {
+            p.push_back(Ins(Op::BG, "bench_bg" + std::to_string(i) + ".bmp"));
+            p.push_back(Ins(Op::CHAR, "bench_char" + std::to_string(i % 3)));
+            p.push_back(Ins(Op::SAY, "Bob", "Next."));
+        }
+        p.push_back(Ins(Op::JUMP, "loop"));
+        out.push_back({"rapid_bg_changes", std::move(p), [](auto &, int f, auto &e) {
+                           return KeyEvery(f, 2, e);
+                       }});
+    }
+
+    {
+        std::vector<scenario::Instruction> p{Ins(Op::LABEL, "start"),
+                                             Ins(Op::BG, "bench_bg2.bmp"),
+                                             Ins(Op::BGM, "bench_music.wav")};
+        for (int i = 0; i < 12; ++i) {
+            if (i % 4 == 0)
+                p.push_back(Ins(Op::SFX, "bench_click.wav"));
+            p.push_back(Ins(Op::VOICE, "bench_voice" + std::to_string(i) + ".wav"));
+            p.push_back(Ins(Op::SAY, "Alice", "Line " + std::to_string(i) + ", voiced."));
+        }
+        p.push_back(Ins(Op::JUMP, "start"));
+        out.push_back({"voiced_dialogue", std::move(p), [](auto &, int f, auto &e) {
+                           return KeyEvery(f, 20, e);
+                       }});
+    }
+
+    // Same shape as dialogue_typewriter but driven by the Lua runtime; the
+    // interesting number is script_resume_us, the cost of one line.
+    out.push_back({"lua_dialogue",
+                   {},
+                   [](auto &, int f, auto &e) { return KeyEvery(f, 2, e); },
+                   "bg('bench_bg0.bmp')\n"
+                   "show('bench_char0')\n"
+                   "local n = 0\n"
+                   "while true do\n"
+                   "  n = n + 1\n"
+                   "  say('Alice', 'Line ' .. n .. ' of a scripted conversation.')\n"
+                   "  if n % 10 == 0 then narrate('Time passes.') end\n"
+                   "end\n"});
+
+    return out;
+}
+
+void WriteImage(const fs::path &path,
+                int w,
+                int h,
+                Uint8 shade)
+{
+    if (fs::exists(path))
+        return;
+    fs::create_directories(path.parent_path());
+    SDL_Surface *s = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_XRGB8888);
+    if (!s)
+        return;
+    const Uint32 color = 0xff000000u | (Uint32(shade) << 16) | (Uint32(255 - shade) << 8);
+    SDL_FillSurfaceRect(s, nullptr, color);
+    SDL_SaveBMP(s, path.string().c_str());
+    SDL_DestroySurface(s);
+}
+
+// A 16-bit stereo PCM tone, `seconds` long.
+void WriteSound(const fs::path &path,
+                double seconds,
+                int pitch)
+{
+    if (fs::exists(path))
+        return;
+    fs::create_directories(path.parent_path());
+    const Uint32 rate = 44100, frames = Uint32(seconds * rate), dataSize = frames * 4;
+    std::vector<Uint8> wav(44 + dataSize);
+    auto put32 = [&](size_t at, Uint32 v) { SDL_memcpy(&wav[at], &v, 4); };
+    auto put16 = [&](size_t at, Uint16 v) { SDL_memcpy(&wav[at], &v, 2); };
+    SDL_memcpy(&wav[0], "RIFF", 4);
+    put32(4, 36 + dataSize);
+    SDL_memcpy(&wav[8], "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);  // PCM
+    put16(22, 2);
+    put32(24, rate);
+    put32(28, rate * 4);
+    put16(32, 4);
+    put16(34, 16);
+    SDL_memcpy(&wav[36], "data", 4);
+    put32(40, dataSize);
+    for (Uint32 i = 0; i < frames; ++i) {
+        // Square wave at a low level; only the decoding cost matters.
+        const Sint16 v = (i / (rate / pitch / 2)) % 2 ? 2000 : -2000;
+        put16(44 + i * 4, Uint16(v));
+        put16(44 + i * 4 + 2, Uint16(v));
+    }
+    SDL_SaveFile(path.string().c_str(), wav.data(), wav.size());
+}
+
+void GenerateAssets()
+{
+    WriteSound("assets/bgm/bench_music.wav", 30.0, 220);
+    WriteSound("assets/sfx/bench_click.wav", 0.2, 880);
+    for (int i = 0; i < 12; ++i)
+        WriteSound("assets/voice/bench_voice" + std::to_string(i) + ".wav", 3.0, 300 + i * 20);
+    for (int i = 0; i < 8; ++i)
+        WriteImage("assets/bg/bench_bg" + std::to_string(i) + ".bmp", 1920, 1080, Uint8(i * 30));
+    // The engine looks characters up as <id>_normal.jpg; SDL_image detects
+    // the real format from the file header, so a BMP works.
+    for (int i = 0; i < 3; ++i)
+        WriteImage("assets/characters/bench_char" + std::to_string(i) + "_normal.jpg",
+                   600,
+                   1000,
+                   Uint8(80 + i * 50));
+}
+
+struct LoadResult {
+    int images = 0;
+    int width = 3840, height = 2160;
+    double pngMs = 0, ctexMs = 0, ctexCompressedMs = 0;
+};
+
+// Time from file to texture: the IMG_LoadTexture path the engine used for
+// every image, against uploading pre-decoded .ctex files from a mapping.
+LoadResult BenchTextureLoad()
+{
+    using clock = std::chrono::steady_clock;
+    LoadResult r;
+    const int repeats = 3;
+
+    SDL_Surface *target = SDL_CreateSurface(16, 16, SDL_PIXELFORMAT_XRGB8888);
+    SDL_Renderer *renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        SDL_DestroySurface(target);
+        return r;
+    }
+
+    auto time = [&](auto &&load) {
+        auto t0 = clock::now();
+        SDL_Texture *tex = load();
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        SDL_DestroyTexture(tex);
+        return ms;
+    };
+    auto timeCtex = [&](const std::string &path) {
+        return time([&] {
+            io::MappedFile file;
+            if (!file.Open(path))
+                return static_cast<SDL_Texture *>(nullptr);
+            return assets::UploadTextureFile(renderer, {file.Data(), file.Size()});
+        });
+    };
+    auto writeCtex = [](SDL_Surface *image, uint32_t flags, const std::string &path) {
+        const std::vector<std::byte> ctex =
+            assets::EncodeTextureFile(image, SDL_PIXELFORMAT_XRGB8888, flags);
+        if (FILE *f = std::fopen(path.c_str(), "wb")) {
+            std::fwrite(ctex.data(), 1, ctex.size(), f);
+            std::fclose(f);
+        }
+    };
+
+    fs::create_directories("bench_load");
+    for (int i = 0; i < 2; ++i) {
+        const std::string png = "bench_load/bg" + std::to_string(i) + ".png";
+        if (!fs::exists(png)) {
+            // Smooth gradients with some texture, like a painted background.
+            SDL_Surface *s = SDL_CreateSurface(r.width, r.height, SDL_PIXELFORMAT_XRGB8888);
+            if (!s)
+                continue;
+            for (int y = 0; y < r.height; ++y) {
+                auto *row =
+                    reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(s->pixels) + y * s->pitch);
+                for (int x = 0; x < r.width; ++x)
+                    row[x] = (Uint32((x * 255 / r.width + i * 40) & 0xff) << 16) |
+                             (Uint32((y * 255 / r.height) & 0xff) << 8) |
+                             Uint32(((x ^ y) >> 2) & 0x3f);
+            }
+            IMG_SavePNG(s, png.c_str());
+            SDL_DestroySurface(s);
+        }
+
+        SDL_Surface *image = IMG_Load(png.c_str());
+        if (!image)
+            continue;
+        const std::string raw = "bench_load/bg" + std::to_string(i) + ".ctex";
+        const std::string compressed = "bench_load/bg" + std::to_string(i) + "_lz.ctex";
+        try {
+            writeCtex(image, 0, raw);
+            writeCtex(image, assets::TEXTURE_COMPRESSED, compressed);
+        }
+        catch (const engine::error &e) {
+            std::fprintf(stderr, "cereka_bench: %s\n", e.what());
+        }
+        SDL_DestroySurface(image);
+
+        for (int k = 0; k < repeats; ++k) {
+            r.pngMs += time([&] { return IMG_LoadTexture(renderer, png.c_str()); });
+            r.ctexMs += timeCtex(raw);
+            r.ctexCompressedMs += timeCtex(compressed);
+        }
+        r.images++;
+    }
+
+    if (r.images) {
+        const double n = r.images * repeats;
+        r.pngMs /= n;
+        r.ctexMs /= n;
+        r.ctexCompressedMs /= n;
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    return r;
+}
+
+double Percentile(std::vector<double> sorted,
+                  double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    std::sort(sorted.begin(), sorted.end());
+    size_t idx = size_t(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+struct Result {
+    std::string name;
+    int frames = 0;
+    double p50 = 0, p95 = 0, p99 = 0, mean = 0, max = 0;
+    double allocsPerFrame = 0;
+    double uploadsPerFrame = 0;
+    double drawCallsPerFrame = 0;
+    double textureSwitchesPerFrame = 0;
+    double scriptResumeUs = 0;
+    double prescaleSavedMiB = 0;
+    uint64_t glyphMisses = 0;
+    uint64_t voicePrefetchHits = 0;
+    uint64_t voicePrefetchMisses = 0;
+    double redrawnMpixPerFrame = 0;
+    uint64_t sceneRedraws = 0;
+};
+
+Result Run(CerekaEngine &engine,
+           const Scenario &sc,
+           int frames)
+{
+    using clock = std::chrono::steady_clock;
+    const float dt = 1.0f / 60.0f;
+
+    engine.Reset();
+    if (sc.lua) {
+        const char *path = "bench_script.lua";
+        if (FILE *f = std::fopen(path, "w")) {
+            std::fputs(sc.lua, f);
+            std::fclose(f);
+        }
+        engine.LoadScript(path);
+    }
+    else {
+        engine.LoadCompiledScript(sc.program);
+    }
+
+    const CerekaStats before = engine.Stats();
+    const uint64_t allocsBefore = g_allocations.load();
+    std::vector<double> times;
+    times.reserve(frames);
+
+    for (int f = 0; f < frames; ++f) {
+        auto t0 = clock::now();
+
+        CerekaEvent e;
+        while (engine.PollEvent(e)) {
+        }
+        if (sc.input(engine, f, e))
+            engine.HandleEvent(e);
+        engine.TickScript();
+        engine.Update(dt);
+        engine.Draw();
+        engine.Present();
+
+        times.push_back(std::chrono::duration<double, std::milli>(clock::now() - t0).count());
+    }
+
+    const CerekaStats after = engine.Stats();
+    Result r;
+    r.name = sc.name;
+    r.frames = frames;
+    r.p50 = Percentile(times, 0.50);
+    r.p95 = Percentile(times, 0.95);
+    r.p99 = Percentile(times, 0.99);
+    for (double t : times) {
+        r.mean += t;
+        r.max = std::max(r.max, t);
+    }
+    r.mean /= std::max(1, frames);
+    r.allocsPerFrame = double(g_allocations.load() - allocsBefore) / std::max(1, frames);
+    r.uploadsPerFrame = double(after.textureUploads - before.textureUploads) / std::max(1, frames);
+    r.drawCallsPerFrame = double(after.drawCalls - before.drawCalls) / std::max(1, frames);
+    r.textureSwitchesPerFrame =
+        double(after.textureSwitches - before.textureSwitches) / std::max(1, frames);
+    r.glyphMisses = after.glyphMisses - before.glyphMisses;
+    r.redrawnMpixPerFrame =
+        double(after.redrawnPixels - before.redrawnPixels) / 1e6 / std::max(1, frames);
+    r.sceneRedraws = after.sceneRedraws - before.sceneRedraws;
+    r.voicePrefetchHits = after.voicePrefetchHits - before.voicePrefetchHits;
+    r.voicePrefetchMisses = after.voicePrefetchMisses - before.voicePrefetchMisses;
+    r.prescaleSavedMiB =
+        (after.prescaleSavedBytes - before.prescaleSavedBytes) / (1024.0 * 1024.0);
+    if (after.scriptResumes > before.scriptResumes)
+        r.scriptResumeUs = (after.scriptResumeNs - before.scriptResumeNs) / 1000.0 /
+                           double(after.scriptResumes - before.scriptResumes);
+    return r;
+}
+
+}  // namespace
+
+int main(int argc,
+         char **argv)
+{
+    int frames = 600;
+    std::vector<std::string> only;
+    std::string assetsDir;
+    std::string outPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s: %s needs a value\n", argv[0], arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--frames")
+            frames = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--scenario")
+            only.push_back(next());
+        else if (arg == "--assets")
+            assetsDir = next();
+        else if (arg == "--out")
+            outPath = next();
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--frames N] [--scenario NAME]... [--assets DIR] "
+                         "[--out FILE]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    if (!assetsDir.empty()) {
+        fs::create_directories(assetsDir);
+        fs::current_path(assetsDir);
+    }
+
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+    SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
+    CerekaEngine engine;
+    try {
+        engine.InitGame("cereka_bench", 1280, 720, false);
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: init failed: %s\n", argv[0], e.what());
+        return 1;
+    }
+    GenerateAssets();
+
+    std::vector<Result> results;
+    for (const auto &sc : MakeScenarios()) {
+        if (!only.empty() && std::find(only.begin(), only.end(), sc.name) == only.end())
+            continue;
+        results.push_back(Run(engine, sc, frames));
+    }
+    engine.ShutDown();
+    const LoadResult load = BenchTextureLoad();
+
+    FILE *out = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "%s: cannot write '%s'\n", argv[0], outPath.c_str());
+        return 1;
+    }
+
+    std::fprintf(out, "{\n  \"frames\": %d,\n  \"scenarios\": [\n", frames);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"frames\": %d, "
+                     "\"frame_ms\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, "
+                     "\"mean\": %.4f, \"max\": %.4f}, "
+                     "\"allocs_per_frame\": %.2f, \"texture_uploads_per_frame\": %.4f, "
+                     "\"draw_calls_per_frame\": %.2f, \"texture_switches_per_frame\": %.2f, "
+                     "\"script_resume_us\": %.3f, \"prescale_saved_mib\": %.1f, "
+                     "\"redrawn_mpix_per_frame\": %.3f, \"scene_redraws\": %llu, "
+                     "\"glyph_misses\": %llu, \"voice_prefetch_hits\": %llu, "
+                     "\"voice_prefetch_misses\": %llu}%s\n",
+                     r.name.c_str(),
+                     r.frames,
+                     r.p50,
+                     r.p95,
+                     r.p99,
+                     r.mean,
+                     r.max,
+                     r.allocsPerFrame,
+                     r.uploadsPerFrame,
+                     r.drawCallsPerFrame,
+                     r.textureSwitchesPerFrame,
+                     r.scriptResumeUs,
+                     r.prescaleSavedMiB,
+                     r.redrawnMpixPerFrame,
+                     static_cast<unsigned long long>(r.sceneRedraws),
+                     static_cast<unsigned long long>(r.glyphMisses),
+                     static_cast<unsigned long long>(r.voicePrefetchHits),
+                     static_cast<unsigned long long>(r.voicePrefetchMisses),
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out,
+                 "  ],\n  \"texture_load\": {\"images\": %d, \"width\": %d, \"height\": %d, "
+                 "\"png_ms\": %.3f, \"ctex_ms\": %.3f, \"ctex_compressed_ms\": %.3f}\n}\n",
+                 load.images,
+                 load.width,
+                 load.height,
+                 load.pngMs,
+                 load.ctexMs,
+                 load.ctexCompressedMs);
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,124 @@
+// cereka_compile: compile a VN script offline into a .crkb bytecode image
+// that CerekaEngine::LoadBytecode() can map without running Lua. Uses the
+// native parser only; syntax errors are reported as file:line:column.
+//
+//   cereka_compile <script> <output.crkb>
+//   cereka_compile --project <manifest> <output.crkb> [--jobs N] [--cache DIR]
+//
+// Project builds compile every listed file in parallel and reuse cached
+// units for files whose contents have not changed. Both modes run the
+// engine's load-time checks (scenario::ProgramAnalysis) before writing, so
+// a script the engine would reject never reaches the output.
+#include "Cereka/exceptions.hpp"
+#include "bytecode.hpp"
+#include "program_analysis.hpp"
+#include "project_compiler.hpp"
+#include "script_parser.hpp"
+#include "vn_instruction.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace cereka;
+
+// Throws engine::error if the engine would refuse to load `program`; prints
+// the warnings otherwise.
+static void Validate(const char *tool,
+                     const std::vector<scenario::Instruction> &program)
+{
+    auto analysis = scenario::ProgramAnalysis::Analyze(scenario::Bytecode::Build(program));
+    for (const std::string &warning : analysis->Warnings())
+        std::fprintf(stderr, "%s: warning: %s\n", tool, warning.c_str());
+}
+
+static int CompileProject(int argc,
+                          char **argv)
+{
+    if (argc < 4) {
+        std::fprintf(stderr,
+                     "usage: %s --project <manifest> <output.crkb> [--jobs N] [--cache DIR]\n",
+                     argv[0]);
+        return 2;
+    }
+    size_t jobs = 0;
+    std::string cacheDir = ".cereka-cache/scripts";
+    for (int i = 4; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--jobs") == 0)
+            jobs = size_t(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (std::strcmp(argv[i], "--cache") == 0)
+            cacheDir = argv[i + 1];
+        else {
+            std::fprintf(stderr, "%s: unknown option '%s'\n", argv[0], argv[i]);
+            return 2;
+        }
+    }
+
+    try {
+        scenario::ProjectCompiler compiler(cacheDir, jobs);
+        const std::vector<scenario::Instruction> program = compiler.CompileManifest(argv[2]);
+        Validate(argv[0], program);
+        scenario::WriteBytecode(argv[3], program);
+        const scenario::ProjectStats &stats = compiler.Stats();
+        std::printf("%s: %zu files (%zu compiled, %zu cached), %zu instructions -> %s in "
+                    "%.1f ms\n",
+                    argv[0],
+                    stats.units,
+                    stats.compiled,
+                    stats.cacheHits,
+                    program.size(),
+                    argv[3],
+                    stats.buildNs / 1e6);
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc,
+         char **argv)
+{
+    if (argc >= 2 && std::strcmp(argv[1], "--project") == 0)
+        return CompileProject(argc, argv);
+
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <script> <output.crkb>\n", argv[0]);
+        std::fprintf(stderr,
+                     "       %s --project <manifest> <output.crkb> [--jobs N] [--cache DIR]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    std::vector<scenario::Instruction> program;
+    try {
+        program = scenario::ParseVNScriptFile(argv[1]);
+    }
+    catch (const scenario::CompileError &e) {
+        // file:line:column: message, for editors and build logs.
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+    if (program.empty()) {
+        std::fprintf(stderr, "%s: no instructions compiled from '%s'\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    try {
+        Validate(argv[0], program);
+        scenario::WriteBytecode(argv[2], program);
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+
+    std::printf("%s: %zu instructions -> %s\n", argv[0], program.size(), argv[2]);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// cereka_ctex: convert the images in an asset directory to pre-decoded .ctex
+// textures, mirroring the tree into a new asset root. Images keep their
+// names (the loader recognises .ctex by its header), so scripts need no
+// changes; other files are copied as they are. Feed the result to
+// cereka_pack or point CerekaEngine::SetAssetRoot() at it.
+//
+//   cereka_ctex <input-dir> <output-dir> [--format NAME] [--premultiply] [--compress]
+//               [--display WxH]
+//
+// --format is one of argb8888, abgr8888, rgba8888, xrgb8888; by default
+// opaque images are stored as XRGB8888 and the rest as ARGB8888, which is
+// what SDL's renderers use natively.
+//
+// --display shrinks backgrounds and characters to the size the engine draws
+// them at on a W x H window (in pixels), with the same resampler it uses at
+// load time. Build one asset root per target resolution this way to skip
+// resampling at runtime as well as decoding.
+#include "Cereka/exceptions.hpp"
+#include "resample.hpp"
+#include "texture_file.hpp"
+#include "thread_pool.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cereka;
+namespace fs = std::filesystem;
+
+static bool ParseFormat(const char *name,
+                        SDL_PixelFormat &out)
+{
+    static const struct {
+        const char *name;
+        SDL_PixelFormat format;
+    } formats[] = {
+        {"argb8888", SDL_PIXELFORMAT_ARGB8888},
+        {"abgr8888", SDL_PIXELFORMAT_ABGR8888},
+        {"rgba8888", SDL_PIXELFORMAT_RGBA8888},
+        {"xrgb8888", SDL_PIXELFORMAT_XRGB8888},
+    };
+    for (const auto &f : formats) {
+        if (std::strcmp(name, f.name) == 0) {
+            out = f.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc,
+         char **argv)
+{
+    SDL_PixelFormat format = SDL_PIXELFORMAT_UNKNOWN;
+    uint32_t flags = 0;
+    int displayWidth = 0, displayHeight = 0;
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--premultiply") == 0)
+            flags |= assets::TEXTURE_PREMULTIPLIED;
+        else if (std::strcmp(argv[i], "--compress") == 0)
+            flags |= assets::TEXTURE_COMPRESSED;
+        else if (std::strcmp(argv[i], "--display") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &displayWidth, &displayHeight) != 2 ||
+                displayWidth <= 0 || displayHeight <= 0)
+            {
+                std::fprintf(stderr, "%s: bad display size '%s'\n", argv[0], argv[i]);
+                return 2;
+            }
+        }
+        else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!ParseFormat(argv[++i], format)) {
+                std::fprintf(stderr, "%s: unknown format '%s'\n", argv[0], argv[i]);
+                return 2;
+            }
+        }
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.size() != 2) {
+        std::fprintf(stderr,
+                     "usage: %s <input-dir> <output-dir> [--format NAME] [--premultiply] "
+                     "[--compress] [--display WxH]\n",
+                     argv[0]);
+        return 2;
+    }
+    const fs::path input = paths[0];
+    const fs::path output = paths[1];
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(input, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file())
+            files.push_back(it->path().lexically_relative(input));
+    }
+    if (ec) {
+        std::fprintf(stderr,
+                     "%s: %s: %s\n",
+                     argv[0],
+                     input.string().c_str(),
+                     ec.message().c_str());
+        return 1;
+    }
+
+    std::atomic<size_t> converted{0}, copied{0};
+    std::mutex errorMutex;
+    int failures = 0;
+    {
+        threading::ThreadPool pool(std::thread::hardware_concurrency());
+        for (const fs::path &rel : files) {
+            pool.Submit([&, rel] {
+                const fs::path src = input / rel;
+                const fs::path dst = output / rel;
+                std::error_code dirError;
+                fs::create_directories(dst.parent_path(), dirError);
+
+                SDL_Surface *image = IMG_Load(src.string().c_str());
+                if (!image) {
+                    if (fs::copy_file(src, dst, fs::copy_options::overwrite_existing, dirError))
+                        copied++;
+                    return;
+                }
+
+                if (displayWidth > 0)
+                    image = render::PrescaleForDisplay(
+                        rel.generic_string(), image, displayWidth, displayHeight);
+
+                try {
+                    SDL_PixelFormat target = format;
+                    const bool alpha = SDL_ISPIXELFORMAT_ALPHA(image->format);
+                    if (target == SDL_PIXELFORMAT_UNKNOWN)
+                        target = alpha ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_XRGB8888;
+                    const std::vector<std::byte> ctex =
+                        assets::EncodeTextureFile(image, target, flags);
+                    std::ofstream f(dst, std::ios::binary | std::ios::trunc);
+                    f.write(reinterpret_cast<const char *>(ctex.data()),
+                            std::streamsize(ctex.size()));
+                    if (!f)
+                        throw engine::error("Failed to write '%s'", dst.string().c_str());
+                    converted++;
+                }
+                catch (const engine::error &e) {
+                    std::lock_guard lock(errorMutex);
+                    std::fprintf(stderr, "%s: %s: %s\n", argv[0], src.string().c_str(), e.what());
+                    failures++;
+                }
+                SDL_DestroySurface(image);
+            });
+        }
+        pool.Wait();
+    }
+
+    std::printf("%s: %zu images converted, %zu other files copied -> %s\n",
+                argv[0],
+                converted.load(),
+                copied.load(),
+                output.string().c_str());
+    return failures ? 1 : 0;
+}
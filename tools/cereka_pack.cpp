@@ -0,0 +1,49 @@
+// cereka_pack: pack an asset directory into a .crkp archive that
+// CerekaEngine::MountAssetPack() maps in place of loose files.
+//
+//   cereka_pack <directory> <output.crkp> [--jobs N]
+//
+// Files are copied into the archive on all cores by default. Asset names are
+// paths relative to <directory>, so pack the asset root ("assets") itself.
+#include "Cereka/exceptions.hpp"
+#include "asset_pack.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace cereka;
+
+int main(int argc,
+         char **argv)
+{
+    size_t jobs = std::thread::hardware_concurrency();
+    if (argc == 5 && std::strcmp(argv[3], "--jobs") == 0)
+        jobs = size_t(std::strtoul(argv[4], nullptr, 10));
+    else if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <directory> <output.crkp> [--jobs N]\n", argv[0]);
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    assets::PackStats stats;
+    try {
+        stats = assets::WritePack(argv[1], argv[2], jobs);
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+
+    std::printf("%s: %zu files, %.1f MiB -> %s in %.1f ms\n",
+                argv[0],
+                stats.files,
+                stats.bytes / (1024.0 * 1024.0),
+                argv[2],
+                ms);
+    return 0;
+}
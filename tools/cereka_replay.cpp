@@ -0,0 +1,265 @@
+// cereka_replay: replay an input recording (CerekaEngine::StartRecording())
+// against a compiled script and report the time every frame took.
+//
+//   cereka_replay <recording.crkr> <script.crkb> [--assets DIR] [--window]
+//                 [--out FILE] [--baseline FILE]
+//
+// Runs headless on SDL's offscreen video driver with the software renderer
+// and the dummy audio driver unless --window is given. The report is one
+// tab-separated line per frame:
+//
+//   frame  pc  dt_ms  frame_ms  draw_calls  texture_uploads  redrawn_kpix
+//
+// Everything but frame_ms is deterministic, so two reports for the same
+// recording line up frame by frame. --baseline reads the report of an
+// earlier build and prints, on stderr, both builds' percentiles, the first
+// frame where the script took a different path (if any) and the frames
+// that got slowest.
+#include "Cereka/Cereka.hpp"
+#include "Cereka/exceptions.hpp"
+#include "input_log.hpp"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cereka;
+
+namespace {
+
+struct FrameRow {
+    size_t frame = 0;
+    size_t pc = 0;
+    double dtMs = 0;
+    double frameMs = 0;
+};
+
+double Percentile(std::vector<double> values,
+                  double p)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    const size_t idx = size_t(p * (values.size() - 1) + 0.5);
+    return values[std::min(idx, values.size() - 1)];
+}
+
+void PrintSummary(const char *name,
+                  const std::vector<FrameRow> &rows)
+{
+    std::vector<double> times;
+    times.reserve(rows.size());
+    for (const FrameRow &r : rows)
+        times.push_back(r.frameMs);
+    std::fprintf(stderr,
+                 "%-9s %zu frames, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                 name,
+                 rows.size(),
+                 Percentile(times, 0.50),
+                 Percentile(times, 0.95),
+                 Percentile(times, 0.99),
+                 times.empty() ? 0.0 : *std::max_element(times.begin(), times.end()));
+}
+
+std::vector<FrameRow> ReadReport(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw engine::error("Could not open baseline '%s'", path.c_str());
+    std::vector<FrameRow> rows;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        FrameRow r;
+        if (fields >> r.frame >> r.pc >> r.dtMs >> r.frameMs)
+            rows.push_back(r);
+    }
+    return rows;
+}
+
+void Compare(const std::vector<FrameRow> &baseline,
+             const std::vector<FrameRow> &current)
+{
+    PrintSummary("baseline", baseline);
+    PrintSummary("this", current);
+
+    const size_t n = std::min(baseline.size(), current.size());
+    if (baseline.size() != current.size())
+        std::fprintf(stderr, "frame counts differ: %zu vs %zu\n", baseline.size(), current.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (baseline[i].pc != current[i].pc) {
+            std::fprintf(stderr,
+                         "script diverged at frame %zu (pc %zu vs %zu); "
+                         "later frames do not compare\n",
+                         current[i].frame,
+                         baseline[i].pc,
+                         current[i].pc);
+            break;
+        }
+    }
+
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i)
+        order[i] = i;
+    const size_t shown = std::min<size_t>(10, n);
+    std::partial_sort(order.begin(), order.begin() + shown, order.end(), [&](size_t a, size_t b) {
+        return current[a].frameMs - baseline[a].frameMs > current[b].frameMs - baseline[b].frameMs;
+    });
+    std::fprintf(stderr, "slowest frames against the baseline:\n");
+    for (size_t k = 0; k < shown; ++k) {
+        const size_t i = order[k];
+        std::fprintf(stderr,
+                     "  frame %6zu  pc %6zu  %8.3f -> %8.3f ms (%+.3f)\n",
+                     current[i].frame,
+                     current[i].pc,
+                     baseline[i].frameMs,
+                     current[i].frameMs,
+                     current[i].frameMs - baseline[i].frameMs);
+    }
+}
+
+}  // namespace
+
+int main(int argc,
+         char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr,
+                     "usage: %s <recording.crkr> <script.crkb> [--assets DIR] [--window] "
+                     "[--out FILE] [--baseline FILE]\n",
+                     argv[0]);
+        return 2;
+    }
+    const std::string recordingPath = argv[1];
+    const std::string scriptPath = argv[2];
+    std::string assetsDir;
+    std::string outPath;
+    std::string baselinePath;
+    bool window = false;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s: %s needs a value\n", argv[0], arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--assets")
+            assetsDir = next();
+        else if (arg == "--out")
+            outPath = next();
+        else if (arg == "--baseline")
+            baselinePath = next();
+        else if (arg == "--window")
+            window = true;
+        else {
+            std::fprintf(stderr, "%s: unknown option '%s'\n", argv[0], arg.c_str());
+            return 2;
+        }
+    }
+
+    int width = 0, height = 0;
+    size_t frameCount = 0;
+    std::vector<FrameRow> baseline;
+    try {
+        const replay::InputLog log = replay::ReadInputLog(recordingPath);
+        width = log.width;
+        height = log.height;
+        frameCount = log.frames.size();
+        if (!baselinePath.empty())
+            baseline = ReadReport(baselinePath);
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+
+    if (!window) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+    }
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+    CerekaEngine engine;
+    std::vector<FrameRow> rows;
+    rows.reserve(frameCount);
+    FILE *out = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "%s: cannot write '%s'\n", argv[0], outPath.c_str());
+        return 1;
+    }
+
+    try {
+        if (!assetsDir.empty())
+            engine.SetAssetRoot(assetsDir);
+        engine.InitGame("cereka_replay", width, height, false);
+        engine.LoadBytecode(scriptPath);
+        engine.StartReplay(recordingPath);
+
+        std::fprintf(out, "# cereka_replay %s %s, %zu frames at %dx%d\n",
+                     recordingPath.c_str(),
+                     scriptPath.c_str(),
+                     frameCount,
+                     width,
+                     height);
+        std::fprintf(out,
+                     "# frame\tpc\tdt_ms\tframe_ms\tdraw_calls\ttexture_uploads"
+                     "\tredrawn_kpix\n");
+
+        float dt = 0.f;
+        CerekaStats before = engine.Stats();
+        for (size_t frame = 0;; ++frame) {
+            const auto start = std::chrono::steady_clock::now();
+            if (!engine.ReplayFrame(dt))
+                break;
+            engine.TickScript();
+            engine.Update(dt);
+            if (engine.NeedsPresent()) {
+                engine.Draw();
+                engine.Present();
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+
+            const CerekaStats after = engine.Stats();
+            const FrameRow row{frame, engine.ProgramCounter(), dt * 1000.0, ms};
+            std::fprintf(out,
+                         "%zu\t%zu\t%.3f\t%.4f\t%llu\t%llu\t%.1f\n",
+                         row.frame,
+                         row.pc,
+                         row.dtMs,
+                         row.frameMs,
+                         (unsigned long long)(after.drawCalls - before.drawCalls),
+                         (unsigned long long)(after.textureUploads - before.textureUploads),
+                         (after.redrawnPixels - before.redrawnPixels) / 1000.0);
+            rows.push_back(row);
+            before = after;
+        }
+    }
+    catch (const engine::error &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        if (out != stdout)
+            std::fclose(out);
+        engine.ShutDown();
+        return 1;
+    }
+    if (out != stdout)
+        std::fclose(out);
+    engine.ShutDown();
+
+    if (!baseline.empty())
+        Compare(baseline, rows);
+    else
+        PrintSummary("replay", rows);
+    return 0;
+}